@@ -4,40 +4,65 @@
 
 #include <core/engine.h>
 #include <core/platform.h>
+#include <util/logger.h>
 
 #include <math.h>
 #include <SDL3/SDL.h>
 
+typedef struct game_t {
+    // Simulation state at the previous and the current tick; rendering blends
+    // between the two.
+    float prev_angle;
+    float angle;
+} game;
+
+static void game_event(engine_state *e, const engine_event *ev, void *user) {
+    (void)e;
+    (void)user;
+    if (ev->type == ENGINE_EVENT_QUIT)
+        LOG_INFO(LOG_CAT_PLATFORM, "Quit requested.\n");
+}
+
+static void game_update(engine_state *e, double dt, void *user) {
+    (void)e;
+    game *g = (game*)user;
+    g->prev_angle = g->angle;
+    g->angle += (float)dt;
+}
+
+static void game_render(engine_state *e, float alpha, void *user) {
+    game *g = (game*)user;
+    float angle = g->prev_angle + (g->angle - g->prev_angle) * alpha;
+    float x = 0.25f * cosf(angle);
+    float y = 0.25f * sinf(angle);
+
+    vertex v1 = {{ -0.25f + x,  0.25f + y }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }};
+    vertex v2 = {{    0.0f + x, -0.25f + y }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }};
+    vertex v3 = {{  0.25f + x,  0.25f + y }, { 0.0f, 0.5f, 0.5f }, { 0.0f, 0.0f }};
+
+    engine_draw_triangle(e, v1, v2, v3);
+}
+
 int main(void) {
     engine_state engine = {0};
-    engine_init(&engine, "[GAME] Game Engine", 800, 400);    
-    
-    while (engine.running) {
-        engine_event e;
-        while (engine.running && platform_poll_events(&e)) {
-            switch (e.type) {
-                case ENGINE_EVENT_QUIT:
-                    SDL_Log("[EVENT] Quit.\n");
-                    engine.running = false;
-                    break;
-                case ENGINE_EVENT_RESIZE:
-                    engine.vk.framebuffer_resized = true;
-                    break;
-                default:
-                    break;
-            }
-        }
-
-	engine_begin_frame(&engine);
-
-	vertex v1 = {{ -0.25f,  0.25f }, { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f }};
-	vertex v2 = {{   0.0f, -0.25f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f }}; 
-	vertex v3 = {{  0.25f,  0.25f }, { 0.0f, 0.5f, 0.5f }, { 0.0f, 0.0f }};
-
-	engine_draw_triangle(&engine, v1, v2, v3);	
-		
-	engine_do_render(&engine);
-    }
+    engine.tick_rate = 60;
+    engine.max_frame_rate = 240;
+    engine.profile_trace_path = "build/profile.json";
+    engine.pipeline_cache_path = "build/pipeline_cache.bin";
+#ifndef NDEBUG
+    engine.shader_dir = "shaders";
+    engine.shader_hot_reload = true;
+#endif // NDEBUG
+    engine_init(&engine, "[GAME] Game Engine", 800, 400);
+
+    game g = {0};
+    engine_app app = {
+        .user = &g,
+        .event = game_event,
+        .update = game_update,
+        .render = game_render
+    };
+    engine_run(&engine, &app);
 
     engine_quit(&engine);
 }
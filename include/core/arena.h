@@ -0,0 +1,62 @@
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <core/memory.h>
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Linear (bump) allocator over one fixed block. Allocations are never freed
+// individually; the arena is reset as a whole, or rewound to a scope taken
+// earlier. Running out of space is a sizing bug and exits.
+
+typedef struct arena_t {
+  uint8_t *base;
+  size_t capacity;
+  size_t offset;
+  size_t peak;
+} arena;
+
+// Saved arena position; ending the scope frees everything allocated since.
+typedef struct arena_scope_t {
+  arena *owner;
+  size_t offset;
+} arena_scope;
+
+// Per-thread scratch arena size, allocated on first use.
+#define ARENA_SCRATCH_SIZE (4 * 1024 * 1024)
+
+void arena_init(arena *a, size_t capacity, mem_tag tag);
+void arena_destroy(arena *a);
+
+// `align` must be a power of two.
+void *arena_alloc(arena *a, size_t size, size_t align);
+
+#define arena_alloc_array(a, type, count) \
+  ((type*)arena_alloc((a), sizeof(type) * (size_t)(count), alignof(type)))
+
+static inline void arena_reset(arena *a) {
+  a->offset = 0;
+}
+
+static inline arena_scope arena_scope_begin(arena *a) {
+  return (arena_scope) { a, a->offset };
+}
+
+static inline void arena_scope_end(arena_scope scope) {
+  scope.owner->offset = scope.offset;
+}
+
+// Starts a scope on the calling thread's scratch arena, for temporaries that
+// die before the function returns. Scopes nest; end them in reverse order.
+// Do not keep one open across job_wait, which may resume on another thread.
+arena_scope arena_scratch_begin(void);
+
+HEADER_END
+
+#endif // ARENA_H_
@@ -0,0 +1,79 @@
+#ifndef ASYNC_IO_H_
+#define ASYNC_IO_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <core/job.h>
+
+// Asynchronous file reads. Callers queue batches of requests and carry on;
+// each request completes by running its callback as a job and/or signalling
+// its job counter, so loading code can job_wait on a whole batch.
+//
+// On Linux the service drives an io_uring from one thread, keeping up to
+// ASYNC_IO_QUEUE_DEPTH reads in flight so the device sees a deep queue
+// instead of one read at a time. Where io_uring is missing or refused (older
+// kernels, sandboxes that filter the syscalls) and on other platforms,
+// ASYNC_IO_FALLBACK_THREADS threads do blocking reads instead. Callers see no
+// difference apart from throughput.
+
+#define ASYNC_IO_QUEUE_DEPTH 64
+#define ASYNC_IO_FALLBACK_THREADS 4
+
+typedef struct io_request_t io_request;
+
+// Runs as a job once the read is done, whether it succeeded or not.
+typedef void (*io_callback)(io_request *req, void *user);
+
+struct io_request_t {
+  // Set by the caller. The request and `path` must stay valid until it
+  // completes.
+  const char *path;
+  uint64_t offset;
+  // Bytes to read; zero reads from `offset` to the end of the file.
+  size_t size;
+  // Where the bytes go. When NULL a buffer of the right size is allocated
+  // (MEM_TAG_ASSETS) and left here for the caller to mem_free.
+  void *buffer;
+  // Both optional. The counter is signalled after the callback has returned.
+  io_callback callback;
+  void *user;
+  job_counter *counter;
+
+  // Set on completion. A read that reaches the end of the file early is not
+  // an error; `bytes_read` is just short. On error `error` holds the errno
+  // value and a buffer the service allocated has been freed again.
+  size_t bytes_read;
+  int error;
+
+  io_request *__next;
+};
+
+typedef enum async_io_backend_t {
+  // Not started: async_io_read reads synchronously on the calling thread.
+  ASYNC_IO_BACKEND_NONE,
+  ASYNC_IO_BACKEND_URING,
+  ASYNC_IO_BACKEND_THREADS,
+} async_io_backend;
+
+// Starts the service. Call after job_system_init; callbacks run as jobs.
+void async_io_init(void);
+
+// Completes everything still queued, then stops the service. Reads must not
+// be submitted concurrently with shutdown.
+void async_io_shutdown(void);
+
+async_io_backend async_io_get_backend(void);
+
+// Queues `count` reads, adding one to each request's counter up front.
+// Requests are started in order but may complete in any order.
+void async_io_read(io_request *requests, uint32_t count);
+
+HEADER_END
+
+#endif // ASYNC_IO_H_
@@ -5,7 +5,10 @@
 
 HEADER_BEGIN
 
+#include <core/platform.h>
+#include <renderer/render_thread.h>
 #include <renderer/vertex.h>
+#include <util/timing.h>
 
 // #ifndef __VK_BACKEND
 // #error No appropriate backend defined. Make sure to define __VK_BACKEND before including engine.h
@@ -13,16 +16,93 @@ HEADER_BEGIN
 
 #ifdef __VK_BACKEND
 #include <vk/context.h>
+#include <vk/shader_reload.h>
 #endif // __VK_BACKEND
 
+#define ENGINE_DEFAULT_TICK_RATE 60
+// Longest stretch of real time a single frame may account for. Anything
+// beyond it is dropped so a slow frame cannot snowball into ever more
+// catch-up ticks.
+#define ENGINE_MAX_FRAME_TIME 0.25
+// Time from engine_init to the first submitted frame we aim to stay under; a
+// warning with the startup breakdown is logged when it is exceeded.
+#define ENGINE_STARTUP_TARGET_MS 300.0
+// Shader program used when engine_state.shader_name is not set.
+#define ENGINE_DEFAULT_SHADER "tri"
+#define ENGINE_SHADER_NAME_MAX 64
+
+typedef struct engine_state_t engine_state;
+
+// Callbacks driven by engine_run. `update` advances the simulation by exactly
+// `dt` seconds. `render` is called once per frame between engine_begin_frame
+// and engine_do_render; `alpha` in [0, 1) is how far real time has moved past
+// the last tick towards the next one, for interpolating between the previous
+// and current simulation state. `event` is optional and sees every event after
+// the engine has handled it.
+typedef struct engine_app_t {
+  void *user;
+  void (*event)(engine_state *e, const engine_event *ev, void *user);
+  void (*update)(engine_state *e, double dt, void *user);
+  void (*render)(engine_state *e, float alpha, void *user);
+} engine_app;
+
 typedef struct engine_state_t {
 #ifdef __VK_BACKEND
   vk_context vk;
 #endif // __VK_BACKEND
 
-  vertex *vertex_map;
+  // Format the vertex stream is uploaded in. Set before engine_init; the
+  // zero value is the full-precision VERTEX_FORMAT_F32.
+  vertex_format vertex_format;
+  uint8_t *vertex_map;
   uint32_t vertex_count;
-  
+
+  // Job system threads started by engine_init in addition to the main
+  // thread. Zero means one thread per logical core in total.
+  uint32_t job_worker_count;
+
+  // Record and present frames on a separate thread. Set before engine_init.
+  // Draw calls then go into a frame packet instead of the GPU buffer, and
+  // engine_do_render hands the packet off instead of drawing it.
+  bool threaded_render;
+  render_thread render;
+
+  // engine_run timing. Simulation ticks at `tick_rate` Hz (0 means
+  // ENGINE_DEFAULT_TICK_RATE); frames are presented as fast as the swapchain
+  // allows, or at most `max_frame_rate` per second when non-zero.
+  uint32_t tick_rate;
+  uint32_t max_frame_rate;
+  uint64_t tick_count;
+
+  // When set, engine_quit writes the recorded profiler zones there as Chrome
+  // trace JSON. Only has an effect in ENGINE_PROFILE builds.
+  const char *profile_trace_path;
+
+  // Where compiled pipelines are cached between runs. NULL keeps the cache in
+  // memory only.
+  const char *pipeline_cache_path;
+
+  // Directory whose .spv files are used instead of the shaders embedded in
+  // the engine, for iterating on them without a rebuild. NULL uses only the
+  // embedded ones and does no shader file I/O.
+  const char *shader_dir;
+
+  // Shader program triangles are drawn with: stages `<name>-vert` and
+  // `<name>-frag`, built from `<name>.hlsl` when hot reloading. Set before
+  // engine_init; NULL means ENGINE_DEFAULT_SHADER.
+  const char *shader_name;
+
+#ifdef __VK_BACKEND
+  // Rebuild pipelines when their shaders in shader_dir change. Set before
+  // engine_init; meant for development builds.
+  bool shader_hot_reload;
+  shader_reload shader_reload;
+#endif // __VK_BACKEND
+
+  // Startup steps, from engine_init to the first engine_do_render.
+  timing_report startup;
+  bool first_frame_done;
+
   bool running;
 } engine_state;
 
@@ -35,6 +115,13 @@ void engine_draw_triangle(engine_state *e, vertex v1, vertex v2, vertex v3);
 
 void engine_do_render(engine_state *e);
 
+// Logs heap usage per subsystem and the GPU memory held by VMA.
+void engine_log_memory_stats(engine_state *e);
+
+// Polls events, runs fixed-timestep updates and renders until e->running is
+// cleared (by a quit event or by a callback).
+void engine_run(engine_state *e, const engine_app *app);
+
 [[noreturn]] void engine_quit(engine_state *e);
 
 HEADER_END
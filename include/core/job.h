@@ -0,0 +1,88 @@
+#ifndef JOB_H_
+#define JOB_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL3/SDL_atomic.h>
+
+// Work-stealing job system. Every worker thread (plus the thread that called
+// job_system_init, which is worker 0) owns a Chase-Lev deque: it pushes and
+// pops its own jobs at the bottom while idle workers steal from the top.
+// Threads that are not workers submit through a shared injection queue.
+//
+// Completion is tracked with counters: job_run adds the number of submitted
+// jobs to a counter and each finished job decrements it, so a counter reaching
+// zero means "everything submitted against me is done". Dependencies are
+// expressed by waiting on a counter before submitting (or from inside) the
+// dependent work.
+//
+// On Linux (x86-64 and aarch64) workers run jobs on pooled fibers. A job that
+// calls job_wait parks its fiber on the counter and the worker moves on to
+// other work; whichever job brings the counter to zero makes the fiber ready
+// again, and any worker may resume it. Deep dependency chains therefore
+// neither pile up on one stack nor tie up threads. The thread that called
+// job_system_init, threads outside the job system, and platforms without
+// fibers run other jobs inside job_wait instead.
+
+typedef void (*job_fn)(void *data);
+
+typedef struct job_decl_t {
+  job_fn fn;
+  void *data;
+} job_decl;
+
+typedef struct job_counter_t {
+  SDL_AtomicInt value;
+} job_counter;
+
+// Called with the half-open range [begin, end).
+typedef void (*job_range_fn)(void *data, uint32_t begin, uint32_t end);
+
+// Starts `worker_count` threads in addition to the calling thread. Zero means
+// one per logical core, counting the calling thread.
+void job_system_init(uint32_t worker_count);
+
+// Runs anything still queued, then stops the workers. Jobs must not be
+// submitted concurrently with shutdown.
+void job_system_shutdown(void);
+
+// Number of threads executing jobs, including the one that called
+// job_system_init.
+uint32_t job_thread_count(void);
+
+// Index of the calling thread in [0, job_thread_count()), or -1 when it is
+// not part of the job system.
+int32_t job_thread_index(void);
+
+// Queues `count` jobs. `counter` may be NULL for fire-and-forget work.
+void job_run(const job_decl *jobs, uint32_t count, job_counter *counter);
+
+// Returns once `counter` drops to zero. Parks the calling fiber when there is
+// one, otherwise runs queued jobs on the calling thread meanwhile. A job may
+// come back from job_wait on a different thread than it entered on.
+void job_wait(job_counter *counter);
+
+// For work that is not a job, such as a read finishing on an I/O thread:
+// job_counter_add reserves `count` completions up front and each piece of
+// work calls job_counter_signal once when it is done, exactly as a job
+// submitted against the counter would. Both are safe from any thread.
+void job_counter_add(job_counter *counter, uint32_t count);
+void job_counter_signal(job_counter *counter);
+
+static inline bool job_counter_done(job_counter *counter) {
+  return SDL_GetAtomicInt(&counter->value) == 0;
+}
+
+// Calls fn over [0, count) split into ranges of `grain` items (0 picks a
+// grain that gives each thread a few ranges), and returns once all of them
+// are done. The calling thread takes part.
+void job_parallel_for(uint32_t count, uint32_t grain, job_range_fn fn, void *data);
+
+HEADER_END
+
+#endif // JOB_H_
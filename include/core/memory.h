@@ -0,0 +1,49 @@
+#ifndef MEMORY_H_
+#define MEMORY_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Engine heap allocations go through here so they can be accounted to the
+// subsystem that made them. Every block carries a small header recording its
+// size and tag; statistics are kept with atomics and are safe to read from any
+// thread. Blocks must be released with mem_free, never free().
+
+typedef enum mem_tag_t {
+  MEM_TAG_CORE,     // Job system, pools, arenas' backing, misc.
+  MEM_TAG_RENDERER,
+  MEM_TAG_ASSETS,
+  MEM_TAG_PLATFORM,
+  MEM_TAG_COUNT
+} mem_tag;
+
+typedef struct mem_stats_t {
+  size_t live_bytes;
+  size_t peak_bytes;
+  uint64_t live_count;
+  uint64_t total_count; // Allocations ever made.
+} mem_stats;
+
+// All return NULL on failure, like the libc functions they wrap.
+void *mem_alloc(size_t size, mem_tag tag);
+void *mem_calloc(size_t count, size_t size, mem_tag tag);
+// `align` must be a power of two.
+void *mem_aligned_alloc(size_t align, size_t size, mem_tag tag);
+// Keeps the block's original tag. Like realloc, NULL `ptr` allocates and the
+// old block survives a failure.
+void *mem_realloc(void *ptr, size_t size, mem_tag tag);
+void mem_free(void *ptr);
+
+mem_stats mem_get_stats(mem_tag tag);
+const char *mem_tag_name(mem_tag tag);
+
+// Logs one line per tag plus a total.
+void mem_log_stats(void);
+
+HEADER_END
+
+#endif // MEMORY_H_
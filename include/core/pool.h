@@ -0,0 +1,87 @@
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <core/memory.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity object pool addressed by 32-bit generational handles. Items
+// live in one array; freed slots are chained into a free list and reused.
+// A handle is the slot index in the low 16 bits and the slot's generation in
+// the high 16. Freeing a slot bumps its generation, so a handle kept past
+// remove no longer resolves instead of aliasing whatever reuses the slot.
+// Generations start at 1, which keeps 0 free to mean "no handle".
+
+#define POOL_MAX_CAPACITY 0xFFFF
+#define POOL_INDEX_BITS 16
+#define POOL_INDEX_MASK 0xFFFFu
+#define POOL_NULL_HANDLE 0u
+
+typedef struct pool_t {
+  uint8_t *items;
+  uint16_t *generations;
+  uint16_t *next_free; // Valid for free slots only.
+  bool *alive;
+  uint32_t item_size;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t free_head;  // POOL_MAX_CAPACITY when no slot is free.
+} pool;
+
+void pool_init(pool *p, uint32_t item_size, uint32_t capacity, mem_tag tag);
+void pool_destroy(pool *p);
+
+// Copies `item` (or zeroes the slot when NULL) into a free slot. Returns
+// POOL_NULL_HANDLE when the pool is full.
+uint32_t pool_add(pool *p, const void *item);
+
+// NULL if the handle is null, out of range, or stale.
+void *pool_get(const pool *p, uint32_t handle);
+
+// Returns false (and does nothing) for handles that no longer resolve.
+bool pool_remove(pool *p, uint32_t handle);
+
+static inline uint32_t pool_handle_index(uint32_t handle) {
+  return handle & POOL_INDEX_MASK;
+}
+
+// Handle for the live item in slot `index`, or POOL_NULL_HANDLE. Together
+// with `capacity` this is how a pool is iterated:
+//   for (uint32_t i = 0; i < p.capacity; ++i) {
+//     uint32_t h = pool_handle_at(&p, i);
+//     if (h != POOL_NULL_HANDLE) ...
+//   }
+static inline uint32_t pool_handle_at(const pool *p, uint32_t index) {
+  if (index >= p->capacity || !p->alive[index]) return POOL_NULL_HANDLE;
+  return ((uint32_t)p->generations[index] << POOL_INDEX_BITS) | index;
+}
+
+// Declares a handle type `name##_handle` that can only be used with the
+// `name##_pool_*` accessors for `type`, so handles of different resource
+// kinds cannot be mixed up.
+#define POOL_DEFINE(name, type)                                                  \
+  typedef struct name##_handle_t { uint32_t id; } name##_handle;                 \
+                                                                                 \
+  static inline void name##_pool_init(pool *p, uint32_t capacity, mem_tag tag) { \
+    pool_init(p, sizeof(type), capacity, tag);                                   \
+  }                                                                              \
+  static inline name##_handle name##_pool_add(pool *p, const type *item) {       \
+    name##_handle h = { pool_add(p, item) };                                     \
+    return h;                                                                    \
+  }                                                                              \
+  static inline type *name##_pool_get(const pool *p, name##_handle h) {          \
+    return (type*)pool_get(p, h.id);                                             \
+  }                                                                              \
+  static inline bool name##_pool_remove(pool *p, name##_handle h) {              \
+    return pool_remove(p, h.id);                                                 \
+  }
+
+HEADER_END
+
+#endif // POOL_H_
@@ -11,6 +11,11 @@ typedef struct window_t {
     SDL_Window *window;
 } window;
 
+// Initializes the SDL video subsystem (and, for Vulkan, loads the loader) so
+// that graphics API setup can start before the window exists. Called by
+// window_init when needed.
+void window_init_video(void);
+
 void window_init(window *w, const char *title, int width, int height);
 
 void window_shutdown(window *w);
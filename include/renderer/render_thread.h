@@ -0,0 +1,67 @@
+#ifndef RENDER_THREAD_H_
+#define RENDER_THREAD_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+
+#ifdef __VK_BACKEND
+#include <vk/context.h>
+#endif // __VK_BACKEND
+
+// Everything the render thread needs to draw one frame. The game thread fills
+// a packet between render_thread_begin_packet and render_thread_submit; after
+// that it belongs to the render thread and must not be touched.
+typedef struct frame_packet_t {
+  uint8_t *vertices; // MAX_VERTICES in the packet's vertex format
+  uint32_t vertex_count;
+} frame_packet;
+
+// Records and presents frames on a dedicated thread so the game thread can
+// build frame N+1 while frame N is being submitted. Two packets alternate
+// between the threads; the game thread only blocks when it gets a full frame
+// ahead.
+typedef struct render_thread_t {
+  SDL_Thread *thread;
+  SDL_AtomicInt running;
+
+  frame_packet packets[2];
+  uint32_t write_index;
+  uint32_t read_index;
+  bool writing; // The game thread holds packets[write_index].
+  // Counts packets the game thread may fill / the render thread may draw.
+  SDL_Semaphore *packet_free;
+  SDL_Semaphore *packet_ready;
+
+#ifdef __VK_BACKEND
+  vk_context *vk;
+#endif // __VK_BACKEND
+  uint8_t *gpu_vertices;
+  uint32_t stride;
+} render_thread;
+
+#ifdef __VK_BACKEND
+// `gpu_vertices` is the mapped vertex buffer packets are copied into right
+// before drawing, `stride` the size of one encoded vertex.
+void render_thread_start(render_thread *rt, vk_context *vk, uint8_t *gpu_vertices, uint32_t stride);
+#endif // __VK_BACKEND
+
+// Waits until a packet is free and returns it emptied.
+frame_packet *render_thread_begin_packet(render_thread *rt);
+
+// Hands the packet returned by render_thread_begin_packet to the render thread.
+void render_thread_submit(render_thread *rt);
+
+// Draws whatever was already submitted, then joins the thread.
+void render_thread_stop(render_thread *rt);
+
+HEADER_END
+
+#endif // RENDER_THREAD_H_
@@ -5,6 +5,8 @@
 
 HEADER_BEGIN
 
+#include <stdint.h>
+
 #include <math/math_types.h>
 
 typedef struct vertex_t {
@@ -13,6 +15,63 @@ typedef struct vertex_t {
   vec2 uv;
 } vertex;
 
+// Packed vertex formats. These are what actually gets written into the GPU
+// vertex buffer; `vertex` stays the format the engine API is written in, and
+// is converted on the way in by vertex_encode.
+
+typedef enum vertex_format_t {
+  VERTEX_FORMAT_F32,     // vertex         - 32 bytes, full precision
+  VERTEX_FORMAT_HALF,    // vertex_half    - 16 bytes, half-float positions
+  VERTEX_FORMAT_SNORM16, // vertex_snorm16 - 16 bytes, positions must be in [-1, 1]
+  VERTEX_FORMAT_COUNT
+} vertex_format;
+
+typedef struct vertex_half_t {
+  uint16_t pos[4];  // xyz + padding, IEEE 754 binary16
+  uint8_t color[4]; // rgba8 unorm
+  uint16_t uv[2];   // unorm16
+} vertex_half;
+
+typedef struct vertex_snorm16_t {
+  int16_t pos[4];   // xyz + padding, snorm16
+  uint8_t color[4]; // rgba8 unorm
+  uint16_t uv[2];   // unorm16
+} vertex_snorm16;
+
+// Backend-agnostic description of a vertex format. The renderer backend maps
+// these to its own attribute formats when building pipelines.
+
+typedef enum vertex_attr_format_t {
+  VERTEX_ATTR_FLOAT2,
+  VERTEX_ATTR_FLOAT3,
+  VERTEX_ATTR_HALF4,
+  VERTEX_ATTR_SNORM16X4,
+  VERTEX_ATTR_UNORM16X2,
+  VERTEX_ATTR_UNORM8X4
+} vertex_attr_format;
+
+typedef struct vertex_attr_t {
+  uint32_t location;
+  vertex_attr_format format;
+  uint32_t offset;
+} vertex_attr;
+
+#define VERTEX_MAX_ATTRIBUTES 8
+
+typedef struct vertex_layout_t {
+  uint32_t stride;
+  uint32_t attribute_count;
+  vertex_attr attributes[VERTEX_MAX_ATTRIBUTES];
+} vertex_layout;
+
+const vertex_layout *vertex_get_layout(vertex_format format);
+
+// Converts `count` vertices into `format`, writing them tightly packed
+// (at the layout's stride) to `dst`.
+void vertex_encode(vertex_format format, const vertex *src, void *dst, uint32_t count);
+
+uint16_t vertex_float_to_half(float f);
+
 HEADER_END
 
 #endif // VERTEX_H_
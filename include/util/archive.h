@@ -0,0 +1,103 @@
+#ifndef ARCHIVE_H_
+#define ARCHIVE_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <util/file_io.h>
+
+// Read-only asset archive built by tools/pack_archive. The file is a header,
+// a table of contents sorted by path hash, then the blobs, each starting on
+// an ARCHIVE_ALIGNMENT boundary. Blobs are laid out in the order they were
+// given to the packer, so assets that load together can sit next to each
+// other on disk. At runtime the whole archive is one mapping and a lookup is
+// a binary search over the table; no per-asset files are opened.
+//
+// Paths are not stored, only their hash: look assets up with the same
+// relative path, '/'-separated, that was passed to the packer. All fields
+// are little-endian.
+
+#define ARCHIVE_MAGIC 0x4b415045u // "EPAK"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGNMENT 4096
+
+typedef struct archive_header_t {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t reserved;
+  // Byte offset of the first archive_entry.
+  uint64_t toc_offset;
+} archive_header;
+
+typedef struct archive_entry_t {
+  uint64_t hash;
+  // Byte offset of the blob from the start of the archive, a multiple of
+  // ARCHIVE_ALIGNMENT.
+  uint64_t offset;
+  // Bytes stored in the archive.
+  uint64_t size;
+  // Bytes once decoded; equal to `size` for stored blobs.
+  uint64_t raw_size;
+  // archive_entry_flags: how the blob is encoded.
+  uint32_t flags;
+  uint32_t reserved;
+} archive_entry;
+
+typedef enum archive_entry_flags_t {
+  // Stored as is: `raw_size` equals `size`.
+  ARCHIVE_ENTRY_STORED = 0,
+  // An lz frame (see util/lz.h) that decodes to `raw_size` bytes.
+  ARCHIVE_ENTRY_LZ = 1 << 0,
+} archive_entry_flags;
+
+static_assert(sizeof(archive_header) == 24, "archive_header layout is part of the file format");
+static_assert(sizeof(archive_entry) == 40, "archive_entry layout is part of the file format");
+
+typedef struct archive_t {
+  file_view view;
+  const archive_entry *entries;
+  uint32_t entry_count;
+} archive;
+
+// 64-bit FNV-1a of `path`, the key the table of contents is sorted by.
+static inline uint64_t archive_hash_path(const char *path) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (const unsigned char *c = (const unsigned char*)path; *c; ++c) {
+    hash ^= *c;
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+// Maps the archive at `path` and checks its header and table of contents.
+// Returns false, after logging why, if it cannot be mapped or is malformed.
+bool archive_open(archive *a, const char *path);
+
+void archive_close(archive *a);
+
+// NULL when the archive has no entry for `path`.
+const archive_entry *archive_find(const archive *a, const char *path);
+const archive_entry *archive_find_hash(const archive *a, uint64_t hash);
+
+// The stored bytes of `entry`, valid until archive_close. Still encoded when
+// the entry has ARCHIVE_ENTRY_LZ set; archive_read decodes them.
+static inline const uint8_t *archive_entry_data(const archive *a, const archive_entry *entry) {
+  return a->view.data + entry->offset;
+}
+
+// Writes the `raw_size` decoded bytes of `entry` to `dst`. Compressed entries
+// are decoded in parallel on the job system, and then `dst` must be cached
+// memory (see lz_decompress_parallel), not a mapped staging buffer. Returns
+// false, after logging, if the blob is corrupt.
+bool archive_read(const archive *a, const archive_entry *entry, void *dst);
+
+HEADER_END
+
+#endif // ARCHIVE_H_
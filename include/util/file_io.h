@@ -5,11 +5,40 @@
 
 HEADER_BEGIN
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
+// The returned buffer is released with mem_free.
 uint8_t *read_entire_file(const char *path, size_t *size);
 
+// Read-only view of a whole file. Where the platform has mmap the bytes are
+// the page cache itself, so nothing is copied and pages are only read in as
+// they are touched; elsewhere the file is read into a heap buffer.
+typedef struct file_view_t {
+  const uint8_t *data;
+  size_t size;
+  // Whether `data` is a mapping rather than a heap buffer.
+  bool mapped;
+} file_view;
+
+// How the view is going to be read; both only tune the kernel's readahead.
+typedef enum file_map_flags_t {
+  FILE_MAP_DEFAULT = 0,
+  // Front to back, once: read ahead aggressively and drop pages behind.
+  FILE_MAP_SEQUENTIAL = 1 << 0,
+  // All of it, soon: start reading the whole file in right away.
+  FILE_MAP_WILLNEED = 1 << 1,
+} file_map_flags;
+
+// Maps `path` into `view`. An empty file gives a view with NULL data and
+// zero size. Returns false, after logging why, if the file cannot be opened
+// or mapped.
+bool map_file(const char *path, file_view *view, file_map_flags flags);
+
+// Releases the view; `view->data` must not be used afterwards.
+void unmap_file(file_view *view);
+
 HEADER_END
 
 #endif // FILE_IO_H_
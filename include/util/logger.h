@@ -5,6 +5,10 @@
 
 HEADER_BEGIN
 
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL3/SDL_atomic.h>
 #include <SDL3/SDL_log.h>
 
 void check_sdl_result(bool res, const char *msg);
@@ -17,6 +21,236 @@ void check_vk_result(VkResult res, const char *msg);
 
 #endif // __VK_BACKEND
 
+// Asynchronous logging. LOG_INFO(category, fmt, ...) and friends take
+// printf-style arguments but do not format them: they copy the format pointer
+// and the raw argument values (plus the contents of string arguments) into a
+// fixed-size record on a lock-free ring, and a background thread formats and
+// prints records in order through SDL_Log, prefixed with the level and
+// category. Each call site may log at most LOG_RATE_LIMIT times per
+// LOG_RATE_WINDOW_MS; the rest are counted and reported with the next message
+// that gets through. LOG_INFO_UNLIMITED skips that limit, for sites that log a
+// bounded burst of lines in one go, such as a report. When the ring is full
+// records are dropped rather than blocking the caller.
+//
+// Until logger_init (and after logger_shutdown) messages are formatted and
+// printed synchronously. The format must be a string literal. Up to
+// LOG_MAX_ARGS arguments; `*` widths and precisions are not supported.
+
+// Levels are plain macros rather than an enum so LOG_MIN_LEVEL can be
+// compared by the preprocessor.
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARNING 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+// Calls below this level compile to nothing, arguments included. Set it with
+// -DLOG_MIN_LEVEL=LOG_LEVEL_WARNING (`make LOG_MIN_LEVEL=WARNING`); builds with
+// NDEBUG default to warnings and errors only.
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_WARNING
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_TRACE
+#endif
+#endif // LOG_MIN_LEVEL
+
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO
+
+typedef enum log_category_t {
+  LOG_CAT_CORE,
+  LOG_CAT_JOBS,
+  LOG_CAT_MEMORY,
+  LOG_CAT_PLATFORM,
+  LOG_CAT_RENDER,
+  LOG_CAT_VULKAN,
+  LOG_CAT_ASSETS,
+  LOG_CAT_COUNT
+} log_category;
+
+#define LOG_MAX_ARGS 8
+#define LOG_RATE_LIMIT 16
+#define LOG_RATE_WINDOW_MS 1000
+
+typedef enum log_arg_type_t {
+  LOG_ARG_I32,
+  LOG_ARG_U32,
+  LOG_ARG_I64,
+  LOG_ARG_U64,
+  LOG_ARG_DOUBLE,
+  LOG_ARG_STRING,
+  LOG_ARG_POINTER
+} log_arg_type;
+
+typedef struct log_arg_t {
+  log_arg_type type;
+  union {
+    int64_t i;
+    uint64_t u;
+    double d;
+    const char *s;
+    const void *p;
+  };
+} log_arg;
+
+// One per logging call site.
+typedef struct log_site_t {
+  const char *fmt;
+  uint8_t level;
+  uint8_t category;
+  bool unlimited; // Not rate limited.
+  SDL_AtomicU32 window_start_ms;
+  SDL_AtomicInt window_count;
+  SDL_AtomicInt suppressed;
+} log_site;
+
+// Starts the writer thread and registers logger_shutdown with atexit, so
+// messages logged right before exit(1) still come out.
+void logger_init(void);
+
+// Prints everything queued so far, then stops the writer thread.
+void logger_shutdown(void);
+
+// Blocks until everything queued so far has been printed.
+void logger_flush(void);
+
+// Runtime threshold for a category: messages below `level` are skipped
+// before their arguments are evaluated. Every category starts at
+// LOG_DEFAULT_LEVEL. Levels below LOG_MIN_LEVEL stay compiled out.
+void logger_set_level(log_category category, int level);
+void logger_set_all_levels(int level);
+int logger_get_level(log_category category);
+
+const char *log_level_name(int level);
+const char *log_category_name(log_category category);
+
+// Read without synchronization on every call; a change made on another thread
+// may take a few messages to be seen.
+extern uint8_t __log_levels[LOG_CAT_COUNT];
+
+void __log_push(log_site *site, uint32_t count, const log_arg *args);
+
+#ifdef __cplusplus
+// Overloads cannot have C linkage.
+HEADER_END
+
+static inline log_arg __log_arg_i32(int32_t v) { log_arg a = { LOG_ARG_I32, {} }; a.i = v; return a; }
+static inline log_arg __log_arg_u32(uint32_t v) { log_arg a = { LOG_ARG_U32, {} }; a.u = v; return a; }
+static inline log_arg __log_arg_i64(int64_t v) { log_arg a = { LOG_ARG_I64, {} }; a.i = v; return a; }
+static inline log_arg __log_arg_u64(uint64_t v) { log_arg a = { LOG_ARG_U64, {} }; a.u = v; return a; }
+static inline log_arg __log_arg(bool v) { return __log_arg_u32(v); }
+static inline log_arg __log_arg(char v) { return __log_arg_i32(v); }
+static inline log_arg __log_arg(signed char v) { return __log_arg_i32(v); }
+static inline log_arg __log_arg(unsigned char v) { return __log_arg_u32(v); }
+static inline log_arg __log_arg(short v) { return __log_arg_i32(v); }
+static inline log_arg __log_arg(unsigned short v) { return __log_arg_u32(v); }
+static inline log_arg __log_arg(int v) { return __log_arg_i32(v); }
+static inline log_arg __log_arg(unsigned int v) { return __log_arg_u32(v); }
+static inline log_arg __log_arg(long v) { return __log_arg_i64(v); }
+static inline log_arg __log_arg(unsigned long v) { return __log_arg_u64(v); }
+static inline log_arg __log_arg(long long v) { return __log_arg_i64(v); }
+static inline log_arg __log_arg(unsigned long long v) { return __log_arg_u64(v); }
+static inline log_arg __log_arg(double v) { log_arg a = { LOG_ARG_DOUBLE, {} }; a.d = v; return a; }
+static inline log_arg __log_arg(const char *v) { log_arg a = { LOG_ARG_STRING, {} }; a.s = v; return a; }
+static inline log_arg __log_arg(const void *v) { log_arg a = { LOG_ARG_POINTER, {} }; a.p = v; return a; }
+
+HEADER_BEGIN
+#else
+static inline log_arg __log_arg_i32(int32_t v) { return (log_arg) { LOG_ARG_I32, { .i = v } }; }
+static inline log_arg __log_arg_u32(uint32_t v) { return (log_arg) { LOG_ARG_U32, { .u = v } }; }
+static inline log_arg __log_arg_i64(int64_t v) { return (log_arg) { LOG_ARG_I64, { .i = v } }; }
+static inline log_arg __log_arg_u64(uint64_t v) { return (log_arg) { LOG_ARG_U64, { .u = v } }; }
+static inline log_arg __log_arg_double(double v) { return (log_arg) { LOG_ARG_DOUBLE, { .d = v } }; }
+static inline log_arg __log_arg_string(const char *v) { return (log_arg) { LOG_ARG_STRING, { .s = v } }; }
+static inline log_arg __log_arg_pointer(const void *v) { return (log_arg) { LOG_ARG_POINTER, { .p = v } }; }
+
+#define __log_arg(x) _Generic((x),                  \
+    bool: __log_arg_u32,                            \
+    char: __log_arg_i32,                            \
+    signed char: __log_arg_i32,                     \
+    unsigned char: __log_arg_u32,                   \
+    short: __log_arg_i32,                           \
+    unsigned short: __log_arg_u32,                  \
+    int: __log_arg_i32,                             \
+    unsigned int: __log_arg_u32,                    \
+    long: __log_arg_i64,                            \
+    unsigned long: __log_arg_u64,                   \
+    long long: __log_arg_i64,                       \
+    unsigned long long: __log_arg_u64,              \
+    float: __log_arg_double,                        \
+    double: __log_arg_double,                       \
+    char*: __log_arg_string,                        \
+    const char*: __log_arg_string,                  \
+    default: __log_arg_pointer)(x)
+#endif // __cplusplus
+
+#define __LOG_CAT(a, b) __LOG_CAT_(a, b)
+#define __LOG_CAT_(a, b) a##b
+#define __LOG_NARGS(...) __LOG_NARGS_(__VA_ARGS__ __VA_OPT__(,) 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __LOG_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define __LOG_CAPTURE(...) __LOG_CAT(__LOG_CAPTURE_, __LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define __LOG_CAPTURE_0()
+#define __LOG_CAPTURE_1(a) , __log_arg(a)
+#define __LOG_CAPTURE_2(a, ...) , __log_arg(a) __LOG_CAPTURE_1(__VA_ARGS__)
+#define __LOG_CAPTURE_3(a, ...) , __log_arg(a) __LOG_CAPTURE_2(__VA_ARGS__)
+#define __LOG_CAPTURE_4(a, ...) , __log_arg(a) __LOG_CAPTURE_3(__VA_ARGS__)
+#define __LOG_CAPTURE_5(a, ...) , __log_arg(a) __LOG_CAPTURE_4(__VA_ARGS__)
+#define __LOG_CAPTURE_6(a, ...) , __log_arg(a) __LOG_CAPTURE_5(__VA_ARGS__)
+#define __LOG_CAPTURE_7(a, ...) , __log_arg(a) __LOG_CAPTURE_6(__VA_ARGS__)
+#define __LOG_CAPTURE_8(a, ...) , __log_arg(a) __LOG_CAPTURE_7(__VA_ARGS__)
+
+// The leading placeholder keeps the array non-empty when there are no
+// arguments; it is skipped when pushing.
+#define __LOG_AT(lvl, cat, ...) __LOG_AT_SITE(lvl, cat, false, __VA_ARGS__)
+#define __LOG_AT_SITE(lvl, cat, unlim, format, ...)                            \
+  do {                                                                         \
+    if ((lvl) >= __log_levels[(cat)]) {                                        \
+      static log_site __log_site = { .fmt = format, .level = (lvl), .category = (cat), .unlimited = (unlim) }; \
+      const log_arg __log_args[] = { __log_arg_i32(0) __LOG_CAPTURE(__VA_ARGS__) }; \
+      __log_push(&__log_site, sizeof(__log_args) / sizeof(__log_args[0]) - 1,  \
+                 __log_args + 1);                                              \
+    }                                                                          \
+  } while (0)
+
+// Stripped calls still name their arguments, so variables that only feed a
+// log message do not trip unused-variable warnings, but nothing is evaluated.
+static inline void __log_discard(int category, ...) { (void)category; }
+#define __LOG_STRIPPED(cat, ...) do { if (0) __log_discard((cat), __VA_ARGS__); } while (0)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_TRACE
+#define LOG_TRACE(cat, ...) __LOG_AT(LOG_LEVEL_TRACE, cat, __VA_ARGS__)
+#else
+#define LOG_TRACE(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(cat, ...) __LOG_AT(LOG_LEVEL_DEBUG, cat, __VA_ARGS__)
+#else
+#define LOG_DEBUG(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(cat, ...) __LOG_AT(LOG_LEVEL_INFO, cat, __VA_ARGS__)
+#define LOG_INFO_UNLIMITED(cat, ...) __LOG_AT_SITE(LOG_LEVEL_INFO, cat, true, __VA_ARGS__)
+#else
+#define LOG_INFO(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#define LOG_INFO_UNLIMITED(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(cat, ...) __LOG_AT(LOG_LEVEL_WARNING, cat, __VA_ARGS__)
+#else
+#define LOG_WARNING(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(cat, ...) __LOG_AT(LOG_LEVEL_ERROR, cat, __VA_ARGS__)
+#else
+#define LOG_ERROR(cat, ...) __LOG_STRIPPED(cat, __VA_ARGS__)
+#endif
+
 HEADER_END
 
 #endif // LOGGER_H_
@@ -0,0 +1,79 @@
+#ifndef LZ_H_
+#define LZ_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fast LZ77 codec for assets: cheap enough to decode that loading stays
+// bound by the disk, while storing less of it. Blocks use the LZ4 block
+// format (the reference lz4 tools can produce and check them) and are at
+// most LZ_BLOCK_SIZE bytes. Match offsets never leave the block.
+//
+// A frame cuts larger data into such blocks, each compressed on its own:
+//
+//   lz_frame_header
+//   uint32_t sizes[block_count]   stored size of each block; LZ_BLOCK_STORED
+//                                 set when it is kept uncompressed
+//   blocks, back to back
+//
+// Block i decodes to bytes [i * LZ_BLOCK_SIZE, (i + 1) * LZ_BLOCK_SIZE) of
+// the output, so blocks can be decoded in any order and on any thread. All
+// fields are little-endian.
+//
+// Decoders check every length and offset against both buffers: a corrupt
+// input fails instead of reading or writing out of bounds.
+
+#define LZ_BLOCK_SIZE (64 * 1024)
+#define LZ_FRAME_MAGIC 0x31425a4cu // "LZB1"
+#define LZ_BLOCK_STORED 0x80000000u
+
+typedef struct lz_frame_header_t {
+  uint32_t magic;
+  uint32_t block_count;
+  uint64_t raw_size;
+} lz_frame_header;
+
+// Largest compressed block `size` input bytes can turn into.
+static inline size_t lz_block_bound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+// Compresses `size` (at most LZ_BLOCK_SIZE) bytes into `dst`. Returns the
+// compressed size, or 0 when it does not fit in `capacity`.
+size_t lz_compress_block(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity);
+
+// Decodes a block that must come out at exactly `raw_size` bytes.
+bool lz_decompress_block(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+// Largest frame `raw_size` bytes can turn into.
+size_t lz_frame_bound(size_t raw_size);
+
+// Compresses `size` bytes into a frame in `dst`. Returns the frame size, or 0
+// when it does not fit in `capacity`; lz_frame_bound is always enough.
+size_t lz_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity);
+
+// The decoded size a frame declares, or false if `src` does not start with a
+// frame header.
+bool lz_frame_raw_size(const uint8_t *src, size_t size, uint64_t *raw_size);
+
+// Decodes a whole frame into `dst`, which must hold exactly `raw_size`
+// bytes, on the calling thread.
+bool lz_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+// Same as lz_decompress, but the blocks are spread over the job system's
+// workers; the calling thread takes part.
+//
+// For both, `dst` must be cached memory: matches are copied out of bytes
+// already decoded into it, and copies run up to 16 bytes past a sequence
+// before the next one overwrites them. Decode into a heap buffer before
+// copying into write-combined memory such as a mapped staging buffer.
+bool lz_decompress_parallel(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size);
+
+HEADER_END
+
+#endif // LZ_H_
@@ -0,0 +1,105 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <SDL3/SDL_timer.h>
+
+// Hierarchical CPU profiler. PROFILE_SCOPE("name") times the rest of the
+// enclosing block; zones nest by time, so a zone opened inside another shows
+// up as its child. Every thread writes completed zones into its own buffer
+// without locking, keeping the most recent PROFILE_EVENTS_PER_THREAD of them,
+// and profiler_write_chrome_trace dumps all buffers as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev).
+//
+// Zones only exist in builds with ENGINE_PROFILE defined (`make PROFILE=1`);
+// otherwise every macro here expands to nothing. Names must outlive the
+// profiler: string literals or __func__.
+
+// Must be a power of two.
+#define PROFILE_EVENTS_PER_THREAD 16384
+#define PROFILE_MAX_THREADS 64
+
+typedef struct profile_zone_t {
+  const char *name;
+  // Zero when the zone was opened while profiling was paused.
+  uint64_t start;
+} profile_zone;
+
+// Starts or pauses recording at runtime. Recording starts enabled.
+void profiler_set_enabled(bool enabled);
+bool profiler_is_enabled(void);
+
+// Label for the calling thread in exported traces. Threads that never call it
+// show up as "thread N".
+void profiler_set_thread_name(const char *name);
+
+// Writes every buffered zone as Chrome trace JSON. Zones recorded while the
+// file is written may or may not be included. Returns false if the file could
+// not be written.
+bool profiler_write_chrome_trace(const char *path);
+
+// Drops every buffered zone.
+void profiler_clear(void);
+
+extern bool __profile_enabled;
+
+void __profile_record(const char *name, uint64_t start, uint64_t end);
+
+static inline profile_zone __profile_zone_begin(const char *name) {
+  profile_zone zone = { name, 0 };
+  if (__profile_enabled) zone.start = SDL_GetPerformanceCounter();
+  return zone;
+}
+
+static inline void __profile_zone_end(profile_zone *zone) {
+  if (zone->start) __profile_record(zone->name, zone->start, SDL_GetPerformanceCounter());
+}
+
+#define __PROFILE_CAT(a, b) __PROFILE_CAT_(a, b)
+#define __PROFILE_CAT_(a, b) a##b
+
+#ifdef ENGINE_PROFILE
+
+#ifdef __cplusplus
+HEADER_END
+
+struct __profile_scope {
+  profile_zone zone;
+  explicit __profile_scope(const char *name) : zone(__profile_zone_begin(name)) {}
+  ~__profile_scope() { __profile_zone_end(&zone); }
+};
+
+#define PROFILE_SCOPE(name) __profile_scope __PROFILE_CAT(__profile_scope_, __COUNTER__)(name)
+
+HEADER_BEGIN
+#else
+#define PROFILE_SCOPE(name)                                                    \
+  profile_zone __PROFILE_CAT(__profile_zone_, __COUNTER__)                        \
+    __attribute__((cleanup(__profile_zone_end))) = __profile_zone_begin(name)
+#endif // __cplusplus
+
+// For spans that do not line up with a block.
+#define PROFILE_BEGIN(zone, name) profile_zone zone = __profile_zone_begin(name)
+#define PROFILE_END(zone) __profile_zone_end(&(zone))
+#define PROFILE_THREAD(name) profiler_set_thread_name(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_BEGIN(zone, name)
+#define PROFILE_END(zone)
+#define PROFILE_THREAD(name)
+
+#endif // ENGINE_PROFILE
+
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+HEADER_END
+
+#endif // PROFILER_H_
@@ -0,0 +1,61 @@
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdint.h>
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_timer.h>
+
+// Wall-clock breakdown of a one-off sequence such as startup. Steps may be
+// recorded from any thread, so work that runs concurrently shows up as
+// overlapping entries in the report. Unlike profiler zones these are always
+// compiled in; they are meant for a handful of coarse steps, not hot paths.
+
+#define TIMING_MAX_STEPS 32
+
+typedef struct timing_step_t {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+} timing_step;
+
+typedef struct timing_report_t {
+  const char *title;
+  uint64_t start;
+  SDL_AtomicInt step_count;
+  timing_step steps[TIMING_MAX_STEPS];
+} timing_report;
+
+void timing_begin(timing_report *r, const char *title);
+
+// Records a step that started at `start` (a SDL_GetPerformanceCounter value)
+// and ends now. Steps past TIMING_MAX_STEPS are dropped, and so is everything
+// when `r` is NULL.
+void timing_record(timing_report *r, const char *name, uint64_t start);
+
+// Milliseconds from timing_begin until now.
+double timing_elapsed_ms(const timing_report *r);
+
+// Logs the total so far, then every step in start order as its offset from
+// timing_begin and its duration.
+void timing_log(timing_report *r);
+
+static inline double timing_ticks_to_ms(uint64_t ticks) {
+  return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+// Runs the statements that follow `name` and records them as one step.
+#define TIMING_STEP(r, name, ...)                                              \
+  do {                                                                         \
+    uint64_t __timing_start = SDL_GetPerformanceCounter();                     \
+    __VA_ARGS__;                                                               \
+    timing_record((r), (name), __timing_start);                                \
+  } while (0)
+
+HEADER_END
+
+#endif // TIMING_H_
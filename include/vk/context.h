@@ -5,8 +5,15 @@
 
 HEADER_BEGIN
 
+#include <core/arena.h>
+#include <core/job.h>
+#include <core/pool.h>
 #include <core/window.h>
 #include <renderer/vertex.h>
+#include <util/timing.h>
+#include <vk/spirv_reflect.h>
+
+#include <SDL3/SDL_mutex.h>
 
 #include <vulkan/vulkan_core.h>
 
@@ -14,6 +21,66 @@ HEADER_BEGIN
 
 #define MAX_FRAMES_IN_FLIGHT 2
 #define MAX_VERTICES 10000
+#define VK_MAX_PIPELINES 64
+// Destroyed pipelines waiting for the frames that used them to finish.
+#define VK_MAX_RETIRED_PIPELINES 16
+// Pipeline replacements waiting for a frame boundary.
+#define VK_MAX_PIPELINE_SWAPS 16
+#define VK_MAX_DESCRIPTOR_SETS 4
+// Distinct descriptor set and pipeline layouts the context can hold.
+#define VK_MAX_SET_LAYOUTS 16
+#define VK_MAX_PIPELINE_LAYOUTS 32
+// Size of each frame-in-flight arena.
+#define VK_FRAME_ARENA_SIZE (1024 * 1024)
+
+// `pipeline` may only be read once `ready` is set: pipelines from
+// vk_pipeline_request are filled in by a job worker. `failed` is set instead
+// when that compile fails; the slot then has no pipeline of its own until
+// vk_pipeline_replace gives it one.
+typedef struct vk_pipeline_slot_t {
+  VkPipeline pipeline;
+  SDL_AtomicInt ready;
+  SDL_AtomicInt failed;
+} vk_pipeline_slot;
+
+POOL_DEFINE(vk_pipeline, vk_pipeline_slot)
+
+typedef struct vk_pipeline_swap_t {
+  vk_pipeline_handle handle;
+  VkPipeline pipeline;
+} vk_pipeline_swap;
+
+typedef struct vk_retired_pipeline_t {
+  VkPipeline pipeline;
+  // Destroyed once frame_index reaches this.
+  uint64_t destroy_at_frame;
+} vk_retired_pipeline;
+
+// Bindings sorted by binding number, so equal sets compare equal.
+typedef struct vk_set_layout_desc_t {
+  uint32_t binding_count;
+  VkDescriptorSetLayoutBinding bindings[SPIRV_MAX_BINDINGS];
+} vk_set_layout_desc;
+
+typedef struct vk_pipeline_layout_desc_t {
+  uint32_t set_count;
+  vk_set_layout_desc sets[VK_MAX_DESCRIPTOR_SETS];
+  // Ignored when its size is zero.
+  VkPushConstantRange push_constants;
+} vk_pipeline_layout_desc;
+
+typedef struct vk_set_layout_entry_t {
+  vk_set_layout_desc desc;
+  VkDescriptorSetLayout layout;
+} vk_set_layout_entry;
+
+// Keyed by the (already deduplicated) set layout handles.
+typedef struct vk_pipeline_layout_entry_t {
+  uint32_t set_count;
+  VkDescriptorSetLayout sets[VK_MAX_DESCRIPTOR_SETS];
+  VkPushConstantRange push_constants;
+  VkPipelineLayout layout;
+} vk_pipeline_layout_entry;
 
 typedef struct swapchain_support_details_t {
   VkSurfaceCapabilitiesKHR caps;
@@ -63,32 +130,137 @@ typedef struct vk_context_t {
   VkSemaphore *render_finished_semaphores;
   VkFence *in_flight_fences;
   uint8_t current_frame;
+  // Frames drawn so far.
+  uint64_t frame_index;
+  // One per frame in flight, reset once that frame's fence has signaled, so
+  // anything allocated while recording a frame lives until the GPU is done
+  // with it.
+  arena frame_arenas[MAX_FRAMES_IN_FLIGHT];
 
+  // The layout without descriptors or push constants.
   VkPipelineLayout pipeline_layout;
-  VkPipeline tri_pipeline;
+  // Every layout handed out by vk_pipeline_layout_get; shared between the
+  // pipelines that ask for the same one and destroyed with the context.
+  SDL_Mutex *layout_lock;
+  uint32_t set_layout_count;
+  vk_set_layout_entry set_layouts[VK_MAX_SET_LAYOUTS];
+  uint32_t pipeline_layout_count;
+  vk_pipeline_layout_entry pipeline_layouts[VK_MAX_PIPELINE_LAYOUTS];
+  // Every pipeline built through vk_pipeline_build or vk_pipeline_request;
+  // destroyed with the context.
+  pool pipelines;
+  vk_pipeline_handle tri_pipeline;
+  // Drawn with in place of pipelines that are still compiling. May be null,
+  // in which case those draws are skipped.
+  vk_pipeline_handle default_pipeline;
+  // Counts vk_pipeline_request compiles still in flight.
+  job_counter pipeline_jobs;
+  // Pipelines may be requested, replaced and destroyed from any thread while
+  // the render thread draws with them. Adds to and removes from `pipelines`,
+  // writes to `default_pipeline` and everything below happen under it;
+  // removals only on the thread calling vk_draw_frame.
+  SDL_SpinLock pipeline_lock;
+  uint32_t swap_count;
+  vk_pipeline_swap swaps[VK_MAX_PIPELINE_SWAPS];
+  uint32_t destroy_count;
+  vk_pipeline_handle destroys[VK_MAX_PIPELINES];
+  uint32_t retired_count;
+  vk_retired_pipeline retired[VK_MAX_RETIRED_PIPELINES];
+
+  // Seeds the pipeline cache at init and receives its contents at shutdown
+  // when set before vk_context_init.
+  const char *pipeline_cache_path;
+  VkPipelineCache pipeline_cache;
 
   VmaAllocator allocator;
   VkBuffer buffer;
   VmaAllocation allocation;
+
+  // Only set while vk_context_init runs.
+  timing_report *init_timing;
 } vk_context;
 
+// SPIR-V words and their size in bytes.
+typedef struct vk_shader_code_t {
+  const uint32_t *code;
+  size_t size;
+} vk_shader_code;
+
 typedef struct vk_pipeline_config_t {
   VkPipelineInputAssemblyStateCreateInfo input_assembly;
   VkPipelineRasterizationStateCreateInfo rasterizer;
   VkPipelineMultisampleStateCreateInfo multisampling;
   VkPipelineColorBlendAttachmentState color_blend_attachment;
+  // Where the vertex shader's inputs are found in the vertex buffer. Only the
+  // attributes the shader reads are bound. NULL derives a tightly packed
+  // layout from the shader's inputs instead.
+  const vertex_layout *vertex_layout;
+  // NULL derives the layout from the shaders' descriptor bindings and push
+  // constants through vk_pipeline_layout_get.
   VkPipelineLayout layout;
   VkRenderPass render_pass;
 } vk_pipeline_config;
 
 vk_pipeline_config vk_default_pipeline_config();
 
-void vk_context_init(vk_context *ctx, const char *title, int width, int height);
+// Creates the window and every Vulkan object the renderer needs, running the
+// steps that do not depend on each other as jobs; needs the job system. Each
+// step is recorded in `timing` when it is not NULL.
+void vk_context_init(vk_context *ctx, const char *title, int width, int height, timing_report *timing);
+
+vk_pipeline_handle vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *fs_path, vk_pipeline_config *config);
+
+// Same as vk_pipeline_build, for shaders that are already in memory.
+vk_pipeline_handle vk_pipeline_build_from_code(vk_context *ctx, vk_shader_code vs, vk_shader_code fs, vk_pipeline_config *config);
+
+// Returns a handle right away and compiles the pipeline on a job worker. The
+// shader code and config are copied. Until the compile finishes, draws with
+// the handle use the default pipeline, or are skipped if there is none. A
+// compile that fails is logged and leaves the handle on that fallback.
+vk_pipeline_handle vk_pipeline_request(vk_context *ctx, vk_shader_code vs, vk_shader_code fs, const vk_pipeline_config *config);
+
+bool vk_pipeline_ready(vk_context *ctx, vk_pipeline_handle pipeline);
+
+// The stand-in must be compatible with the pipelines it replaces: same render
+// pass, layout and vertex format. May be called from any thread.
+void vk_pipeline_set_default(vk_context *ctx, vk_pipeline_handle pipeline);
 
-VkPipeline vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *fs_path, vk_pipeline_config *config);
+// Returns the layout matching `desc`, creating it (and its descriptor set
+// layouts) the first time it is asked for. VK_NULL_HANDLE, with the error
+// logged, when it cannot be created. May be called from any thread.
+VkPipelineLayout vk_pipeline_layout_get(vk_context *ctx, const vk_pipeline_layout_desc *desc);
+
+// The layout the given shaders need, found by reflecting them; what
+// vk_pipeline_compile uses when the config leaves `layout` unset.
+VkPipelineLayout vk_pipeline_layout_from_code(vk_context *ctx, vk_shader_code vs, vk_shader_code fs);
+
+// Compiles a pipeline without storing it; VK_NULL_HANDLE (with the error
+// logged) if the shaders or the pipeline are invalid. May be called from any
+// thread.
+VkPipeline vk_pipeline_compile(vk_context *ctx, vk_shader_code vs, vk_shader_code fs, const vk_pipeline_config *config);
+
+// Makes `handle` draw with `replacement` from the next frame on, which takes
+// ownership of it. The old pipeline is destroyed once no frame in flight can
+// still use it. May be called from any thread; a replacement that has not
+// been applied yet is itself replaced.
+void vk_pipeline_replace(vk_context *ctx, vk_pipeline_handle handle, VkPipeline replacement);
+
+// The VkPipeline to draw `pipeline` with right now: itself when ready,
+// otherwise the default pipeline, otherwise VK_NULL_HANDLE.
+VkPipeline vk_pipeline_resolve(vk_context *ctx, vk_pipeline_handle pipeline);
+
+// Releases `pipeline` at the start of the next frame; the VkPipeline itself
+// is destroyed once no frame in flight can still use it. May be called from
+// any thread, including while its compile is still running.
+void vk_pipeline_destroy(vk_context *ctx, vk_pipeline_handle pipeline);
 
 void vk_draw_frame(vk_context *ctx, uint32_t vertex_count);
 
+// Arena of the frame currently being recorded.
+static inline arena *vk_frame_arena(vk_context *ctx) {
+  return &ctx->frame_arenas[ctx->current_frame];
+}
+
 void vk_context_shutdown(vk_context *ctx);
 
 HEADER_END
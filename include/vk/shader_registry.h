@@ -0,0 +1,43 @@
+#ifndef SHADER_REGISTRY_H_
+#define SHADER_REGISTRY_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vk/context.h>
+
+// Shaders compiled into the engine library. The build runs
+// tools/embed_spirv over every SPIR-V file in SHADERS, and each one is
+// registered under its file name without the .spv extension
+// ("shaders/tri-vert.spv" is "tri-vert"). Loading them at startup takes no
+// file I/O and cannot fail on a missing file.
+
+typedef struct vk_embedded_shader_t {
+  const char *name;
+  vk_shader_code code;
+} vk_embedded_shader;
+
+// The embedded copy of `name`, or NULL if there is none.
+const vk_shader_code *vk_shader_find_embedded(const char *name);
+
+// Loads `name`, preferring `<dir>/<name>.spv` when `dir` is set and the file
+// exists, so shaders can be iterated on without rebuilding the engine.
+// Otherwise falls back to the embedded copy. Returns false when neither
+// exists. Pass the result to vk_shader_release when done with it.
+bool vk_shader_load(const char *dir, const char *name, vk_shader_code *out);
+
+// Frees `code` if vk_shader_load read it from disk; embedded code is left
+// alone.
+void vk_shader_release(vk_shader_code *code);
+
+// Defined by the generated source, sorted by name.
+extern const vk_embedded_shader __vk_embedded_shaders[];
+extern const uint32_t __vk_embedded_shader_count;
+
+HEADER_END
+
+#endif // SHADER_REGISTRY_H_
@@ -0,0 +1,70 @@
+#ifndef SHADER_RELOAD_H_
+#define SHADER_RELOAD_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_thread.h>
+
+#include <vk/context.h>
+
+// Development-mode shader hot reload (Linux only). A watcher thread listens
+// for inotify events on the directories holding the SPIR-V of tracked
+// pipelines. When a file is rewritten it recompiles the affected pipelines on
+// that thread and hands them to vk_pipeline_replace, which swaps them in at
+// the next frame boundary. When an HLSL source is given, saving it runs dxc
+// with the same profiles and entry points as the Makefile's shader rule; the
+// rewritten SPIR-V then triggers the rebuild. Shaders that fail to compile
+// are reported and the old pipeline stays in use.
+
+#define SHADER_RELOAD_MAX_PIPELINES 16
+#define SHADER_RELOAD_PATH_MAX 256
+
+typedef enum shader_reload_file_t {
+  SHADER_RELOAD_VS,
+  SHADER_RELOAD_FS,
+  SHADER_RELOAD_HLSL,
+  SHADER_RELOAD_FILE_COUNT
+} shader_reload_file;
+
+typedef struct shader_reload_entry_t {
+  vk_pipeline_handle pipeline;
+  vk_pipeline_config config;
+  char paths[SHADER_RELOAD_FILE_COUNT][SHADER_RELOAD_PATH_MAX];
+  // inotify watch of each path's directory; -1 for an unused HLSL path.
+  int watches[SHADER_RELOAD_FILE_COUNT];
+} shader_reload_entry;
+
+typedef struct shader_reload_t {
+  vk_context *ctx;
+  SDL_Thread *thread;
+  SDL_AtomicInt running;
+  int inotify_fd;
+
+  // Guards the entries, which shader_reload_track adds while the watcher
+  // thread reads them.
+  SDL_SpinLock lock;
+  uint32_t entry_count;
+  shader_reload_entry entries[SHADER_RELOAD_MAX_PIPELINES];
+} shader_reload;
+
+// Starts the watcher thread. Returns false, leaving hot reload off, when the
+// platform has no support for it.
+bool shader_reload_init(shader_reload *r, vk_context *ctx);
+
+// Rebuilds `pipeline` from `vs_path` and `fs_path` with `config` whenever
+// either file changes. `hlsl_path` may be NULL.
+void shader_reload_track(shader_reload *r, vk_pipeline_handle pipeline,
+                         const char *vs_path, const char *fs_path, const char *hlsl_path,
+                         const vk_pipeline_config *config);
+
+// Stops the watcher thread. Must run before vk_context_shutdown.
+void shader_reload_shutdown(shader_reload *r);
+
+HEADER_END
+
+#endif // SHADER_RELOAD_H_
@@ -0,0 +1,63 @@
+#ifndef SPIRV_REFLECT_H_
+#define SPIRV_REFLECT_H_
+
+#include <core/cpp_header_guard.h>
+
+HEADER_BEGIN
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan_core.h>
+
+// Minimal SPIR-V reflection: enough of a module to build the pipeline state
+// that has to agree with it (entry point, vertex inputs, descriptor set
+// layouts and push constants) without keeping those tables by hand.
+
+#define SPIRV_MAGIC 0x07230203u
+
+#define SPIRV_MAX_ENTRY_POINT_NAME 64
+#define SPIRV_MAX_INPUTS 16
+#define SPIRV_MAX_BINDINGS 16
+
+typedef struct spirv_input_t {
+  uint32_t location;
+  VkFormat format;
+  // Bytes the attribute takes in a tightly packed vertex.
+  uint32_t size;
+} spirv_input;
+
+typedef struct spirv_binding_t {
+  uint32_t set;
+  uint32_t binding;
+  VkDescriptorType type;
+  uint32_t count;
+} spirv_binding;
+
+typedef struct spirv_reflection_t {
+  // Of the module's first entry point.
+  VkShaderStageFlagBits stage;
+  char entry_point[SPIRV_MAX_ENTRY_POINT_NAME];
+
+  // Sorted by location. Built-ins are left out; matrices and arrays take one
+  // entry per location they occupy.
+  uint32_t input_count;
+  spirv_input inputs[SPIRV_MAX_INPUTS];
+
+  // Sorted by set, then binding.
+  uint32_t binding_count;
+  spirv_binding bindings[SPIRV_MAX_BINDINGS];
+
+  // Bytes of the push constant block, starting at offset 0; zero without one.
+  uint32_t push_constant_size;
+} spirv_reflection;
+
+// Fills `out` from `size` bytes of SPIR-V. Returns false, after logging why,
+// for malformed modules and for ones using something this parser does not
+// understand.
+bool spirv_reflect(const uint32_t *code, size_t size, spirv_reflection *out);
+
+HEADER_END
+
+#endif // SPIRV_REFLECT_H_
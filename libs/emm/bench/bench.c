@@ -0,0 +1,203 @@
+#include <emm.h>
+#include <emm/fast.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Micro-benchmarks for every emm kernel. Each line reports the mean time of
+// one operation in nanoseconds, in a `name ns/op` format that is easy to
+// diff or plot across commits.
+//
+// Inputs are drawn from pools of random values so the compiler cannot fold
+// the work away, and every result is fed into a sink.
+
+#define POOL 1024
+#define POOL_MASK (POOL - 1)
+#define SOA_COUNT 4096
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static float randf(void) {
+  return (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+}
+
+static volatile float sink;
+
+static inline void consume(const void *p, size_t size) {
+  const float *f = (const float*)p;
+  float acc = 0.0f;
+  for (size_t i = 0; i < size / sizeof(float); ++i) acc += f[i];
+  sink += acc;
+}
+
+// Prevents the optimiser from hoisting loop-invariant work out of the
+// timed loop without costing anything at runtime.
+#define CLOBBER() __asm__ volatile("" ::: "memory")
+// Makes every byte of *p look read, so no lane of a result can be dropped.
+#define ESCAPE(p) __asm__ volatile("" :: "g"(p) : "memory")
+
+static vec3 v3s[POOL];
+static vec4 v4s[POOL];
+static mat3 m3s[POOL];
+static mat4 m4s[POOL];
+static quat qs[POOL];
+
+static float xs[SOA_COUNT], ys[SOA_COUNT], zs[SOA_COUNT];
+static float ox[SOA_COUNT], oy[SOA_COUNT], oz[SOA_COUNT];
+static float box_in[6][SOA_COUNT], box_out[6][SOA_COUNT];
+static float radii[SOA_COUNT];
+static bool mask[SOA_COUNT];
+
+static void report(const char *name, double ns, double ops) {
+  printf("%-28s %8.3f ns/op\n", name, ns / ops);
+}
+
+#define BENCH(name, iters, type, expr)                  \
+  do {                                                  \
+    type acc = {0};                                     \
+    double t0 = now_ns();                               \
+    for (size_t i = 0; i < (iters); ++i) {              \
+      size_t a = i & POOL_MASK, b = (i + 1) & POOL_MASK; \
+      (void)a; (void)b;                                 \
+      type r = (expr);                                  \
+      acc.raw[0] += r.raw[0];                           \
+      ESCAPE(&r);                                       \
+    }                                                   \
+    report(name, now_ns() - t0, (double)(iters));       \
+    consume(&acc, sizeof(acc));                         \
+  } while (0)
+
+#define BENCH_SCALAR(name, iters, expr)                 \
+  do {                                                  \
+    float acc = 0.0f;                                   \
+    double t0 = now_ns();                               \
+    for (size_t i = 0; i < (iters); ++i) {              \
+      size_t a = i & POOL_MASK, b = (i + 1) & POOL_MASK; \
+      (void)a; (void)b;                                 \
+      acc += (expr);                                    \
+      CLOBBER();                                        \
+    }                                                   \
+    report(name, now_ns() - t0, (double)(iters));       \
+    sink += acc;                                        \
+  } while (0)
+
+#define BENCH_SOA(name, reps, stmt)                     \
+  do {                                                  \
+    double t0 = now_ns();                               \
+    for (size_t r = 0; r < (reps); ++r) {               \
+      stmt;                                             \
+      CLOBBER();                                        \
+    }                                                   \
+    report(name, now_ns() - t0, (double)(reps) * SOA_COUNT); \
+  } while (0)
+
+int main(int argc, char **argv) {
+  size_t iters = 10000000;
+  if (argc > 1) iters = strtoull(argv[1], NULL, 10);
+  size_t reps = iters / SOA_COUNT + 1;
+
+  srand(1234);
+  for (size_t i = 0; i < POOL; ++i) {
+    v3s[i] = (vec3) { randf(), randf(), randf() };
+    v4s[i] = (vec4) { randf(), randf(), randf(), randf() };
+    for (int k = 0; k < 9; ++k) m3s[i].raw[k] = randf();
+    for (int k = 0; k < 16; ++k) m4s[i].raw[k] = randf();
+    qs[i] = q_from_axis_angle(v3s[i], randf() * 3.0f);
+  }
+  for (size_t i = 0; i < SOA_COUNT; ++i) {
+    xs[i] = randf();
+    ys[i] = randf();
+    zs[i] = randf();
+    radii[i] = fabsf(randf()) * 0.1f;
+    for (int k = 0; k < 3; ++k) {
+      float lo = randf(), hi = randf();
+      box_in[k][i] = fminf(lo, hi);
+      box_in[k + 3][i] = fmaxf(lo, hi);
+    }
+  }
+
+#if defined(EMM_SIMD_AVX)
+  printf("# backend: avx, batch lanes: %d\n", EMM_BATCH_LANES);
+#elif defined(EMM_SIMD_SSE)
+  printf("# backend: sse, batch lanes: %d\n", EMM_BATCH_LANES);
+#elif defined(EMM_SIMD_NEON)
+  printf("# backend: neon, batch lanes: %d\n", EMM_BATCH_LANES);
+#else
+  printf("# backend: scalar, batch lanes: %d\n", EMM_BATCH_LANES);
+#endif
+
+  BENCH("v3_add", iters, vec3, v3_add(v3s[a], v3s[b]));
+  BENCH("v3_cross", iters, vec3, v3_cross(v3s[a], v3s[b]));
+  BENCH_SCALAR("v3_dot", iters, v3_dot(v3s[a], v3s[b]));
+  BENCH("v3_norm", iters, vec3, v3_norm(v3s[a]));
+  BENCH("v4_add", iters, vec4, v4_add(v4s[a], v4s[b]));
+  BENCH_SCALAR("v4_dot", iters, v4_dot(v4s[a], v4s[b]));
+  BENCH("v4_norm", iters, vec4, v4_norm(v4s[a]));
+
+  BENCH("m3_mul", iters, mat3, m3_mul(m3s[a], m3s[b]));
+  BENCH("m3_inverse", iters, mat3, m3_inverse(m3s[a]));
+
+  BENCH("m4_mul", iters, mat4, m4_mul(m4s[a], m4s[b]));
+  BENCH("m4_mul_ref", iters, mat4, m4_mul_ref(m4s[a], m4s[b]));
+  BENCH("m4_mul_v4", iters, vec4, m4_mul_v4(m4s[a], v4s[b]));
+  BENCH("m4_mul_v4_ref", iters, vec4, m4_mul_v4_ref(m4s[a], v4s[b]));
+  BENCH("m4_transpose", iters, mat4, m4_transpose(m4s[a]));
+  BENCH("m4_transpose_ref", iters, mat4, m4_transpose_ref(m4s[a]));
+  BENCH("m4_inverse", iters, mat4, m4_inverse(m4s[a]));
+  BENCH("m4_inverse_ref", iters, mat4, m4_inverse_ref(m4s[a]));
+
+  BENCH("q_mul", iters, quat, q_mul(qs[a], qs[b]));
+  BENCH("q_rotate_v3", iters, vec3, q_rotate_v3(qs[a], v3s[b]));
+  BENCH("q_slerp", iters, quat, q_slerp(qs[a], qs[b], 0.3f));
+  BENCH("q_to_m4", iters, mat4, q_to_m4(qs[a]));
+
+  mat4 xf = m4_mul(m4_translate((vec3) { 1.0f, 2.0f, 3.0f }),
+                   m4_mul(q_to_m4(qs[0]), m4_scale((vec3) { 2.0f, 0.5f, 3.0f })));
+  aabb_soa boxes = { box_in[0], box_in[1], box_in[2], box_in[3], box_in[4], box_in[5] };
+  aabb_soa boxes_out = { box_out[0], box_out[1], box_out[2], box_out[3], box_out[4], box_out[5] };
+
+  BENCH_SOA("transform_points_soa", reps, transform_points_soa(&xf, xs, ys, zs, ox, oy, oz, SOA_COUNT));
+  BENCH_SOA("transform_normals_soa", reps, transform_normals_soa(&xf, xs, ys, zs, ox, oy, oz, SOA_COUNT));
+  BENCH_SOA("transform_aabbs_soa", reps, transform_aabbs_soa(&xf, &boxes, &boxes_out, SOA_COUNT));
+
+  BENCH_SCALAR("sinf", iters, sinf(v4s[a].x * 10.0f));
+  BENCH_SCALAR("fast_sin", iters, fast_sin(v4s[a].x * 10.0f));
+  BENCH_SCALAR("atan2f", iters, atan2f(v4s[a].x, v4s[b].y));
+  BENCH_SCALAR("fast_atan2", iters, fast_atan2(v4s[a].x, v4s[b].y));
+  BENCH_SCALAR("expf", iters, expf(v4s[a].x * 10.0f));
+  BENCH_SCALAR("fast_exp", iters, fast_exp(v4s[a].x * 10.0f));
+  BENCH_SCALAR("1/sqrtf", iters, 1.0f / sqrtf(fabsf(v4s[a].x) + 1.0f));
+  BENCH_SCALAR("fast_rsqrt", iters, fast_rsqrt(fabsf(v4s[a].x) + 1.0f));
+  BENCH("v2_norm", iters, vec2, v2_norm((vec2) { v4s[a].x, v4s[a].y }));
+  BENCH("v2_norm_fast", iters, vec2, v2_norm_fast((vec2) { v4s[a].x, v4s[a].y }));
+
+  BENCH_SOA("fast_sin_batch", reps, fast_sin_batch(xs, ox, SOA_COUNT));
+  BENCH_SOA("fast_cos_batch", reps, fast_cos_batch(xs, ox, SOA_COUNT));
+  BENCH_SOA("fast_atan2_batch", reps, fast_atan2_batch(ys, xs, ox, SOA_COUNT));
+  BENCH_SOA("fast_exp_batch", reps, fast_exp_batch(xs, ox, SOA_COUNT));
+  BENCH_SOA("fast_rsqrt_batch", reps, fast_rsqrt_batch(box_in[3], ox, SOA_COUNT));
+  BENCH_SOA("fast_norm2_soa", reps, fast_norm2_soa(xs, ys, ox, oy, SOA_COUNT));
+
+  frustum fr = frustum_from_m4(m4_mul(m4_perspective(1.2f, 1.5f, 0.1f, 10.0f),
+                                      m4_look_at((vec3) { 0.5f, 0.5f, 2.0f }, (vec3) { 0.0f, 0.0f, 0.0f }, (vec3) { 0.0f, 1.0f, 0.0f })));
+  sphere_soa spheres = { xs, ys, zs, radii };
+  sphere probe = { { 0.1f, 0.2f, 0.3f }, 0.5f };
+  ray pick = { { -2.0f, 0.1f, 0.2f }, { 1.0f, 0.05f, 0.02f } };
+
+  BENCH_SOA("frustum_cull_aabbs_soa", reps, frustum_cull_aabbs_soa(&fr, &boxes, mask, SOA_COUNT));
+  BENCH_SOA("frustum_cull_spheres_soa", reps, frustum_cull_spheres_soa(&fr, &spheres, mask, SOA_COUNT));
+  BENCH_SOA("sphere_overlap_soa", reps, sphere_overlap_soa(&probe, &spheres, mask, SOA_COUNT));
+  BENCH_SOA("ray_aabbs_soa", reps, ray_aabbs_soa(&pick, &boxes, ox, SOA_COUNT));
+  for (size_t i = 0; i < SOA_COUNT; ++i) sink += mask[i];
+  consume(ox, sizeof(ox));
+  consume(box_out, sizeof(box_out));
+
+  return 0;
+}
@@ -0,0 +1,337 @@
+#ifndef EMM_BATCH_H_
+#define EMM_BATCH_H_
+
+#include <emm/simd.h>
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <float.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <emm/types.h>
+#include <emm/mat.h>
+
+// Structure-of-arrays batch kernels. Each kernel processes EMM_BATCH_LANES
+// elements per iteration (8 with AVX, 4 with SSE/NEON, 1 otherwise); a
+// trailing partial block is run through the same code on a padded copy.
+// Inputs and outputs may alias exactly (in-place transforms are fine), but
+// must not partially overlap.
+//
+// The __emm_batch_* lane operations are also the building blocks for the
+// approximations in emm/fast.h. __emm_batch_rsqrt_est is only a starting
+// estimate (about 12 bits with SSE/AVX, 8 with NEON, 5 for the scalar bit
+// trick) and needs Newton steps; __emm_batch_from_int_bits reinterprets the
+// integral value of each lane as float bits.
+
+#if defined(EMM_SIMD_AVX)
+
+#define EMM_BATCH_LANES 8
+typedef __m256 __emm_batch_f;
+static inline __emm_batch_f __emm_batch_load(const float *p) { return _mm256_loadu_ps(p); }
+static inline void __emm_batch_store(float *p, __emm_batch_f a) { _mm256_storeu_ps(p, a); }
+static inline __emm_batch_f __emm_batch_set1(float s) { return _mm256_set1_ps(s); }
+static inline __emm_batch_f __emm_batch_add(__emm_batch_f a, __emm_batch_f b) { return _mm256_add_ps(a, b); }
+static inline __emm_batch_f __emm_batch_sub(__emm_batch_f a, __emm_batch_f b) { return _mm256_sub_ps(a, b); }
+static inline __emm_batch_f __emm_batch_mul(__emm_batch_f a, __emm_batch_f b) { return _mm256_mul_ps(a, b); }
+static inline __emm_batch_f __emm_batch_div(__emm_batch_f a, __emm_batch_f b) { return _mm256_div_ps(a, b); }
+static inline __emm_batch_f __emm_batch_max(__emm_batch_f a, __emm_batch_f b) { return _mm256_max_ps(a, b); }
+static inline __emm_batch_f __emm_batch_sqrt(__emm_batch_f a) { return _mm256_sqrt_ps(a); }
+static inline __emm_batch_f __emm_batch_abs(__emm_batch_f a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline __emm_batch_f __emm_batch_min(__emm_batch_f a, __emm_batch_f b) { return _mm256_min_ps(a, b); }
+static inline __emm_batch_f __emm_batch_copysign(__emm_batch_f mag, __emm_batch_f sign) {
+  __m256 s = _mm256_set1_ps(-0.0f);
+  return _mm256_or_ps(_mm256_andnot_ps(s, mag), _mm256_and_ps(s, sign));
+}
+static inline __emm_batch_f __emm_batch_rsqrt_est(__emm_batch_f a) { return _mm256_rsqrt_ps(a); }
+static inline __emm_batch_f __emm_batch_from_int_bits(__emm_batch_f a) { return _mm256_castsi256_ps(_mm256_cvtps_epi32(a)); }
+typedef __m256 __emm_batch_mask;
+static inline __emm_batch_mask __emm_batch_gt(__emm_batch_f a, __emm_batch_f b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline __emm_batch_mask __emm_batch_lt(__emm_batch_f a, __emm_batch_f b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline __emm_batch_f __emm_batch_select(__emm_batch_mask m, __emm_batch_f a, __emm_batch_f b) { return _mm256_blendv_ps(b, a, m); }
+static inline int __emm_batch_movemask(__emm_batch_mask m) { return _mm256_movemask_ps(m); }
+
+#elif defined(EMM_SIMD_SSE)
+
+#define EMM_BATCH_LANES 4
+typedef __m128 __emm_batch_f;
+static inline __emm_batch_f __emm_batch_load(const float *p) { return _mm_loadu_ps(p); }
+static inline void __emm_batch_store(float *p, __emm_batch_f a) { _mm_storeu_ps(p, a); }
+static inline __emm_batch_f __emm_batch_set1(float s) { return _mm_set1_ps(s); }
+static inline __emm_batch_f __emm_batch_add(__emm_batch_f a, __emm_batch_f b) { return _mm_add_ps(a, b); }
+static inline __emm_batch_f __emm_batch_sub(__emm_batch_f a, __emm_batch_f b) { return _mm_sub_ps(a, b); }
+static inline __emm_batch_f __emm_batch_mul(__emm_batch_f a, __emm_batch_f b) { return _mm_mul_ps(a, b); }
+static inline __emm_batch_f __emm_batch_div(__emm_batch_f a, __emm_batch_f b) { return _mm_div_ps(a, b); }
+static inline __emm_batch_f __emm_batch_max(__emm_batch_f a, __emm_batch_f b) { return _mm_max_ps(a, b); }
+static inline __emm_batch_f __emm_batch_sqrt(__emm_batch_f a) { return _mm_sqrt_ps(a); }
+static inline __emm_batch_f __emm_batch_abs(__emm_batch_f a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline __emm_batch_f __emm_batch_min(__emm_batch_f a, __emm_batch_f b) { return _mm_min_ps(a, b); }
+static inline __emm_batch_f __emm_batch_copysign(__emm_batch_f mag, __emm_batch_f sign) {
+  __m128 s = _mm_set1_ps(-0.0f);
+  return _mm_or_ps(_mm_andnot_ps(s, mag), _mm_and_ps(s, sign));
+}
+static inline __emm_batch_f __emm_batch_rsqrt_est(__emm_batch_f a) { return _mm_rsqrt_ps(a); }
+static inline __emm_batch_f __emm_batch_from_int_bits(__emm_batch_f a) { return _mm_castsi128_ps(_mm_cvtps_epi32(a)); }
+typedef __m128 __emm_batch_mask;
+static inline __emm_batch_mask __emm_batch_gt(__emm_batch_f a, __emm_batch_f b) { return _mm_cmpgt_ps(a, b); }
+static inline __emm_batch_mask __emm_batch_lt(__emm_batch_f a, __emm_batch_f b) { return _mm_cmplt_ps(a, b); }
+static inline __emm_batch_f __emm_batch_select(__emm_batch_mask m, __emm_batch_f a, __emm_batch_f b) {
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+static inline int __emm_batch_movemask(__emm_batch_mask m) { return _mm_movemask_ps(m); }
+
+#elif defined(EMM_SIMD_NEON)
+
+#define EMM_BATCH_LANES 4
+typedef float32x4_t __emm_batch_f;
+static inline __emm_batch_f __emm_batch_load(const float *p) { return vld1q_f32(p); }
+static inline void __emm_batch_store(float *p, __emm_batch_f a) { vst1q_f32(p, a); }
+static inline __emm_batch_f __emm_batch_set1(float s) { return vdupq_n_f32(s); }
+static inline __emm_batch_f __emm_batch_add(__emm_batch_f a, __emm_batch_f b) { return vaddq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_sub(__emm_batch_f a, __emm_batch_f b) { return vsubq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_mul(__emm_batch_f a, __emm_batch_f b) { return vmulq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_div(__emm_batch_f a, __emm_batch_f b) { return vdivq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_max(__emm_batch_f a, __emm_batch_f b) { return vmaxq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_sqrt(__emm_batch_f a) { return vsqrtq_f32(a); }
+static inline __emm_batch_f __emm_batch_abs(__emm_batch_f a) { return vabsq_f32(a); }
+static inline __emm_batch_f __emm_batch_min(__emm_batch_f a, __emm_batch_f b) { return vminq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_copysign(__emm_batch_f mag, __emm_batch_f sign) {
+  return vbslq_f32(vdupq_n_u32(0x80000000u), sign, mag);
+}
+static inline __emm_batch_f __emm_batch_rsqrt_est(__emm_batch_f a) { return vrsqrteq_f32(a); }
+static inline __emm_batch_f __emm_batch_from_int_bits(__emm_batch_f a) { return vreinterpretq_f32_s32(vcvtnq_s32_f32(a)); }
+typedef uint32x4_t __emm_batch_mask;
+static inline __emm_batch_mask __emm_batch_gt(__emm_batch_f a, __emm_batch_f b) { return vcgtq_f32(a, b); }
+static inline __emm_batch_mask __emm_batch_lt(__emm_batch_f a, __emm_batch_f b) { return vcltq_f32(a, b); }
+static inline __emm_batch_f __emm_batch_select(__emm_batch_mask m, __emm_batch_f a, __emm_batch_f b) { return vbslq_f32(m, a, b); }
+static inline int __emm_batch_movemask(__emm_batch_mask m) {
+  return (int)((vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 2) |
+               (vgetq_lane_u32(m, 2) & 4) | (vgetq_lane_u32(m, 3) & 8));
+}
+
+#else
+
+#define EMM_BATCH_LANES 1
+typedef float __emm_batch_f;
+static inline __emm_batch_f __emm_batch_load(const float *p) { return *p; }
+static inline void __emm_batch_store(float *p, __emm_batch_f a) { *p = a; }
+static inline __emm_batch_f __emm_batch_set1(float s) { return s; }
+static inline __emm_batch_f __emm_batch_add(__emm_batch_f a, __emm_batch_f b) { return a + b; }
+static inline __emm_batch_f __emm_batch_sub(__emm_batch_f a, __emm_batch_f b) { return a - b; }
+static inline __emm_batch_f __emm_batch_mul(__emm_batch_f a, __emm_batch_f b) { return a * b; }
+static inline __emm_batch_f __emm_batch_div(__emm_batch_f a, __emm_batch_f b) { return a / b; }
+static inline __emm_batch_f __emm_batch_max(__emm_batch_f a, __emm_batch_f b) { return a > b ? a : b; }
+static inline __emm_batch_f __emm_batch_sqrt(__emm_batch_f a) { return sqrtf(a); }
+static inline __emm_batch_f __emm_batch_abs(__emm_batch_f a) { return fabsf(a); }
+static inline __emm_batch_f __emm_batch_min(__emm_batch_f a, __emm_batch_f b) { return a < b ? a : b; }
+static inline __emm_batch_f __emm_batch_copysign(__emm_batch_f mag, __emm_batch_f sign) { return copysignf(mag, sign); }
+static inline __emm_batch_f __emm_batch_rsqrt_est(__emm_batch_f a) {
+  uint32_t i;
+  memcpy(&i, &a, sizeof(i));
+  i = 0x5f375a86u - (i >> 1);
+  memcpy(&a, &i, sizeof(a));
+  return a;
+}
+static inline __emm_batch_f __emm_batch_from_int_bits(__emm_batch_f a) {
+  int32_t i = (int32_t)a;
+  memcpy(&a, &i, sizeof(a));
+  return a;
+}
+typedef bool __emm_batch_mask;
+static inline __emm_batch_mask __emm_batch_gt(__emm_batch_f a, __emm_batch_f b) { return a > b; }
+static inline __emm_batch_mask __emm_batch_lt(__emm_batch_f a, __emm_batch_f b) { return a < b; }
+static inline __emm_batch_f __emm_batch_select(__emm_batch_mask m, __emm_batch_f a, __emm_batch_f b) { return m ? a : b; }
+static inline int __emm_batch_movemask(__emm_batch_mask m) { return m ? 1 : 0; }
+
+#endif
+
+// Upper 3x4 of a mat4 (row i, column j), broadcast across all lanes.
+typedef struct __emm_batch_m34_t {
+  __emm_batch_f m[3][4];
+} __emm_batch_m34;
+
+static inline __emm_batch_m34 __emm_batch_m34_from_m4(const mat4 *m) {
+  __emm_batch_m34 r;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 4; ++j)
+      r.m[i][j] = __emm_batch_set1(m->columns[j].raw[i]);
+  return r;
+}
+
+// Rows 0..2 of M * (x, y, z, w) for one block, where `translate` selects
+// between points (w = 1) and directions (w = 0).
+static inline __emm_batch_f __emm_batch_dot_row(const __emm_batch_m34 *bm, int i, bool translate,
+                                        __emm_batch_f x, __emm_batch_f y, __emm_batch_f z) {
+  __emm_batch_f r = __emm_batch_mul(bm->m[i][0], x);
+  r = __emm_batch_add(r, __emm_batch_mul(bm->m[i][1], y));
+  r = __emm_batch_add(r, __emm_batch_mul(bm->m[i][2], z));
+  return translate ? __emm_batch_add(r, bm->m[i][3]) : r;
+}
+
+static inline void __emm_batch_xform(const __emm_batch_m34 *bm, bool translate,
+                                 __emm_batch_f x, __emm_batch_f y, __emm_batch_f z,
+                                 __emm_batch_f *ox, __emm_batch_f *oy, __emm_batch_f *oz) {
+  *ox = __emm_batch_dot_row(bm, 0, translate, x, y, z);
+  *oy = __emm_batch_dot_row(bm, 1, translate, x, y, z);
+  *oz = __emm_batch_dot_row(bm, 2, translate, x, y, z);
+}
+
+// A trailing partial block is copied into zero-padded scratch lanes so the
+// kernels never read or write past `n`.
+static inline void __emm_batch_pad(float *dst, const float *src, size_t rem) {
+  for (size_t l = 0; l < EMM_BATCH_LANES; ++l) dst[l] = l < rem ? src[l] : 0.0f;
+}
+
+static inline void __emm_batch_unpad(float *dst, const float *src, size_t rem) {
+  for (size_t l = 0; l < rem; ++l) dst[l] = src[l];
+}
+
+static inline void __emm_batch_points_block(const __emm_batch_m34 *bm,
+                                        const float *xs, const float *ys, const float *zs,
+                                        float *out_x, float *out_y, float *out_z) {
+  __emm_batch_f x, y, z;
+  __emm_batch_xform(bm, true, __emm_batch_load(xs), __emm_batch_load(ys), __emm_batch_load(zs), &x, &y, &z);
+  __emm_batch_store(out_x, x);
+  __emm_batch_store(out_y, y);
+  __emm_batch_store(out_z, z);
+}
+
+// out = M * (x, y, z, 1). The bottom row of M is ignored, i.e. M is treated
+// as an affine transform and no perspective divide happens.
+static inline void transform_points_soa(const mat4 *m,
+                                        const float *xs, const float *ys, const float *zs,
+                                        float *out_x, float *out_y, float *out_z, size_t n) {
+  __emm_batch_m34 bm = __emm_batch_m34_from_m4(m);
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES)
+    __emm_batch_points_block(&bm, xs + i, ys + i, zs + i, out_x + i, out_y + i, out_z + i);
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[6][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], xs + i, rem);
+    __emm_batch_pad(t[1], ys + i, rem);
+    __emm_batch_pad(t[2], zs + i, rem);
+    __emm_batch_points_block(&bm, t[0], t[1], t[2], t[3], t[4], t[5]);
+    __emm_batch_unpad(out_x + i, t[3], rem);
+    __emm_batch_unpad(out_y + i, t[4], rem);
+    __emm_batch_unpad(out_z + i, t[5], rem);
+  }
+}
+
+static inline void __emm_batch_normals_block(const __emm_batch_m34 *bm,
+                                         const float *xs, const float *ys, const float *zs,
+                                         float *out_x, float *out_y, float *out_z) {
+  __emm_batch_f x, y, z;
+  __emm_batch_xform(bm, false, __emm_batch_load(xs), __emm_batch_load(ys), __emm_batch_load(zs), &x, &y, &z);
+
+  // Renormalise; zero-length normals stay zero rather than becoming NaN.
+  __emm_batch_f len2 = __emm_batch_add(__emm_batch_add(__emm_batch_mul(x, x), __emm_batch_mul(y, y)), __emm_batch_mul(z, z));
+  __emm_batch_f inv = __emm_batch_div(__emm_batch_set1(1.0f), __emm_batch_sqrt(__emm_batch_max(len2, __emm_batch_set1(FLT_MIN))));
+  __emm_batch_store(out_x, __emm_batch_mul(x, inv));
+  __emm_batch_store(out_y, __emm_batch_mul(y, inv));
+  __emm_batch_store(out_z, __emm_batch_mul(z, inv));
+}
+
+// Transforms normals by the inverse-transpose of M's upper 3x3 and
+// renormalises them, so non-uniform scale is handled correctly.
+static inline void transform_normals_soa(const mat4 *m,
+                                         const float *xs, const float *ys, const float *zs,
+                                         float *out_x, float *out_y, float *out_z, size_t n) {
+  mat3 nm = m3_transpose(m3_inverse(m3_from_m4(*m)));
+  mat4 nm4 = {0};
+  for (int j = 0; j < 3; ++j) nm4.columns[j] = v4_from_v3(nm.columns[j], 0.0f);
+  __emm_batch_m34 bm = __emm_batch_m34_from_m4(&nm4);
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES)
+    __emm_batch_normals_block(&bm, xs + i, ys + i, zs + i, out_x + i, out_y + i, out_z + i);
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[6][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], xs + i, rem);
+    __emm_batch_pad(t[1], ys + i, rem);
+    __emm_batch_pad(t[2], zs + i, rem);
+    __emm_batch_normals_block(&bm, t[0], t[1], t[2], t[3], t[4], t[5]);
+    __emm_batch_unpad(out_x + i, t[3], rem);
+    __emm_batch_unpad(out_y + i, t[4], rem);
+    __emm_batch_unpad(out_z + i, t[5], rem);
+  }
+}
+
+typedef struct aabb_soa_t {
+  float *min_x, *min_y, *min_z;
+  float *max_x, *max_y, *max_z;
+} aabb_soa;
+
+// Arvo: the new center is the transformed center, the new extent is the
+// old extent transformed by |M|.
+static inline void __emm_batch_aabbs_block(const __emm_batch_m34 *bm, const __emm_batch_m34 *abs_m,
+                                       const float *const in[6], float *const out[6]) {
+  __emm_batch_f half = __emm_batch_set1(0.5f);
+
+  __emm_batch_f center[3], extent[3];
+  for (int k = 0; k < 3; ++k) {
+    __emm_batch_f mn = __emm_batch_load(in[k]);
+    __emm_batch_f mx = __emm_batch_load(in[k + 3]);
+    center[k] = __emm_batch_mul(__emm_batch_add(mn, mx), half);
+    extent[k] = __emm_batch_mul(__emm_batch_sub(mx, mn), half);
+  }
+
+  __emm_batch_f nc[3], ne[3];
+  __emm_batch_xform(bm, true, center[0], center[1], center[2], &nc[0], &nc[1], &nc[2]);
+  __emm_batch_xform(abs_m, false, extent[0], extent[1], extent[2], &ne[0], &ne[1], &ne[2]);
+
+  for (int k = 0; k < 3; ++k) {
+    __emm_batch_store(out[k], __emm_batch_sub(nc[k], ne[k]));
+    __emm_batch_store(out[k + 3], __emm_batch_add(nc[k], ne[k]));
+  }
+}
+
+// Transforms n axis-aligned boxes by M and writes the axis-aligned bounds of
+// the results. `in` and `out` may be the same arrays.
+static inline void transform_aabbs_soa(const mat4 *m, const aabb_soa *in, const aabb_soa *out, size_t n) {
+  __emm_batch_m34 bm = __emm_batch_m34_from_m4(m);
+  __emm_batch_m34 abs_m;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 4; ++j)
+      abs_m.m[i][j] = __emm_batch_abs(bm.m[i][j]);
+
+  const float *src[6] = { in->min_x, in->min_y, in->min_z, in->max_x, in->max_y, in->max_z };
+  float *dst[6] = { out->min_x, out->min_y, out->min_z, out->max_x, out->max_y, out->max_z };
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES) {
+    const float *block_in[6];
+    float *block_out[6];
+    for (int k = 0; k < 6; ++k) {
+      block_in[k] = src[k] + i;
+      block_out[k] = dst[k] + i;
+    }
+    __emm_batch_aabbs_block(&bm, &abs_m, block_in, block_out);
+  }
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[12][EMM_BATCH_LANES];
+    const float *block_in[6];
+    float *block_out[6];
+    for (int k = 0; k < 6; ++k) {
+      __emm_batch_pad(t[k], src[k] + i, rem);
+      block_in[k] = t[k];
+      block_out[k] = t[k + 6];
+    }
+    __emm_batch_aabbs_block(&bm, &abs_m, block_in, block_out);
+    for (int k = 0; k < 6; ++k) __emm_batch_unpad(dst[k] + i, t[k + 6], rem);
+  }
+}
+
+HEADER_END
+
+#endif // EMM_BATCH_H_
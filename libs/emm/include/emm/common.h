@@ -0,0 +1,14 @@
+#ifndef EMM_COMMON_H_
+#define EMM_COMMON_H_
+
+#ifndef HEADER_BEGIN
+  #ifdef __cplusplus
+    #define HEADER_BEGIN extern "C" {
+    #define HEADER_END }
+  #else
+    #define HEADER_BEGIN
+    #define HEADER_END
+  #endif
+#endif
+
+#endif // EMM_COMMON_H_
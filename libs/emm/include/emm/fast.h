@@ -0,0 +1,353 @@
+#ifndef EMM_FAST_H_
+#define EMM_FAST_H_
+
+#include <emm/simd.h>
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <float.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <emm/types.h>
+#include <emm/batch.h>
+
+// Fast approximations for hot paths (particles, steering, ...) where libm's
+// last-ulp accuracy is wasted. This header is opt-in and not pulled in by
+// <emm.h>.
+//
+// Max errors, measured against double precision over the stated ranges:
+//
+//   fast_rsqrt  relative 1e-6 (SSE/AVX/NEON), 5e-6 (scalar)     x > 0
+//   fast_sin    absolute 1.5e-6                                 |x| <= 1e4
+//   fast_cos    absolute 1.5e-6                                 |x| <= 1e4
+//   fast_atan2  absolute 2e-6 rad                               finite y, x
+//   fast_exp    relative 3e-7                                   -87.3 <= x <= 88.3
+//
+// fast_exp saturates outside its range (to ~1.2e-38 below, ~2.4e38 above)
+// instead of flushing to zero or overflowing to infinity, and
+// fast_atan2(±0, -0) returns ±0 rather than ±pi.
+//
+// The *_batch variants process EMM_BATCH_LANES values per iteration with the
+// same lane operations as emm/batch.h and give identical results to the
+// scalar functions, except for fast_rsqrt whose initial estimate depends on
+// the backend. `in` and `out` may alias exactly.
+//
+// Range reduction rounds with the 1.5 * 2^23 trick, so none of this survives
+// -ffast-math / -fassociative-math.
+
+#define __EMM_FAST_ROUND_MAGIC 12582912.0f
+
+#define __EMM_FAST_INV_PI 0.318309886183790671538f
+#define __EMM_FAST_HALF_PI 1.57079632679489661923f
+#define __EMM_FAST_PI 3.14159265358979323846f
+
+// pi split so that k * __EMM_FAST_PI_A and k * __EMM_FAST_PI_B are exact.
+#define __EMM_FAST_PI_A 3.140625f
+#define __EMM_FAST_PI_B 0.0009670257568359375f
+#define __EMM_FAST_PI_C 6.2771141529083251953e-07f
+
+// sin(r) ~ r + r^3 * (S3 + r^2 * (S5 + r^2 * S7)) on [-pi/2, pi/2].
+#define __EMM_FAST_SIN_S3 -1.6665681056e-01f
+#define __EMM_FAST_SIN_S5 8.3123660366e-03f
+#define __EMM_FAST_SIN_S7 -1.8492177316e-04f
+
+// atan(t) ~ t * (A1 + t^2 * (A3 + ...)) on [0, 1].
+#define __EMM_FAST_ATAN_A1 9.9997722168e-01f
+#define __EMM_FAST_ATAN_A3 -3.3262285240e-01f
+#define __EMM_FAST_ATAN_A5 1.9354043848e-01f
+#define __EMM_FAST_ATAN_A7 -1.1642652050e-01f
+#define __EMM_FAST_ATAN_A9 5.2647319141e-02f
+#define __EMM_FAST_ATAN_A11 -1.1719105191e-02f
+
+// e^r ~ 1 + r + r^2 * (E2 + r * (E3 + r * (E4 + r * E5))) on [-ln2/2, ln2/2].
+#define __EMM_FAST_EXP_E2 4.9999231658e-01f
+#define __EMM_FAST_EXP_E3 1.6667114001e-01f
+#define __EMM_FAST_EXP_E4 4.1890130283e-02f
+#define __EMM_FAST_EXP_E5 8.3125824085e-03f
+#define __EMM_FAST_LOG2E 1.44269504088896341f
+#define __EMM_FAST_LN2_HI 0.693145751953125f
+#define __EMM_FAST_LN2_LO 1.428606765330187045e-06f
+#define __EMM_FAST_EXP_MIN -87.33f
+#define __EMM_FAST_EXP_MAX 88.37f
+
+// Scalar
+
+static inline float __emm_fast_round(float x) {
+  return (x + __EMM_FAST_ROUND_MAGIC) - __EMM_FAST_ROUND_MAGIC;
+}
+
+static inline float __emm_fast_sin_poly(float r) {
+  float r2 = r * r;
+  return r + r * r2 * (__EMM_FAST_SIN_S3 + r2 * (__EMM_FAST_SIN_S5 + r2 * __EMM_FAST_SIN_S7));
+}
+
+static inline float __emm_fast_reduce_pi(float x, float k) {
+  float r = x - k * __EMM_FAST_PI_A;
+  r -= k * __EMM_FAST_PI_B;
+  return r - k * __EMM_FAST_PI_C;
+}
+
+// One Newton-Raphson step for 1/sqrt(x) from the estimate y.
+static inline float __emm_fast_rsqrt_step(float x, float y) {
+  return y * (1.5f - 0.5f * x * y * y);
+}
+
+static inline float fast_rsqrt(float x) {
+#if defined(EMM_SIMD_SSE)
+  float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+  return __emm_fast_rsqrt_step(x, y);
+#elif defined(EMM_SIMD_NEON)
+  float32x4_t v = vdupq_n_f32(x);
+  float32x4_t y = vrsqrteq_f32(v);
+  y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(v, y), y));
+  y = vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(v, y), y));
+  return vgetq_lane_f32(y, 0);
+#else
+  uint32_t i;
+  memcpy(&i, &x, sizeof(i));
+  i = 0x5f375a86u - (i >> 1);
+  float y;
+  memcpy(&y, &i, sizeof(y));
+  y = __emm_fast_rsqrt_step(x, y);
+  return __emm_fast_rsqrt_step(x, y);
+#endif
+}
+
+static inline float fast_sin(float x) {
+  float k = __emm_fast_round(x * __EMM_FAST_INV_PI);
+  float s = __emm_fast_sin_poly(__emm_fast_reduce_pi(x, k));
+  // sin(r + k*pi) = (-1)^k * sin(r)
+  float parity = k - 2.0f * __emm_fast_round(k * 0.5f);
+  return parity != 0.0f ? -s : s;
+}
+
+static inline float fast_cos(float x) {
+  // x = r + (k + 1/2) * pi with r in [-pi/2, pi/2], so
+  // cos(x) = -sin(r + k*pi) = -(-1)^k * sin(r).
+  float k = __emm_fast_round(x * __EMM_FAST_INV_PI - 0.5f);
+  float s = __emm_fast_sin_poly(__emm_fast_reduce_pi(x, k + 0.5f));
+  float parity = k - 2.0f * __emm_fast_round(k * 0.5f);
+  return parity != 0.0f ? s : -s;
+}
+
+static inline void fast_sincos(float x, float *s, float *c) {
+  *s = fast_sin(x);
+  *c = fast_cos(x);
+}
+
+static inline float __emm_fast_atan_poly(float t) {
+  float t2 = t * t;
+  float p = __EMM_FAST_ATAN_A11;
+  p = p * t2 + __EMM_FAST_ATAN_A9;
+  p = p * t2 + __EMM_FAST_ATAN_A7;
+  p = p * t2 + __EMM_FAST_ATAN_A5;
+  p = p * t2 + __EMM_FAST_ATAN_A3;
+  p = p * t2 + __EMM_FAST_ATAN_A1;
+  return p * t;
+}
+
+static inline float fast_atan2(float y, float x) {
+  float ax = fabsf(x), ay = fabsf(y);
+  float mn = ax < ay ? ax : ay;
+  float mx = ax > ay ? ax : ay;
+  float a = __emm_fast_atan_poly(mn / (mx > FLT_MIN ? mx : FLT_MIN));
+  if (ay > ax) a = __EMM_FAST_HALF_PI - a;
+  if (x < 0.0f) a = __EMM_FAST_PI - a;
+  return copysignf(a, y);
+}
+
+static inline float fast_exp(float x) {
+  x = x < __EMM_FAST_EXP_MIN ? __EMM_FAST_EXP_MIN : (x > __EMM_FAST_EXP_MAX ? __EMM_FAST_EXP_MAX : x);
+  float k = __emm_fast_round(x * __EMM_FAST_LOG2E);
+  float r = x - k * __EMM_FAST_LN2_HI;
+  r -= k * __EMM_FAST_LN2_LO;
+  float p = __EMM_FAST_EXP_E2 + r * (__EMM_FAST_EXP_E3 + r * (__EMM_FAST_EXP_E4 + r * __EMM_FAST_EXP_E5));
+  p = 1.0f + r + r * r * p;
+  // 2^k built directly from its exponent bits.
+  uint32_t bits = (uint32_t)((int32_t)k + 127) << 23;
+  float scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+static inline float v2_len_fast(vec2 a) {
+  float l2 = v2_len2(a);
+  if (l2 == 0) return 0.0f;
+  return l2 * fast_rsqrt(l2);
+}
+
+static inline vec2 v2_norm_fast(vec2 a) {
+  float l2 = v2_len2(a);
+  if (l2 == 0) return (vec2){0};
+  return v2_muls(a, fast_rsqrt(l2));
+}
+
+static inline float v3_len_fast(vec3 a) {
+  float l2 = v3_len2(a);
+  if (l2 == 0) return 0.0f;
+  return l2 * fast_rsqrt(l2);
+}
+
+static inline vec3 v3_norm_fast(vec3 a) {
+  float l2 = v3_len2(a);
+  if (l2 == 0) return (vec3){0};
+  return v3_muls(a, fast_rsqrt(l2));
+}
+
+// Lanes
+
+static inline __emm_batch_f __emm_fast_round_lanes(__emm_batch_f x) {
+  __emm_batch_f magic = __emm_batch_set1(__EMM_FAST_ROUND_MAGIC);
+  return __emm_batch_sub(__emm_batch_add(x, magic), magic);
+}
+
+static inline __emm_batch_f __emm_fast_rsqrt_lanes(__emm_batch_f x) {
+  __emm_batch_f y = __emm_batch_rsqrt_est(x);
+  __emm_batch_f half_x = __emm_batch_mul(x, __emm_batch_set1(0.5f));
+  __emm_batch_f three_halves = __emm_batch_set1(1.5f);
+#if !defined(EMM_SIMD_SSE)
+  // NEON and the bit trick start from a coarser estimate.
+  y = __emm_batch_mul(y, __emm_batch_sub(three_halves, __emm_batch_mul(half_x, __emm_batch_mul(y, y))));
+#endif
+  return __emm_batch_mul(y, __emm_batch_sub(three_halves, __emm_batch_mul(half_x, __emm_batch_mul(y, y))));
+}
+
+static inline __emm_batch_f __emm_fast_sin_poly_lanes(__emm_batch_f r) {
+  __emm_batch_f r2 = __emm_batch_mul(r, r);
+  __emm_batch_f p = __emm_batch_add(__emm_batch_set1(__EMM_FAST_SIN_S5), __emm_batch_mul(r2, __emm_batch_set1(__EMM_FAST_SIN_S7)));
+  p = __emm_batch_add(__emm_batch_set1(__EMM_FAST_SIN_S3), __emm_batch_mul(r2, p));
+  return __emm_batch_add(r, __emm_batch_mul(__emm_batch_mul(r, r2), p));
+}
+
+static inline __emm_batch_f __emm_fast_reduce_pi_lanes(__emm_batch_f x, __emm_batch_f k) {
+  __emm_batch_f r = __emm_batch_sub(x, __emm_batch_mul(k, __emm_batch_set1(__EMM_FAST_PI_A)));
+  r = __emm_batch_sub(r, __emm_batch_mul(k, __emm_batch_set1(__EMM_FAST_PI_B)));
+  return __emm_batch_sub(r, __emm_batch_mul(k, __emm_batch_set1(__EMM_FAST_PI_C)));
+}
+
+// 1 for even k, -1 for odd k. For odd k, k/2 is a tie that may round either
+// way, hence the abs.
+static inline __emm_batch_f __emm_fast_parity_sign_lanes(__emm_batch_f k) {
+  __emm_batch_f half_k = __emm_batch_mul(k, __emm_batch_set1(0.5f));
+  __emm_batch_f parity = __emm_batch_abs(__emm_batch_sub(k, __emm_batch_mul(__emm_batch_set1(2.0f), __emm_fast_round_lanes(half_k))));
+  return __emm_batch_sub(__emm_batch_set1(1.0f), __emm_batch_mul(__emm_batch_set1(2.0f), parity));
+}
+
+static inline __emm_batch_f __emm_fast_sin_lanes(__emm_batch_f x) {
+  __emm_batch_f k = __emm_fast_round_lanes(__emm_batch_mul(x, __emm_batch_set1(__EMM_FAST_INV_PI)));
+  __emm_batch_f s = __emm_fast_sin_poly_lanes(__emm_fast_reduce_pi_lanes(x, k));
+  return __emm_batch_mul(s, __emm_fast_parity_sign_lanes(k));
+}
+
+static inline __emm_batch_f __emm_fast_cos_lanes(__emm_batch_f x) {
+  __emm_batch_f half = __emm_batch_set1(0.5f);
+  __emm_batch_f k = __emm_fast_round_lanes(__emm_batch_sub(__emm_batch_mul(x, __emm_batch_set1(__EMM_FAST_INV_PI)), half));
+  __emm_batch_f s = __emm_fast_sin_poly_lanes(__emm_fast_reduce_pi_lanes(x, __emm_batch_add(k, half)));
+  return __emm_batch_mul(s, __emm_batch_sub(__emm_batch_set1(0.0f), __emm_fast_parity_sign_lanes(k)));
+}
+
+static inline __emm_batch_f __emm_fast_atan2_lanes(__emm_batch_f y, __emm_batch_f x) {
+  __emm_batch_f ax = __emm_batch_abs(x), ay = __emm_batch_abs(y);
+  __emm_batch_f mn = __emm_batch_min(ax, ay);
+  __emm_batch_f mx = __emm_batch_max(ax, ay);
+  __emm_batch_f t = __emm_batch_div(mn, __emm_batch_max(mx, __emm_batch_set1(FLT_MIN)));
+  __emm_batch_f t2 = __emm_batch_mul(t, t);
+
+  __emm_batch_f p = __emm_batch_set1(__EMM_FAST_ATAN_A11);
+  p = __emm_batch_add(__emm_batch_mul(p, t2), __emm_batch_set1(__EMM_FAST_ATAN_A9));
+  p = __emm_batch_add(__emm_batch_mul(p, t2), __emm_batch_set1(__EMM_FAST_ATAN_A7));
+  p = __emm_batch_add(__emm_batch_mul(p, t2), __emm_batch_set1(__EMM_FAST_ATAN_A5));
+  p = __emm_batch_add(__emm_batch_mul(p, t2), __emm_batch_set1(__EMM_FAST_ATAN_A3));
+  p = __emm_batch_add(__emm_batch_mul(p, t2), __emm_batch_set1(__EMM_FAST_ATAN_A1));
+  __emm_batch_f a = __emm_batch_mul(p, t);
+
+  a = __emm_batch_select(__emm_batch_gt(ay, ax), __emm_batch_sub(__emm_batch_set1(__EMM_FAST_HALF_PI), a), a);
+  a = __emm_batch_select(__emm_batch_lt(x, __emm_batch_set1(0.0f)), __emm_batch_sub(__emm_batch_set1(__EMM_FAST_PI), a), a);
+  return __emm_batch_copysign(a, y);
+}
+
+static inline __emm_batch_f __emm_fast_exp_lanes(__emm_batch_f x) {
+  x = __emm_batch_max(__emm_batch_min(x, __emm_batch_set1(__EMM_FAST_EXP_MAX)), __emm_batch_set1(__EMM_FAST_EXP_MIN));
+  __emm_batch_f k = __emm_fast_round_lanes(__emm_batch_mul(x, __emm_batch_set1(__EMM_FAST_LOG2E)));
+  __emm_batch_f r = __emm_batch_sub(x, __emm_batch_mul(k, __emm_batch_set1(__EMM_FAST_LN2_HI)));
+  r = __emm_batch_sub(r, __emm_batch_mul(k, __emm_batch_set1(__EMM_FAST_LN2_LO)));
+
+  __emm_batch_f p = __emm_batch_add(__emm_batch_set1(__EMM_FAST_EXP_E4), __emm_batch_mul(r, __emm_batch_set1(__EMM_FAST_EXP_E5)));
+  p = __emm_batch_add(__emm_batch_set1(__EMM_FAST_EXP_E3), __emm_batch_mul(r, p));
+  p = __emm_batch_add(__emm_batch_set1(__EMM_FAST_EXP_E2), __emm_batch_mul(r, p));
+  p = __emm_batch_add(__emm_batch_add(__emm_batch_set1(1.0f), r), __emm_batch_mul(__emm_batch_mul(r, r), p));
+
+  // (k + 127) * 2^23 is exact, and its integer value is the bit pattern of 2^k.
+  __emm_batch_f e = __emm_batch_mul(__emm_batch_add(k, __emm_batch_set1(127.0f)), __emm_batch_set1(8388608.0f));
+  return __emm_batch_mul(p, __emm_batch_from_int_bits(e));
+}
+
+// Batches
+
+#define __EMM_FAST_UNARY_BATCH(name, lanes)                               \
+  static inline void name(const float *in, float *out, size_t n) {        \
+    size_t i = 0;                                                         \
+    for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES)                \
+      __emm_batch_store(out + i, lanes(__emm_batch_load(in + i)));        \
+    if (i < n) {                                                          \
+      size_t rem = n - i;                                                 \
+      float t[EMM_BATCH_LANES];                                           \
+      __emm_batch_pad(t, in + i, rem);                                    \
+      __emm_batch_store(t, lanes(__emm_batch_load(t)));                   \
+      __emm_batch_unpad(out + i, t, rem);                                 \
+    }                                                                     \
+  }
+
+__EMM_FAST_UNARY_BATCH(fast_rsqrt_batch, __emm_fast_rsqrt_lanes)
+__EMM_FAST_UNARY_BATCH(fast_sin_batch, __emm_fast_sin_lanes)
+__EMM_FAST_UNARY_BATCH(fast_cos_batch, __emm_fast_cos_lanes)
+__EMM_FAST_UNARY_BATCH(fast_exp_batch, __emm_fast_exp_lanes)
+
+#undef __EMM_FAST_UNARY_BATCH
+
+static inline void fast_atan2_batch(const float *ys, const float *xs, float *out, size_t n) {
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES)
+    __emm_batch_store(out + i, __emm_fast_atan2_lanes(__emm_batch_load(ys + i), __emm_batch_load(xs + i)));
+  if (i < n) {
+    size_t rem = n - i;
+    float t[2][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], ys + i, rem);
+    __emm_batch_pad(t[1], xs + i, rem);
+    __emm_batch_store(t[0], __emm_fast_atan2_lanes(__emm_batch_load(t[0]), __emm_batch_load(t[1])));
+    __emm_batch_unpad(out + i, t[0], rem);
+  }
+}
+
+static inline void __emm_fast_norm2_block(const float *xs, const float *ys, float *out_x, float *out_y) {
+  __emm_batch_f x = __emm_batch_load(xs), y = __emm_batch_load(ys);
+  __emm_batch_f len2 = __emm_batch_add(__emm_batch_mul(x, x), __emm_batch_mul(y, y));
+  __emm_batch_f inv = __emm_fast_rsqrt_lanes(__emm_batch_max(len2, __emm_batch_set1(FLT_MIN)));
+  __emm_batch_store(out_x, __emm_batch_mul(x, inv));
+  __emm_batch_store(out_y, __emm_batch_mul(y, inv));
+}
+
+// Normalises n 2D vectors stored as separate x / y arrays. Zero vectors stay
+// zero; vectors shorter than ~1e-19 come out shorter than unit length.
+static inline void fast_norm2_soa(const float *xs, const float *ys, float *out_x, float *out_y, size_t n) {
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES)
+    __emm_fast_norm2_block(xs + i, ys + i, out_x + i, out_y + i);
+  if (i < n) {
+    size_t rem = n - i;
+    float t[4][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], xs + i, rem);
+    __emm_batch_pad(t[1], ys + i, rem);
+    __emm_fast_norm2_block(t[0], t[1], t[2], t[3]);
+    __emm_batch_unpad(out_x + i, t[2], rem);
+    __emm_batch_unpad(out_y + i, t[3], rem);
+  }
+}
+
+HEADER_END
+
+#endif // EMM_FAST_H_
@@ -0,0 +1,427 @@
+#ifndef EMM_GEOMETRY_H_
+#define EMM_GEOMETRY_H_
+
+#include <emm/simd.h>
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <float.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <emm/types.h>
+#include <emm/mat.h>
+#include <emm/batch.h>
+
+// Bounding volumes and intersection tests for culling and picking.
+//
+// Planes are stored as dot(normal, p) + d = 0 with the normal pointing to the
+// inside, so a positive distance means "in front of / inside". Frustum planes
+// are normalised so distances are in world units.
+
+typedef struct aabb_t {
+  vec3 min, max;
+} aabb;
+
+typedef struct sphere_t {
+  vec3 center;
+  float radius;
+} sphere;
+
+typedef struct plane_t {
+  vec3 normal;
+  float d;
+} plane;
+
+typedef enum frustum_plane_t {
+  FRUSTUM_LEFT,
+  FRUSTUM_RIGHT,
+  FRUSTUM_BOTTOM,
+  FRUSTUM_TOP,
+  FRUSTUM_NEAR,
+  FRUSTUM_FAR,
+  FRUSTUM_PLANE_COUNT
+} frustum_plane;
+
+typedef struct frustum_t {
+  plane planes[FRUSTUM_PLANE_COUNT];
+} frustum;
+
+typedef struct ray_t {
+  vec3 origin;
+  vec3 dir;
+} ray;
+
+typedef struct sphere_soa_t {
+  float *x, *y, *z;
+  float *radius;
+} sphere_soa;
+
+// AABB
+
+static inline aabb aabb_from_center_extent(vec3 center, vec3 extent) {
+  return (aabb) { v3_sub(center, extent), v3_add(center, extent) };
+}
+
+static inline vec3 aabb_center(aabb b) {
+  return v3_muls(v3_add(b.min, b.max), 0.5f);
+}
+
+static inline vec3 aabb_extent(aabb b) {
+  return v3_muls(v3_sub(b.max, b.min), 0.5f);
+}
+
+static inline aabb aabb_merge(aabb a, aabb b) {
+  return (aabb) { v3_min(a.min, b.min), v3_max(a.max, b.max) };
+}
+
+static inline bool aabb_contains(aabb b, vec3 p) {
+  return p.x >= b.min.x && p.x <= b.max.x &&
+         p.y >= b.min.y && p.y <= b.max.y &&
+         p.z >= b.min.z && p.z <= b.max.z;
+}
+
+static inline bool aabb_overlap(aabb a, aabb b) {
+  return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+         a.min.y <= b.max.y && a.max.y >= b.min.y &&
+         a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// Sphere
+
+static inline bool sphere_overlap(sphere a, sphere b) {
+  float r = a.radius + b.radius;
+  return v3_len2(v3_sub(a.center, b.center)) <= r * r;
+}
+
+static inline bool sphere_aabb_overlap(sphere s, aabb b) {
+  vec3 closest = v3_min(v3_max(s.center, b.min), b.max);
+  return v3_len2(v3_sub(s.center, closest)) <= s.radius * s.radius;
+}
+
+// Plane
+
+static inline plane plane_from_point_normal(vec3 p, vec3 normal) {
+  vec3 n = v3_norm(normal);
+  return (plane) { n, -v3_dot(n, p) };
+}
+
+static inline plane plane_normalize(plane p) {
+  float l = v3_len(p.normal);
+  if (l == 0) return p;
+  float inv = 1.0f / l;
+  return (plane) { v3_muls(p.normal, inv), p.d * inv };
+}
+
+static inline float plane_distance(plane p, vec3 point) {
+  return v3_dot(p.normal, point) + p.d;
+}
+
+// Frustum
+
+// Extracts the planes of the view volume of `view_proj` (Gribb-Hartmann).
+// Assumes the 0..1 clip-space depth range produced by m4_perspective and
+// m4_ortho; pass a model-view-projection matrix to get object-space planes.
+static inline frustum frustum_from_m4(mat4 view_proj) {
+  vec4 rows[4];
+  for (int i = 0; i < 4; ++i)
+    rows[i] = (vec4) {
+      view_proj.columns[0].raw[i], view_proj.columns[1].raw[i],
+      view_proj.columns[2].raw[i], view_proj.columns[3].raw[i]
+    };
+
+  vec4 p[FRUSTUM_PLANE_COUNT] = {
+    [FRUSTUM_LEFT] = v4_add(rows[3], rows[0]),
+    [FRUSTUM_RIGHT] = v4_sub(rows[3], rows[0]),
+    [FRUSTUM_BOTTOM] = v4_add(rows[3], rows[1]),
+    [FRUSTUM_TOP] = v4_sub(rows[3], rows[1]),
+    [FRUSTUM_NEAR] = rows[2],
+    [FRUSTUM_FAR] = v4_sub(rows[3], rows[2]),
+  };
+
+  frustum f;
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+    f.planes[i] = plane_normalize((plane) { v3_from_v4(p[i]), p[i].w });
+  return f;
+}
+
+static inline bool frustum_test_sphere(const frustum *f, sphere s) {
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i)
+    if (plane_distance(f->planes[i], s.center) + s.radius < 0.0f) return false;
+  return true;
+}
+
+// Conservative: boxes that straddle two planes just outside a frustum corner
+// are reported as visible.
+static inline bool frustum_test_aabb(const frustum *f, aabb b) {
+  vec3 c = aabb_center(b), e = aabb_extent(b);
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+    const plane *p = &f->planes[i];
+    float r = fabsf(p->normal.x) * e.x + fabsf(p->normal.y) * e.y + fabsf(p->normal.z) * e.z;
+    if (plane_distance(*p, c) + r < 0.0f) return false;
+  }
+  return true;
+}
+
+// Ray
+
+// Slab test. On a hit, stores the entry distance along `r.dir` in `*t`
+// (0 when the origin is inside the box). Zero direction components are fine
+// unless the origin lies exactly on one of that axis' slab planes.
+static inline bool ray_aabb(ray r, aabb b, float *t) {
+  float t_near = 0.0f, t_far = INFINITY;
+  for (int i = 0; i < 3; ++i) {
+    float inv = 1.0f / r.dir.raw[i];
+    float t1 = (b.min.raw[i] - r.origin.raw[i]) * inv;
+    float t2 = (b.max.raw[i] - r.origin.raw[i]) * inv;
+    t_near = fmaxf(t_near, fminf(t1, t2));
+    t_far = fminf(t_far, fmaxf(t1, t2));
+  }
+  if (t_far < t_near) return false;
+  if (t) *t = t_near;
+  return true;
+}
+
+static inline bool ray_sphere(ray r, sphere s, float *t) {
+  vec3 oc = v3_sub(r.origin, s.center);
+  float a = v3_len2(r.dir);
+  float b = v3_dot(oc, r.dir);
+  float c = v3_len2(oc) - s.radius * s.radius;
+  float disc = b * b - a * c;
+  if (disc < 0.0f || a == 0.0f) return false;
+  float sq = sqrtf(disc);
+  float t_hit = (-b - sq) / a;
+  if (t_hit < 0.0f) t_hit = (-b + sq) / a;
+  if (t_hit < 0.0f) return false;
+  if (t) *t = c <= 0.0f ? 0.0f : t_hit;
+  return true;
+}
+
+// Batch tests over SoA data, EMM_BATCH_LANES (8 with AVX) elements at a time.
+
+typedef struct __emm_geometry_planes_t {
+  __emm_batch_f nx[FRUSTUM_PLANE_COUNT], ny[FRUSTUM_PLANE_COUNT], nz[FRUSTUM_PLANE_COUNT];
+  __emm_batch_f ax[FRUSTUM_PLANE_COUNT], ay[FRUSTUM_PLANE_COUNT], az[FRUSTUM_PLANE_COUNT];
+  __emm_batch_f d[FRUSTUM_PLANE_COUNT];
+} __emm_geometry_planes;
+
+static inline __emm_geometry_planes __emm_geometry_planes_from_frustum(const frustum *f) {
+  __emm_geometry_planes bp;
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+    const plane *p = &f->planes[i];
+    bp.nx[i] = __emm_batch_set1(p->normal.x);
+    bp.ny[i] = __emm_batch_set1(p->normal.y);
+    bp.nz[i] = __emm_batch_set1(p->normal.z);
+    bp.ax[i] = __emm_batch_set1(fabsf(p->normal.x));
+    bp.ay[i] = __emm_batch_set1(fabsf(p->normal.y));
+    bp.az[i] = __emm_batch_set1(fabsf(p->normal.z));
+    bp.d[i] = __emm_batch_set1(p->d);
+  }
+  return bp;
+}
+
+// Byte expansion of each 4-bit lane mask, so full blocks store 4 bools at a
+// time instead of shifting out one lane per store.
+static const uint8_t __emm_geometry_nibble_bools[16][4] = {
+  { 0, 0, 0, 0 },
+  { 1, 0, 0, 0 },
+  { 0, 1, 0, 0 },
+  { 1, 1, 0, 0 },
+  { 0, 0, 1, 0 },
+  { 1, 0, 1, 0 },
+  { 0, 1, 1, 0 },
+  { 1, 1, 1, 0 },
+  { 0, 0, 0, 1 },
+  { 1, 0, 0, 1 },
+  { 0, 1, 0, 1 },
+  { 1, 1, 0, 1 },
+  { 0, 0, 1, 1 },
+  { 1, 0, 1, 1 },
+  { 0, 1, 1, 1 },
+  { 1, 1, 1, 1 }
+};
+
+static inline void __emm_geometry_store_mask(bool *out, int bits, size_t count) {
+  if (count == EMM_BATCH_LANES && EMM_BATCH_LANES % 4 == 0) {
+    for (size_t l = 0; l < EMM_BATCH_LANES; l += 4)
+      memcpy(out + l, __emm_geometry_nibble_bools[(bits >> l) & 15], 4);
+    return;
+  }
+  for (size_t l = 0; l < count; ++l) out[l] = (bits >> l) & 1;
+}
+
+// Smallest signed plane distance of each box's support point; negative means
+// the box is fully outside at least one plane.
+static inline __emm_batch_f __emm_geometry_aabbs_block(const __emm_geometry_planes *bp, const float *const in[6]) {
+  __emm_batch_f half = __emm_batch_set1(0.5f);
+  __emm_batch_f c[3], e[3];
+  for (int k = 0; k < 3; ++k) {
+    __emm_batch_f mn = __emm_batch_load(in[k]);
+    __emm_batch_f mx = __emm_batch_load(in[k + 3]);
+    c[k] = __emm_batch_mul(__emm_batch_add(mn, mx), half);
+    e[k] = __emm_batch_mul(__emm_batch_sub(mx, mn), half);
+  }
+
+  __emm_batch_f dist = __emm_batch_set1(FLT_MAX);
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+    // Same operation order as frustum_test_aabb, so results match exactly.
+    __emm_batch_f c_dist = __emm_batch_mul(bp->nx[i], c[0]);
+    c_dist = __emm_batch_add(c_dist, __emm_batch_mul(bp->ny[i], c[1]));
+    c_dist = __emm_batch_add(c_dist, __emm_batch_mul(bp->nz[i], c[2]));
+    c_dist = __emm_batch_add(c_dist, bp->d[i]);
+    __emm_batch_f r = __emm_batch_mul(bp->ax[i], e[0]);
+    r = __emm_batch_add(r, __emm_batch_mul(bp->ay[i], e[1]));
+    r = __emm_batch_add(r, __emm_batch_mul(bp->az[i], e[2]));
+    dist = __emm_batch_min(dist, __emm_batch_add(c_dist, r));
+  }
+  return dist;
+}
+
+// visible[i] = frustum_test_aabb(f, box i).
+static inline void frustum_cull_aabbs_soa(const frustum *f, const aabb_soa *boxes, bool *visible, size_t n) {
+  __emm_geometry_planes bp = __emm_geometry_planes_from_frustum(f);
+  __emm_batch_f zero = __emm_batch_set1(0.0f);
+  const float *src[6] = { boxes->min_x, boxes->min_y, boxes->min_z, boxes->max_x, boxes->max_y, boxes->max_z };
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES) {
+    const float *block[6];
+    for (int k = 0; k < 6; ++k) block[k] = src[k] + i;
+    __emm_batch_f dist = __emm_geometry_aabbs_block(&bp, block);
+    __emm_geometry_store_mask(visible + i, ~__emm_batch_movemask(__emm_batch_lt(dist, zero)), EMM_BATCH_LANES);
+  }
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[6][EMM_BATCH_LANES];
+    const float *block[6];
+    for (int k = 0; k < 6; ++k) {
+      __emm_batch_pad(t[k], src[k] + i, rem);
+      block[k] = t[k];
+    }
+    __emm_batch_f dist = __emm_geometry_aabbs_block(&bp, block);
+    __emm_geometry_store_mask(visible + i, ~__emm_batch_movemask(__emm_batch_lt(dist, zero)), rem);
+  }
+}
+
+static inline __emm_batch_f __emm_geometry_spheres_block(const __emm_geometry_planes *bp,
+                                                         const float *x, const float *y, const float *z,
+                                                         const float *radius) {
+  __emm_batch_f cx = __emm_batch_load(x), cy = __emm_batch_load(y), cz = __emm_batch_load(z);
+  __emm_batch_f dist = __emm_batch_set1(FLT_MAX);
+  for (int i = 0; i < FRUSTUM_PLANE_COUNT; ++i) {
+    __emm_batch_f r = __emm_batch_mul(bp->nx[i], cx);
+    r = __emm_batch_add(r, __emm_batch_mul(bp->ny[i], cy));
+    r = __emm_batch_add(r, __emm_batch_mul(bp->nz[i], cz));
+    dist = __emm_batch_min(dist, __emm_batch_add(r, bp->d[i]));
+  }
+  return __emm_batch_add(dist, __emm_batch_load(radius));
+}
+
+// visible[i] = frustum_test_sphere(f, sphere i).
+static inline void frustum_cull_spheres_soa(const frustum *f, const sphere_soa *spheres, bool *visible, size_t n) {
+  __emm_geometry_planes bp = __emm_geometry_planes_from_frustum(f);
+  __emm_batch_f zero = __emm_batch_set1(0.0f);
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES) {
+    __emm_batch_f dist = __emm_geometry_spheres_block(&bp, spheres->x + i, spheres->y + i, spheres->z + i, spheres->radius + i);
+    __emm_geometry_store_mask(visible + i, ~__emm_batch_movemask(__emm_batch_lt(dist, zero)), EMM_BATCH_LANES);
+  }
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[4][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], spheres->x + i, rem);
+    __emm_batch_pad(t[1], spheres->y + i, rem);
+    __emm_batch_pad(t[2], spheres->z + i, rem);
+    __emm_batch_pad(t[3], spheres->radius + i, rem);
+    __emm_batch_f dist = __emm_geometry_spheres_block(&bp, t[0], t[1], t[2], t[3]);
+    __emm_geometry_store_mask(visible + i, ~__emm_batch_movemask(__emm_batch_lt(dist, zero)), rem);
+  }
+}
+
+static inline __emm_batch_mask __emm_geometry_overlap_block(const sphere *s,
+                                                            const float *x, const float *y, const float *z,
+                                                            const float *radius) {
+  __emm_batch_f dx = __emm_batch_sub(__emm_batch_load(x), __emm_batch_set1(s->center.x));
+  __emm_batch_f dy = __emm_batch_sub(__emm_batch_load(y), __emm_batch_set1(s->center.y));
+  __emm_batch_f dz = __emm_batch_sub(__emm_batch_load(z), __emm_batch_set1(s->center.z));
+  __emm_batch_f d2 = __emm_batch_add(__emm_batch_add(__emm_batch_mul(dx, dx), __emm_batch_mul(dy, dy)), __emm_batch_mul(dz, dz));
+  __emm_batch_f r = __emm_batch_add(__emm_batch_load(radius), __emm_batch_set1(s->radius));
+  return __emm_batch_gt(d2, __emm_batch_mul(r, r));
+}
+
+// hit[i] = sphere_overlap(*s, sphere i).
+static inline void sphere_overlap_soa(const sphere *s, const sphere_soa *spheres, bool *hit, size_t n) {
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES) {
+    __emm_batch_mask apart = __emm_geometry_overlap_block(s, spheres->x + i, spheres->y + i, spheres->z + i, spheres->radius + i);
+    __emm_geometry_store_mask(hit + i, ~__emm_batch_movemask(apart), EMM_BATCH_LANES);
+  }
+
+  if (i < n) {
+    size_t rem = n - i;
+    float t[4][EMM_BATCH_LANES];
+    __emm_batch_pad(t[0], spheres->x + i, rem);
+    __emm_batch_pad(t[1], spheres->y + i, rem);
+    __emm_batch_pad(t[2], spheres->z + i, rem);
+    __emm_batch_pad(t[3], spheres->radius + i, rem);
+    __emm_batch_mask apart = __emm_geometry_overlap_block(s, t[0], t[1], t[2], t[3]);
+    __emm_geometry_store_mask(hit + i, ~__emm_batch_movemask(apart), rem);
+  }
+}
+
+typedef struct __emm_geometry_ray_t {
+  __emm_batch_f origin[3], inv_dir[3];
+} __emm_geometry_ray;
+
+static inline __emm_batch_f __emm_geometry_ray_block(const __emm_geometry_ray *br, const float *const in[6]) {
+  __emm_batch_f t_near = __emm_batch_set1(0.0f);
+  __emm_batch_f t_far = __emm_batch_set1(INFINITY);
+  for (int k = 0; k < 3; ++k) {
+    __emm_batch_f t1 = __emm_batch_mul(__emm_batch_sub(__emm_batch_load(in[k]), br->origin[k]), br->inv_dir[k]);
+    __emm_batch_f t2 = __emm_batch_mul(__emm_batch_sub(__emm_batch_load(in[k + 3]), br->origin[k]), br->inv_dir[k]);
+    t_near = __emm_batch_max(t_near, __emm_batch_min(t1, t2));
+    t_far = __emm_batch_min(t_far, __emm_batch_max(t1, t2));
+  }
+  return __emm_batch_select(__emm_batch_lt(t_far, t_near), __emm_batch_set1(INFINITY), t_near);
+}
+
+// Slab test of one ray against n boxes: t[i] is the entry distance as in
+// ray_aabb, or INFINITY on a miss, so the closest hit is a min-reduction.
+static inline void ray_aabbs_soa(const ray *r, const aabb_soa *boxes, float *t, size_t n) {
+  __emm_geometry_ray br;
+  for (int k = 0; k < 3; ++k) {
+    br.origin[k] = __emm_batch_set1(r->origin.raw[k]);
+    br.inv_dir[k] = __emm_batch_set1(1.0f / r->dir.raw[k]);
+  }
+  const float *src[6] = { boxes->min_x, boxes->min_y, boxes->min_z, boxes->max_x, boxes->max_y, boxes->max_z };
+
+  size_t i = 0;
+  for (; i + EMM_BATCH_LANES <= n; i += EMM_BATCH_LANES) {
+    const float *block[6];
+    for (int k = 0; k < 6; ++k) block[k] = src[k] + i;
+    __emm_batch_store(t + i, __emm_geometry_ray_block(&br, block));
+  }
+
+  if (i < n) {
+    size_t rem = n - i;
+    float tmp[7][EMM_BATCH_LANES];
+    const float *block[6];
+    for (int k = 0; k < 6; ++k) {
+      __emm_batch_pad(tmp[k], src[k] + i, rem);
+      block[k] = tmp[k];
+    }
+    __emm_batch_store(tmp[6], __emm_geometry_ray_block(&br, block));
+    __emm_batch_unpad(t + i, tmp[6], rem);
+  }
+}
+
+HEADER_END
+
+#endif // EMM_GEOMETRY_H_
@@ -0,0 +1,471 @@
+#ifndef EMM_MAT_H_
+#define EMM_MAT_H_
+
+#include <emm/simd.h>
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <emm/types.h>
+
+// Matrices are column-major (see `columns`), matching the shaders'
+// `#pragma pack_matrix(column_major)`. m4_mul(a, b) applies b first.
+//
+// The *_ref functions are the scalar reference path and are always
+// available. The SIMD backends perform the same operations in the same order
+// as the reference, so as long as the compiler is not contracting a*b+c into
+// FMAs (-ffp-contract=off, the default for -std=c23) the results are
+// bit-identical.
+
+// mat3 (scalar only; 36 bytes does not map onto SIMD registers)
+
+static inline mat3 m3_identity(void) {
+  return (mat3) { .raw = {
+    1.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 1.0f
+  }};
+}
+
+static inline vec3 m3_mul_v3(mat3 m, vec3 v) {
+  vec3 r;
+  for (int i = 0; i < 3; ++i) {
+    r.raw[i] = m.columns[0].raw[i] * v.x;
+    r.raw[i] += m.columns[1].raw[i] * v.y;
+    r.raw[i] += m.columns[2].raw[i] * v.z;
+  }
+  return r;
+}
+
+static inline mat3 m3_mul(mat3 a, mat3 b) {
+  mat3 r;
+  for (int j = 0; j < 3; ++j) r.columns[j] = m3_mul_v3(a, b.columns[j]);
+  return r;
+}
+
+static inline mat3 m3_transpose(mat3 m) {
+  mat3 r;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      r.columns[i].raw[j] = m.columns[j].raw[i];
+  return r;
+}
+
+static inline float m3_det(mat3 m) {
+  return v3_dot(m.columns[0], v3_cross(m.columns[1], m.columns[2]));
+}
+
+// Returns the zero matrix if `m` is singular.
+static inline mat3 m3_inverse(mat3 m) {
+  vec3 a = m.columns[0], b = m.columns[1], c = m.columns[2];
+  vec3 r0 = v3_cross(b, c);
+  vec3 r1 = v3_cross(c, a);
+  vec3 r2 = v3_cross(a, b);
+
+  float det = v3_dot(a, r0);
+  if (det == 0.0f) return (mat3){0};
+  float inv_det = 1.0f / det;
+
+  // r0..r2 are the rows of the inverse (times det).
+  return m3_transpose((mat3) { .columns = {
+    v3_muls(r0, inv_det), v3_muls(r1, inv_det), v3_muls(r2, inv_det)
+  }});
+}
+
+// mat4, scalar reference path
+
+static inline mat4 m4_identity(void) {
+  return (mat4) { .raw = {
+    1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f
+  }};
+}
+
+static inline mat3 m3_from_m4(mat4 m) {
+  return (mat3) { .columns = {
+    v3_from_v4(m.columns[0]), v3_from_v4(m.columns[1]), v3_from_v4(m.columns[2])
+  }};
+}
+
+static inline vec4 m4_mul_v4_ref(mat4 m, vec4 v) {
+  vec4 r;
+  for (int i = 0; i < 4; ++i) {
+    r.raw[i] = m.columns[0].raw[i] * v.x;
+    r.raw[i] += m.columns[1].raw[i] * v.y;
+    r.raw[i] += m.columns[2].raw[i] * v.z;
+    r.raw[i] += m.columns[3].raw[i] * v.w;
+  }
+  return r;
+}
+
+static inline mat4 m4_mul_ref(mat4 a, mat4 b) {
+  mat4 r;
+  for (int j = 0; j < 4; ++j) r.columns[j] = m4_mul_v4_ref(a, b.columns[j]);
+  return r;
+}
+
+static inline mat4 m4_transpose_ref(mat4 m) {
+  mat4 r;
+  for (int i = 0; i < 4; ++i)
+    for (int j = 0; j < 4; ++j)
+      r.columns[i].raw[j] = m.columns[j].raw[i];
+  return r;
+}
+
+// The inverse is computed from the 2x2 sub-determinants of the row pairs
+// (0,1) and (2,3). Everything is arranged so that each output column is a
+// single 4-lane expression, which is what the SIMD versions evaluate; this
+// reference spells out the same lanes one at a time.
+//
+// With r_j = row j of m:
+//   F(p,q) = L(r_p) * N(r_q) - N(r_p) * L(r_q)  L = lanes 2200, N = 3311
+//   V_j    = lanes 1032 of r_j
+//   out_0  = (V1*F(2,3) - V2*F(1,3) + V3*F(1,2)) * (+-+-)
+//   out_1  = (V0*F(2,3) - V2*F(0,3) + V3*F(0,2)) * (-+-+)
+//   out_2  = (V0*F(1,3) - V1*F(0,3) + V3*F(0,1)) * (+-+-)
+//   out_3  = (V0*F(1,2) - V1*F(0,2) + V2*F(0,1)) * (-+-+)
+// followed by a divide by the determinant.
+
+// Returns the zero matrix if `m` is singular.
+static inline mat4 m4_inverse_ref(mat4 m) {
+  static const int L[4] = { 2, 2, 0, 0 };
+  static const int N[4] = { 3, 3, 1, 1 };
+  static const int V[4] = { 1, 0, 3, 2 };
+  static const int pairs[6][2] = { {0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3} };
+  static const int terms[4][3][2] = {
+    { {1, 5}, {2, 4}, {3, 3} },
+    { {0, 5}, {2, 2}, {3, 1} },
+    { {0, 4}, {1, 2}, {3, 0} },
+    { {0, 3}, {1, 1}, {2, 0} },
+  };
+  static const float sign[2][4] = { { 1, -1, 1, -1 }, { -1, 1, -1, 1 } };
+
+  float r[4][4];
+  for (int j = 0; j < 4; ++j)
+    for (int i = 0; i < 4; ++i)
+      r[j][i] = m.columns[i].raw[j];
+
+  float f[6][4], v[4][4];
+  for (int k = 0; k < 6; ++k) {
+    const float *p = r[pairs[k][0]], *q = r[pairs[k][1]];
+    for (int l = 0; l < 4; ++l)
+      f[k][l] = p[L[l]] * q[N[l]] - p[N[l]] * q[L[l]];
+  }
+  for (int j = 0; j < 4; ++j)
+    for (int l = 0; l < 4; ++l)
+      v[j][l] = r[j][V[l]];
+
+  float b[4][4];
+  for (int i = 0; i < 4; ++i) {
+    const int (*t)[2] = terms[i];
+    for (int l = 0; l < 4; ++l) {
+      float x = v[t[0][0]][l] * f[t[0][1]][l] - v[t[1][0]][l] * f[t[1][1]][l];
+      x = x + v[t[2][0]][l] * f[t[2][1]][l];
+      b[i][l] = x * sign[i & 1][l];
+    }
+  }
+
+  float det = m.columns[0].raw[0] * b[0][0];
+  det += m.columns[0].raw[1] * b[1][0];
+  det += m.columns[0].raw[2] * b[2][0];
+  det += m.columns[0].raw[3] * b[3][0];
+  if (det == 0.0f) return (mat4){0};
+  float inv_det = 1.0f / det;
+
+  mat4 out;
+  for (int i = 0; i < 4; ++i)
+    for (int l = 0; l < 4; ++l)
+      out.columns[i].raw[l] = b[i][l] * inv_det;
+  return out;
+}
+
+// mat4, SIMD backends
+
+#if defined(EMM_SIMD_SSE)
+
+static inline __m128 __emm_m4_mul_col(const mat4 *m, __m128 v) {
+  __m128 r = _mm_mul_ps(_mm_loadu_ps(&m->raw[0]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m->raw[4]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m->raw[8]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+  r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(&m->raw[12]), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+  return r;
+}
+
+static inline vec4 m4_mul_v4(mat4 m, vec4 v) {
+  vec4 r;
+  _mm_storeu_ps(r.raw, __emm_m4_mul_col(&m, _mm_loadu_ps(v.raw)));
+  return r;
+}
+
+#if defined(EMM_SIMD_AVX)
+
+// Two output columns per iteration: each 128-bit half of the register
+// carries one column of b.
+static inline mat4 m4_mul(mat4 a, mat4 b) {
+  __m128 a0 = _mm_loadu_ps(&a.raw[0]), a1 = _mm_loadu_ps(&a.raw[4]);
+  __m128 a2 = _mm_loadu_ps(&a.raw[8]), a3 = _mm_loadu_ps(&a.raw[12]);
+  __m256 A0 = _mm256_insertf128_ps(_mm256_castps128_ps256(a0), a0, 1);
+  __m256 A1 = _mm256_insertf128_ps(_mm256_castps128_ps256(a1), a1, 1);
+  __m256 A2 = _mm256_insertf128_ps(_mm256_castps128_ps256(a2), a2, 1);
+  __m256 A3 = _mm256_insertf128_ps(_mm256_castps128_ps256(a3), a3, 1);
+
+  mat4 r;
+  for (int j = 0; j < 16; j += 8) {
+    __m256 bb = _mm256_loadu_ps(&b.raw[j]);
+    __m256 acc = _mm256_mul_ps(A0, _mm256_permute_ps(bb, 0x00));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(A1, _mm256_permute_ps(bb, 0x55)));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(A2, _mm256_permute_ps(bb, 0xAA)));
+    acc = _mm256_add_ps(acc, _mm256_mul_ps(A3, _mm256_permute_ps(bb, 0xFF)));
+    _mm256_storeu_ps(&r.raw[j], acc);
+  }
+  return r;
+}
+
+#else
+
+static inline mat4 m4_mul(mat4 a, mat4 b) {
+  mat4 r;
+  for (int j = 0; j < 16; j += 4)
+    _mm_storeu_ps(&r.raw[j], __emm_m4_mul_col(&a, _mm_loadu_ps(&b.raw[j])));
+  return r;
+}
+
+#endif // EMM_SIMD_AVX
+
+static inline mat4 m4_transpose(mat4 m) {
+  __m128 c0 = _mm_loadu_ps(&m.raw[0]), c1 = _mm_loadu_ps(&m.raw[4]);
+  __m128 c2 = _mm_loadu_ps(&m.raw[8]), c3 = _mm_loadu_ps(&m.raw[12]);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+  mat4 r;
+  _mm_storeu_ps(&r.raw[0], c0);
+  _mm_storeu_ps(&r.raw[4], c1);
+  _mm_storeu_ps(&r.raw[8], c2);
+  _mm_storeu_ps(&r.raw[12], c3);
+  return r;
+}
+
+#define __EMM_F(p, q) _mm_sub_ps(_mm_mul_ps(l##p, n##q), _mm_mul_ps(n##p, l##q))
+#define __EMM_COL(va, fa, vb, fb, vc, fc, s) \
+  _mm_mul_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(va, fa), _mm_mul_ps(vb, fb)), _mm_mul_ps(vc, fc)), s)
+
+// See m4_inverse_ref for the derivation.
+static inline mat4 m4_inverse(mat4 m) {
+  __m128 r0 = _mm_loadu_ps(&m.raw[0]), r1 = _mm_loadu_ps(&m.raw[4]);
+  __m128 r2 = _mm_loadu_ps(&m.raw[8]), r3 = _mm_loadu_ps(&m.raw[12]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+  __m128 l0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 0, 2, 2));
+  __m128 l1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 0, 2, 2));
+  __m128 l2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 0, 2, 2));
+  __m128 l3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 0, 2, 2));
+  __m128 n0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(1, 1, 3, 3));
+  __m128 n1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 1, 3, 3));
+  __m128 n2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(1, 1, 3, 3));
+  __m128 n3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 1, 3, 3));
+  __m128 v0 = _mm_shuffle_ps(r0, r0, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 v1 = _mm_shuffle_ps(r1, r1, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 v2 = _mm_shuffle_ps(r2, r2, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 v3 = _mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 3, 0, 1));
+
+  __m128 f0 = __EMM_F(0, 1), f1 = __EMM_F(0, 2), f2 = __EMM_F(0, 3);
+  __m128 f3 = __EMM_F(1, 2), f4 = __EMM_F(1, 3), f5 = __EMM_F(2, 3);
+
+  __m128 pos = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+  __m128 neg = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+  __m128 b0 = __EMM_COL(v1, f5, v2, f4, v3, f3, pos);
+  __m128 b1 = __EMM_COL(v0, f5, v2, f2, v3, f1, neg);
+  __m128 b2 = __EMM_COL(v0, f4, v1, f2, v3, f0, pos);
+  __m128 b3 = __EMM_COL(v0, f3, v1, f1, v2, f0, neg);
+
+  float det = m.raw[0] * _mm_cvtss_f32(b0);
+  det += m.raw[1] * _mm_cvtss_f32(b1);
+  det += m.raw[2] * _mm_cvtss_f32(b2);
+  det += m.raw[3] * _mm_cvtss_f32(b3);
+  if (det == 0.0f) return (mat4){0};
+  __m128 inv_det = _mm_set1_ps(1.0f / det);
+
+  mat4 r;
+  _mm_storeu_ps(&r.raw[0], _mm_mul_ps(b0, inv_det));
+  _mm_storeu_ps(&r.raw[4], _mm_mul_ps(b1, inv_det));
+  _mm_storeu_ps(&r.raw[8], _mm_mul_ps(b2, inv_det));
+  _mm_storeu_ps(&r.raw[12], _mm_mul_ps(b3, inv_det));
+  return r;
+}
+
+#undef __EMM_F
+#undef __EMM_COL
+
+#elif defined(EMM_SIMD_NEON)
+
+static inline float32x4_t __emm_m4_mul_col(const mat4 *m, float32x4_t v) {
+  float32x4_t r = vmulq_laneq_f32(vld1q_f32(&m->raw[0]), v, 0);
+  r = vaddq_f32(r, vmulq_laneq_f32(vld1q_f32(&m->raw[4]), v, 1));
+  r = vaddq_f32(r, vmulq_laneq_f32(vld1q_f32(&m->raw[8]), v, 2));
+  r = vaddq_f32(r, vmulq_laneq_f32(vld1q_f32(&m->raw[12]), v, 3));
+  return r;
+}
+
+static inline vec4 m4_mul_v4(mat4 m, vec4 v) {
+  vec4 r;
+  vst1q_f32(r.raw, __emm_m4_mul_col(&m, vld1q_f32(v.raw)));
+  return r;
+}
+
+static inline mat4 m4_mul(mat4 a, mat4 b) {
+  mat4 r;
+  for (int j = 0; j < 16; j += 4)
+    vst1q_f32(&r.raw[j], __emm_m4_mul_col(&a, vld1q_f32(&b.raw[j])));
+  return r;
+}
+
+static inline mat4 m4_transpose(mat4 m) {
+  // vld4 de-interleaves with a stride of 4, i.e. loads the rows.
+  float32x4x4_t rows = vld4q_f32(m.raw);
+
+  mat4 r;
+  vst1q_f32(&r.raw[0], rows.val[0]);
+  vst1q_f32(&r.raw[4], rows.val[1]);
+  vst1q_f32(&r.raw[8], rows.val[2]);
+  vst1q_f32(&r.raw[12], rows.val[3]);
+  return r;
+}
+
+static inline float32x4_t __emm_lanes_2200(float32x4_t x) {
+  return vcombine_f32(vdup_laneq_f32(x, 2), vdup_laneq_f32(x, 0));
+}
+
+static inline float32x4_t __emm_lanes_3311(float32x4_t x) {
+  return vcombine_f32(vdup_laneq_f32(x, 3), vdup_laneq_f32(x, 1));
+}
+
+#define __EMM_F(p, q) vsubq_f32(vmulq_f32(l##p, n##q), vmulq_f32(n##p, l##q))
+#define __EMM_COL(va, fa, vb, fb, vc, fc, s) \
+  vmulq_f32(vaddq_f32(vsubq_f32(vmulq_f32(va, fa), vmulq_f32(vb, fb)), vmulq_f32(vc, fc)), s)
+
+// See m4_inverse_ref for the derivation.
+static inline mat4 m4_inverse(mat4 m) {
+  float32x4x4_t rows = vld4q_f32(m.raw);
+  float32x4_t r0 = rows.val[0], r1 = rows.val[1], r2 = rows.val[2], r3 = rows.val[3];
+
+  float32x4_t l0 = __emm_lanes_2200(r0), l1 = __emm_lanes_2200(r1);
+  float32x4_t l2 = __emm_lanes_2200(r2), l3 = __emm_lanes_2200(r3);
+  float32x4_t n0 = __emm_lanes_3311(r0), n1 = __emm_lanes_3311(r1);
+  float32x4_t n2 = __emm_lanes_3311(r2), n3 = __emm_lanes_3311(r3);
+  float32x4_t v0 = vrev64q_f32(r0), v1 = vrev64q_f32(r1);
+  float32x4_t v2 = vrev64q_f32(r2), v3 = vrev64q_f32(r3);
+
+  float32x4_t f0 = __EMM_F(0, 1), f1 = __EMM_F(0, 2), f2 = __EMM_F(0, 3);
+  float32x4_t f3 = __EMM_F(1, 2), f4 = __EMM_F(1, 3), f5 = __EMM_F(2, 3);
+
+  static const float pos_lanes[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+  static const float neg_lanes[4] = { -1.0f, 1.0f, -1.0f, 1.0f };
+  float32x4_t pos = vld1q_f32(pos_lanes), neg = vld1q_f32(neg_lanes);
+  float32x4_t b0 = __EMM_COL(v1, f5, v2, f4, v3, f3, pos);
+  float32x4_t b1 = __EMM_COL(v0, f5, v2, f2, v3, f1, neg);
+  float32x4_t b2 = __EMM_COL(v0, f4, v1, f2, v3, f0, pos);
+  float32x4_t b3 = __EMM_COL(v0, f3, v1, f1, v2, f0, neg);
+
+  float det = m.raw[0] * vgetq_lane_f32(b0, 0);
+  det += m.raw[1] * vgetq_lane_f32(b1, 0);
+  det += m.raw[2] * vgetq_lane_f32(b2, 0);
+  det += m.raw[3] * vgetq_lane_f32(b3, 0);
+  if (det == 0.0f) return (mat4){0};
+  float inv_det = 1.0f / det;
+
+  mat4 r;
+  vst1q_f32(&r.raw[0], vmulq_n_f32(b0, inv_det));
+  vst1q_f32(&r.raw[4], vmulq_n_f32(b1, inv_det));
+  vst1q_f32(&r.raw[8], vmulq_n_f32(b2, inv_det));
+  vst1q_f32(&r.raw[12], vmulq_n_f32(b3, inv_det));
+  return r;
+}
+
+#undef __EMM_F
+#undef __EMM_COL
+
+#else
+
+static inline vec4 m4_mul_v4(mat4 m, vec4 v) { return m4_mul_v4_ref(m, v); }
+static inline mat4 m4_mul(mat4 a, mat4 b) { return m4_mul_ref(a, b); }
+static inline mat4 m4_transpose(mat4 m) { return m4_transpose_ref(m); }
+static inline mat4 m4_inverse(mat4 m) { return m4_inverse_ref(m); }
+
+#endif
+
+// mat4 builders
+
+static inline mat4 m4_translate(vec3 t) {
+  mat4 m = m4_identity();
+  m.columns[3] = (vec4) { t.x, t.y, t.z, 1.0f };
+  return m;
+}
+
+static inline mat4 m4_scale(vec3 s) {
+  mat4 m = m4_identity();
+  m.columns[0].x = s.x;
+  m.columns[1].y = s.y;
+  m.columns[2].z = s.z;
+  return m;
+}
+
+// Rotation of `angle` radians around `axis` (need not be normalised).
+static inline mat4 m4_rotate(vec3 axis, float angle) {
+  vec3 a = v3_norm(axis);
+  float c = cosf(angle), s = sinf(angle), t = 1.0f - c;
+
+  mat4 m = m4_identity();
+  m.columns[0] = (vec4) { t * a.x * a.x + c,       t * a.x * a.y + s * a.z, t * a.x * a.z - s * a.y, 0.0f };
+  m.columns[1] = (vec4) { t * a.x * a.y - s * a.z, t * a.y * a.y + c,       t * a.y * a.z + s * a.x, 0.0f };
+  m.columns[2] = (vec4) { t * a.x * a.z + s * a.y, t * a.y * a.z - s * a.x, t * a.z * a.z + c,       0.0f };
+  return m;
+}
+
+// Projections target Vulkan clip space: right-handed view space looking
+// down -Z, depth in [0, 1], and +Y pointing down the screen.
+
+static inline mat4 m4_perspective(float fovy, float aspect, float z_near, float z_far) {
+  float f = 1.0f / tanf(fovy * 0.5f);
+
+  mat4 m = {0};
+  m.columns[0].x = f / aspect;
+  m.columns[1].y = -f;
+  m.columns[2].z = z_far / (z_near - z_far);
+  m.columns[2].w = -1.0f;
+  m.columns[3].z = (z_near * z_far) / (z_near - z_far);
+  return m;
+}
+
+static inline mat4 m4_ortho(float left, float right, float bottom, float top, float z_near, float z_far) {
+  mat4 m = m4_identity();
+  m.columns[0].x = 2.0f / (right - left);
+  m.columns[1].y = 2.0f / (bottom - top);
+  m.columns[2].z = 1.0f / (z_near - z_far);
+  m.columns[3] = (vec4) {
+    -(right + left) / (right - left),
+    -(top + bottom) / (bottom - top),
+    z_near / (z_near - z_far),
+    1.0f
+  };
+  return m;
+}
+
+static inline mat4 m4_look_at(vec3 eye, vec3 center, vec3 up) {
+  vec3 f = v3_norm(v3_sub(center, eye));
+  vec3 s = v3_norm(v3_cross(f, up));
+  vec3 u = v3_cross(s, f);
+
+  return (mat4) { .columns = {
+    { s.x, u.x, -f.x, 0.0f },
+    { s.y, u.y, -f.y, 0.0f },
+    { s.z, u.z, -f.z, 0.0f },
+    { -v3_dot(s, eye), -v3_dot(u, eye), v3_dot(f, eye), 1.0f }
+  }};
+}
+
+HEADER_END
+
+#endif // EMM_MAT_H_
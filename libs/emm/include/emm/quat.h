@@ -0,0 +1,100 @@
+#ifndef EMM_QUAT_H_
+#define EMM_QUAT_H_
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <emm/types.h>
+#include <emm/mat.h>
+
+// Unit quaternions representing rotations. q_mul(a, b) applies b first,
+// the same as m4_mul.
+
+static inline quat q_identity(void) {
+  return (quat) { .raw = { 0.0f, 0.0f, 0.0f, 1.0f } };
+}
+
+// Rotation of `angle` radians around `axis` (need not be normalised).
+static inline quat q_from_axis_angle(vec3 axis, float angle) {
+  vec3 a = v3_muls(v3_norm(axis), sinf(angle * 0.5f));
+  return (quat) { .raw = { a.x, a.y, a.z, cosf(angle * 0.5f) } };
+}
+
+static inline quat q_mul(quat a, quat b) {
+  return (quat) { .raw = {
+    a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+  }};
+}
+
+static inline quat q_conj(quat q) {
+  return (quat) { .raw = { -q.x, -q.y, -q.z, q.w } };
+}
+
+static inline float q_dot(quat a, quat b) {
+  return v4_dot(a.xyzw, b.xyzw);
+}
+
+static inline quat q_norm(quat q) {
+  return (quat) { .xyzw = v4_norm(q.xyzw) };
+}
+
+static inline quat q_inverse(quat q) {
+  float l2 = q_dot(q, q);
+  if (l2 == 0) return (quat){0};
+  return (quat) { .xyzw = v4_muls(q_conj(q).xyzw, 1.0f / l2) };
+}
+
+// v' = v + 2w(u x v) + 2u x (u x v), with u = q.xyz. Assumes q is unit length.
+static inline vec3 q_rotate_v3(quat q, vec3 v) {
+  vec3 u = { q.x, q.y, q.z };
+  vec3 t = v3_muls(v3_cross(u, v), 2.0f);
+  return v3_add(v3_add(v, v3_muls(t, q.w)), v3_cross(u, t));
+}
+
+// Shortest-path spherical interpolation; falls back to a normalised lerp
+// when the inputs are nearly parallel.
+static inline quat q_slerp(quat a, quat b, float t) {
+  float d = q_dot(a, b);
+  if (d < 0.0f) {
+    b.xyzw = v4_neg(b.xyzw);
+    d = -d;
+  }
+
+  if (d > 0.9995f) return q_norm((quat) { .xyzw = v4_lerp(a.xyzw, b.xyzw, t) });
+
+  float theta = acosf(d);
+  float s = 1.0f / sinf(theta);
+  float wa = sinf((1.0f - t) * theta) * s;
+  float wb = sinf(t * theta) * s;
+  return (quat) { .xyzw = v4_add(v4_muls(a.xyzw, wa), v4_muls(b.xyzw, wb)) };
+}
+
+static inline mat3 q_to_m3(quat q) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+  return (mat3) { .columns = {
+    { 1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz),        2.0f * (xz - wy) },
+    { 2.0f * (xy - wz),        1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx) },
+    { 2.0f * (xz + wy),        2.0f * (yz - wx),        1.0f - 2.0f * (xx + yy) }
+  }};
+}
+
+static inline mat4 q_to_m4(quat q) {
+  mat3 r = q_to_m3(q);
+  return (mat4) { .columns = {
+    v4_from_v3(r.columns[0], 0.0f),
+    v4_from_v3(r.columns[1], 0.0f),
+    v4_from_v3(r.columns[2], 0.0f),
+    { 0.0f, 0.0f, 0.0f, 1.0f }
+  }};
+}
+
+HEADER_END
+
+#endif // EMM_QUAT_H_
@@ -0,0 +1,27 @@
+#ifndef EMM_SIMD_H_
+#define EMM_SIMD_H_
+
+// Picks the SIMD backend used by the hot math kernels. Exactly one of
+// EMM_SIMD_SSE, EMM_SIMD_NEON or EMM_SIMD_NONE ends up defined, plus
+// EMM_SIMD_AVX when 256-bit registers are available on top of SSE.
+//
+// The backend follows the compiler's target flags (e.g. `-msse4.1`,
+// `-mavx2`, or just the x86-64/aarch64 baselines). Define EMM_NO_SIMD to
+// force the scalar reference path everywhere.
+
+#if defined(EMM_NO_SIMD)
+  #define EMM_SIMD_NONE
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define EMM_SIMD_SSE
+  #include <immintrin.h>
+  #if defined(__AVX__)
+    #define EMM_SIMD_AVX
+  #endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  #define EMM_SIMD_NEON
+  #include <arm_neon.h>
+#else
+  #define EMM_SIMD_NONE
+#endif
+
+#endif // EMM_SIMD_H_
@@ -0,0 +1,210 @@
+#ifndef EMM_TYPES_H_
+#define EMM_TYPES_H_
+
+#include <emm/common.h>
+
+HEADER_BEGIN
+
+#include <math.h>
+
+// Vectors
+
+typedef union vec2_t {
+  struct { float x, y; };
+  struct { float r, g; };
+  float raw[2];
+} vec2;
+
+typedef union vec3_t {
+  struct { float x, y, z; };
+  struct { float r, g, b; };
+  float raw[3];
+} vec3;
+
+typedef union vec4_t {
+  struct { float x, y, z, w; };
+  struct { float r, g, b, a; };
+  float raw[4];
+} vec4;
+
+// Matrices
+
+typedef union mat2_t {
+  float raw[4];
+  vec2 columns[2];
+} mat2;
+
+typedef union mat3_t {
+  float raw[9];
+  vec3 columns[3];
+} mat3;
+
+typedef union mat4_t {
+  float raw[16];
+  vec4 columns[4];
+} mat4;
+
+// Quaternions
+
+typedef union quat_t {
+  struct { float x, y, z, w; };
+  vec4 xyzw;
+  float raw[4];
+} quat;
+
+static inline vec2 v2_add(vec2 a, vec2 b) {
+  return (vec2) { a.x + b.x, a.y + b.y };
+}
+
+static inline vec2 v2_sub(vec2 a, vec2 b) {
+  return (vec2) { a.x - b.x, a.y - b.y };
+}
+
+static inline vec2 v2_muls(vec2 a, float s) {
+  return (vec2) { a.x * s, a.y * s };
+}
+
+static inline float v2_len2(vec2 a) {
+  return a.x * a.x + a.y * a.y;
+}
+
+static inline float v2_len(vec2 a) {
+  return sqrtf(v2_len2(a));
+}
+
+static inline vec2 v2_norm(vec2 a) {
+  float l = v2_len(a);
+  if (l == 0) return (vec2){0};
+  return v2_muls(a, 1.0f / l);
+}
+
+static inline float v2_dot(vec2 a, vec2 b) {
+  return a.x * b.x + a.y * b.y;
+}
+
+static inline float v2_cross(vec2 a, vec2 b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+static inline vec3 v3_add(vec3 a, vec3 b) {
+  return (vec3) { a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+static inline vec3 v3_sub(vec3 a, vec3 b) {
+  return (vec3) { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static inline vec3 v3_mul(vec3 a, vec3 b) {
+  return (vec3) { a.x * b.x, a.y * b.y, a.z * b.z };
+}
+
+static inline vec3 v3_muls(vec3 a, float s) {
+  return (vec3) { a.x * s, a.y * s, a.z * s };
+}
+
+static inline vec3 v3_neg(vec3 a) {
+  return (vec3) { -a.x, -a.y, -a.z };
+}
+
+static inline float v3_dot(vec3 a, vec3 b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static inline vec3 v3_cross(vec3 a, vec3 b) {
+  return (vec3) {
+    a.y * b.z - a.z * b.y,
+    a.z * b.x - a.x * b.z,
+    a.x * b.y - a.y * b.x
+  };
+}
+
+static inline float v3_len2(vec3 a) {
+  return v3_dot(a, a);
+}
+
+static inline float v3_len(vec3 a) {
+  return sqrtf(v3_len2(a));
+}
+
+static inline vec3 v3_norm(vec3 a) {
+  float l = v3_len(a);
+  if (l == 0) return (vec3){0};
+  return v3_muls(a, 1.0f / l);
+}
+
+static inline vec3 v3_lerp(vec3 a, vec3 b, float t) {
+  return (vec3) { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t };
+}
+
+static inline vec3 v3_min(vec3 a, vec3 b) {
+  return (vec3) { fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z) };
+}
+
+static inline vec3 v3_max(vec3 a, vec3 b) {
+  return (vec3) { fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z) };
+}
+
+static inline vec4 v4_add(vec4 a, vec4 b) {
+  return (vec4) { a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+}
+
+static inline vec4 v4_sub(vec4 a, vec4 b) {
+  return (vec4) { a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+}
+
+static inline vec4 v4_mul(vec4 a, vec4 b) {
+  return (vec4) { a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w };
+}
+
+static inline vec4 v4_muls(vec4 a, float s) {
+  return (vec4) { a.x * s, a.y * s, a.z * s, a.w * s };
+}
+
+static inline vec4 v4_neg(vec4 a) {
+  return (vec4) { -a.x, -a.y, -a.z, -a.w };
+}
+
+static inline float v4_dot(vec4 a, vec4 b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+static inline float v4_len2(vec4 a) {
+  return v4_dot(a, a);
+}
+
+static inline float v4_len(vec4 a) {
+  return sqrtf(v4_len2(a));
+}
+
+static inline vec4 v4_norm(vec4 a) {
+  float l = v4_len(a);
+  if (l == 0) return (vec4){0};
+  return v4_muls(a, 1.0f / l);
+}
+
+static inline vec4 v4_lerp(vec4 a, vec4 b, float t) {
+  return (vec4) {
+    a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t,
+    a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t
+  };
+}
+
+static inline vec4 v4_min(vec4 a, vec4 b) {
+  return (vec4) { fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z), fminf(a.w, b.w) };
+}
+
+static inline vec4 v4_max(vec4 a, vec4 b) {
+  return (vec4) { fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z), fmaxf(a.w, b.w) };
+}
+
+static inline vec4 v4_from_v3(vec3 v, float w) {
+  return (vec4) { v.x, v.y, v.z, w };
+}
+
+static inline vec3 v3_from_v4(vec4 v) {
+  return (vec3) { v.x, v.y, v.z };
+}
+
+HEADER_END
+
+#endif // EMM_TYPES_H_
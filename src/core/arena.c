@@ -0,0 +1,42 @@
+#include <core/arena.h>
+
+#include <util/logger.h>
+
+#include <stdlib.h>
+
+#include <SDL3/SDL_log.h>
+
+static _Thread_local arena tls_scratch;
+
+void arena_init(arena *a, size_t capacity, mem_tag tag) {
+  a->base = mem_alloc(capacity, tag);
+  if (!check_mem_alloc(a->base)) exit(1);
+  a->capacity = capacity;
+  a->offset = 0;
+  a->peak = 0;
+}
+
+void arena_destroy(arena *a) {
+  mem_free(a->base);
+  *a = (arena) {0};
+}
+
+void *arena_alloc(arena *a, size_t size, size_t align) {
+  uintptr_t start = ((uintptr_t)a->base + a->offset + (align - 1)) & ~(uintptr_t)(align - 1);
+  size_t offset = (size_t)(start - (uintptr_t)a->base);
+
+  if (offset > a->capacity || size > a->capacity - offset) {
+    LOG_ERROR(LOG_CAT_MEMORY, "Arena out of memory: %zu of %zu bytes used, %zu requested.\n",
+            a->offset, a->capacity, size);
+    exit(1);
+  }
+
+  a->offset = offset + size;
+  if (a->offset > a->peak) a->peak = a->offset;
+  return (void*)start;
+}
+
+arena_scope arena_scratch_begin(void) {
+  if (!tls_scratch.base) arena_init(&tls_scratch, ARENA_SCRATCH_SIZE, MEM_TAG_CORE);
+  return arena_scope_begin(&tls_scratch);
+}
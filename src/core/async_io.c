@@ -0,0 +1,505 @@
+// pread, eventfd and syscall are behind the default feature set, which
+// -std=c23 hides.
+#define _DEFAULT_SOURCE
+
+#include <core/async_io.h>
+#include <core/memory.h>
+
+#include <util/logger.h>
+#include <util/profiler.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_timer.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ASYNC_IO_POSIX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The ring is driven through the raw syscalls, so only the kernel's UAPI
+// header is needed and not liburing.
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_URING
+#include <linux/io_uring.h>
+#include <stdatomic.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+// user_data of the read that waits on the wake eventfd; reads use their slot
+// index.
+#define ASYNC_IO_WAKE_TAG UINT64_MAX
+// The kernel caps a single read below 2 GiB; longer requests are read in
+// pieces like any other short read.
+#define ASYNC_IO_MAX_READ (1u << 30)
+
+typedef struct async_io_slot_t {
+  io_request *req;
+  int fd;
+  size_t want;
+  bool owned;
+} async_io_slot;
+#endif
+
+typedef struct async_io_t {
+  async_io_backend backend;
+
+  // Requests not started yet, oldest first.
+  SDL_Mutex *lock;
+  SDL_Condition *available;
+  io_request *head;
+  io_request *tail;
+  bool stopping;
+
+  SDL_Thread *threads[ASYNC_IO_FALLBACK_THREADS];
+  uint32_t thread_count;
+
+#ifdef ASYNC_IO_URING
+  int ring_fd;
+  int event_fd;
+  uint64_t event_value;
+  void *ring;
+  size_t ring_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  _Atomic uint32_t *sq_head;
+  _Atomic uint32_t *sq_tail;
+  uint32_t sq_mask;
+  uint32_t *sq_array;
+  _Atomic uint32_t *cq_head;
+  _Atomic uint32_t *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+
+  // Only touched by the ring thread.
+  async_io_slot slots[ASYNC_IO_QUEUE_DEPTH];
+  uint32_t free_slots[ASYNC_IO_QUEUE_DEPTH];
+  uint32_t free_count;
+#endif
+} async_io;
+
+static async_io aio;
+
+static io_request *__async_io_pop_locked(void) {
+  io_request *req = aio.head;
+  if (req) {
+    aio.head = req->__next;
+    if (!aio.head) aio.tail = NULL;
+    req->__next = NULL;
+  }
+  return req;
+}
+
+static void __async_io_callback_job(void *data) {
+  io_request *req = data;
+  // The callback may release the request.
+  job_counter *counter = req->counter;
+  req->callback(req, req->user);
+  if (counter) job_counter_signal(counter);
+}
+
+// Publishes the result. `req` belongs to the caller again afterwards.
+static void __async_io_complete(io_request *req, bool owned) {
+  if (req->error) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not read file '%s': %s\n", req->path, strerror(req->error));
+    if (owned) {
+      mem_free(req->buffer);
+      req->buffer = NULL;
+    }
+    req->bytes_read = 0;
+  }
+
+  if (req->callback) job_run(&(job_decl) { __async_io_callback_job, req }, 1, NULL);
+  else if (req->counter) job_counter_signal(req->counter);
+}
+
+// Allocates the destination for a read of `size` bytes if the caller left it
+// to us.
+static bool __async_io_prepare_buffer(io_request *req, size_t size, bool *owned) {
+  *owned = false;
+  if (req->buffer || size == 0) return true;
+  req->buffer = mem_alloc(size, MEM_TAG_ASSETS);
+  if (!req->buffer) {
+    req->error = ENOMEM;
+    return false;
+  }
+  *owned = true;
+  return true;
+}
+
+#ifdef ASYNC_IO_POSIX
+
+// Opens the file and works out how much to read. On failure `req->error` is
+// set and nothing is left open.
+static bool __async_io_open(io_request *req, int *fd, size_t *want, bool *owned) {
+  *owned = false;
+  *fd = open(req->path, O_RDONLY | O_CLOEXEC);
+  if (*fd < 0) {
+    req->error = errno;
+    return false;
+  }
+
+  *want = req->size;
+  if (*want == 0) {
+    struct stat st;
+    if (fstat(*fd, &st) != 0) {
+      req->error = errno;
+      close(*fd);
+      return false;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    *want = size > req->offset ? (size_t)(size - req->offset) : 0;
+  }
+
+  if (!__async_io_prepare_buffer(req, *want, owned)) {
+    close(*fd);
+    return false;
+  }
+  return true;
+}
+
+static void __async_io_read_blocking(io_request *req) {
+  int fd;
+  size_t want;
+  bool owned;
+  if (!__async_io_open(req, &fd, &want, &owned)) {
+    __async_io_complete(req, false);
+    return;
+  }
+
+  while (req->bytes_read < want) {
+    ssize_t n = pread(fd, (uint8_t*)req->buffer + req->bytes_read, want - req->bytes_read,
+                      (off_t)(req->offset + req->bytes_read));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      req->error = errno;
+      break;
+    }
+    if (n == 0) break;
+    req->bytes_read += (size_t)n;
+  }
+
+  close(fd);
+  __async_io_complete(req, owned);
+}
+
+#else
+
+static void __async_io_read_blocking(io_request *req) {
+  bool owned = false;
+  FILE *file = fopen(req->path, "rb");
+  if (!file) {
+    req->error = errno;
+    __async_io_complete(req, false);
+    return;
+  }
+
+  size_t want = req->size;
+  if (want == 0) {
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) size = ftell(file);
+    if (size < 0) req->error = errno;
+    else want = (uint64_t)size > req->offset ? (size_t)((uint64_t)size - req->offset) : 0;
+  }
+
+  if (!req->error && __async_io_prepare_buffer(req, want, &owned) && want > 0) {
+    if (fseek(file, (long)req->offset, SEEK_SET) != 0) req->error = errno;
+    else req->bytes_read = fread(req->buffer, 1, want, file);
+    if (!req->error && ferror(file)) req->error = EIO;
+  }
+
+  fclose(file);
+  __async_io_complete(req, owned);
+}
+
+#endif // ASYNC_IO_POSIX
+
+static int __async_io_worker_main(void *arg) {
+  (void)arg;
+  PROFILE_THREAD("io-worker");
+
+  for (;;) {
+    SDL_LockMutex(aio.lock);
+    while (!aio.head && !aio.stopping) SDL_WaitCondition(aio.available, aio.lock);
+    io_request *req = __async_io_pop_locked();
+    SDL_UnlockMutex(aio.lock);
+
+    // Only empty once stopping, and by then nothing new arrives.
+    if (!req) return 0;
+    PROFILE_SCOPE("async_io_read");
+    __async_io_read_blocking(req);
+  }
+}
+
+#ifdef ASYNC_IO_URING
+
+static bool __async_io_uring_setup(void) {
+  struct io_uring_params p = {0};
+  int fd = (int)syscall(__NR_io_uring_setup, ASYNC_IO_QUEUE_DEPTH, &p);
+  if (fd < 0) {
+    LOG_INFO(LOG_CAT_ASSETS, "io_uring is not available (%s).\n", strerror(errno));
+    return false;
+  }
+  // IORING_FEAT_RW_CUR_POS came with IORING_OP_READ in 5.6, and marks kernels
+  // that support it.
+  if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_RW_CUR_POS)) {
+    LOG_INFO(LOG_CAT_ASSETS, "io_uring is too old to use (features 0x%x).\n", p.features);
+    close(fd);
+    return false;
+  }
+
+  size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  aio.ring_size = sq_size > cq_size ? sq_size : cq_size;
+  aio.sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+  aio.ring = mmap(NULL, aio.ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  aio.sqes = mmap(NULL, aio.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  aio.event_fd = eventfd(0, EFD_CLOEXEC);
+  if (aio.ring == MAP_FAILED || aio.sqes == MAP_FAILED || aio.event_fd < 0) {
+    LOG_WARNING(LOG_CAT_ASSETS, "Could not set up io_uring: %s\n", strerror(errno));
+    if (aio.ring != MAP_FAILED) munmap(aio.ring, aio.ring_size);
+    if (aio.sqes != MAP_FAILED) munmap(aio.sqes, aio.sqes_size);
+    if (aio.event_fd >= 0) close(aio.event_fd);
+    close(fd);
+    return false;
+  }
+
+  uint8_t *ring = aio.ring;
+  aio.ring_fd = fd;
+  aio.sq_head = (_Atomic uint32_t*)(ring + p.sq_off.head);
+  aio.sq_tail = (_Atomic uint32_t*)(ring + p.sq_off.tail);
+  aio.sq_mask = *(uint32_t*)(ring + p.sq_off.ring_mask);
+  aio.sq_array = (uint32_t*)(ring + p.sq_off.array);
+  aio.cq_head = (_Atomic uint32_t*)(ring + p.cq_off.head);
+  aio.cq_tail = (_Atomic uint32_t*)(ring + p.cq_off.tail);
+  aio.cq_mask = *(uint32_t*)(ring + p.cq_off.ring_mask);
+  aio.cqes = (struct io_uring_cqe*)(ring + p.cq_off.cqes);
+
+  // One entry stays free for the wake read.
+  aio.free_count = 0;
+  for (uint32_t i = ASYNC_IO_QUEUE_DEPTH - 1; i > 0; --i) aio.free_slots[aio.free_count++] = i - 1;
+  return true;
+}
+
+static void __async_io_uring_teardown(void) {
+  munmap(aio.sqes, aio.sqes_size);
+  munmap(aio.ring, aio.ring_size);
+  close(aio.event_fd);
+  close(aio.ring_fd);
+}
+
+static void __async_io_uring_push(int fd, void *buffer, size_t size, uint64_t offset, uint64_t user_data) {
+  uint32_t tail = atomic_load_explicit(aio.sq_tail, memory_order_relaxed);
+  uint32_t index = tail & aio.sq_mask;
+  struct io_uring_sqe *sqe = &aio.sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)buffer;
+  sqe->len = size < ASYNC_IO_MAX_READ ? (uint32_t)size : ASYNC_IO_MAX_READ;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  aio.sq_array[index] = index;
+  atomic_store_explicit(aio.sq_tail, tail + 1, memory_order_release);
+}
+
+static void __async_io_uring_push_slot(uint32_t index) {
+  async_io_slot *s = &aio.slots[index];
+  io_request *req = s->req;
+  __async_io_uring_push(s->fd, (uint8_t*)req->buffer + req->bytes_read, s->want - req->bytes_read,
+                        req->offset + req->bytes_read, index);
+}
+
+static void __async_io_uring_finish_slot(uint32_t index) {
+  async_io_slot *s = &aio.slots[index];
+  close(s->fd);
+  __async_io_complete(s->req, s->owned);
+  s->req = NULL;
+  aio.free_slots[aio.free_count++] = index;
+}
+
+// Opens a request and queues its first read, or completes it right away when
+// there is nothing to read.
+static void __async_io_uring_start(io_request *req) {
+  uint32_t index = aio.free_slots[--aio.free_count];
+  async_io_slot *s = &aio.slots[index];
+  if (!__async_io_open(req, &s->fd, &s->want, &s->owned)) {
+    aio.free_slots[aio.free_count++] = index;
+    __async_io_complete(req, false);
+    return;
+  }
+  s->req = req;
+  if (s->want == 0) __async_io_uring_finish_slot(index);
+  else __async_io_uring_push_slot(index);
+}
+
+static void __async_io_uring_reap(const struct io_uring_cqe *cqe, bool *wake_armed) {
+  if (cqe->user_data == ASYNC_IO_WAKE_TAG) {
+    *wake_armed = false;
+    return;
+  }
+
+  uint32_t index = (uint32_t)cqe->user_data;
+  async_io_slot *s = &aio.slots[index];
+  io_request *req = s->req;
+  if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+    __async_io_uring_push_slot(index);
+    return;
+  }
+  if (cqe->res < 0) {
+    req->error = -cqe->res;
+    __async_io_uring_finish_slot(index);
+    return;
+  }
+
+  req->bytes_read += (size_t)cqe->res;
+  // Zero bytes is the end of the file; anything else short gets the rest
+  // asked for again.
+  if (cqe->res > 0 && req->bytes_read < s->want) __async_io_uring_push_slot(index);
+  else __async_io_uring_finish_slot(index);
+}
+
+static int __async_io_uring_main(void *arg) {
+  (void)arg;
+  PROFILE_THREAD("io-uring");
+
+  bool wake_armed = false;
+  io_request *taken[ASYNC_IO_QUEUE_DEPTH];
+  for (;;) {
+    // Start as many queued requests as there are free slots. Opening files
+    // happens outside the lock so submitters never wait on the disk.
+    uint32_t taken_count = 0;
+    SDL_LockMutex(aio.lock);
+    while (taken_count < aio.free_count && aio.head) taken[taken_count++] = __async_io_pop_locked();
+    bool stopping = aio.stopping && !aio.head;
+    SDL_UnlockMutex(aio.lock);
+
+    for (uint32_t i = 0; i < taken_count; ++i) __async_io_uring_start(taken[i]);
+
+    uint32_t in_flight = ASYNC_IO_QUEUE_DEPTH - 1 - aio.free_count;
+    if (stopping && in_flight == 0) break;
+
+    // async_io_read bumps the eventfd; having a read pending on it turns that
+    // into a completion, so a single wait covers both new work and finished
+    // reads.
+    if (!wake_armed) {
+      __async_io_uring_push(aio.event_fd, &aio.event_value, sizeof(aio.event_value), 0, ASYNC_IO_WAKE_TAG);
+      wake_armed = true;
+    }
+
+    uint32_t to_submit = atomic_load_explicit(aio.sq_tail, memory_order_relaxed) -
+                         atomic_load_explicit(aio.sq_head, memory_order_acquire);
+    long r = syscall(__NR_io_uring_enter, aio.ring_fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG_ERROR(LOG_CAT_ASSETS, "io_uring_enter failed: %s\n", strerror(errno));
+      SDL_Delay(1);
+    }
+
+    uint32_t head = atomic_load_explicit(aio.cq_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(aio.cq_tail, memory_order_acquire);
+    for (; head != tail; ++head) {
+      // Copied out so the entry can be handed back before the callback jobs
+      // are queued.
+      struct io_uring_cqe cqe = aio.cqes[head & aio.cq_mask];
+      atomic_store_explicit(aio.cq_head, head + 1, memory_order_release);
+      __async_io_uring_reap(&cqe, &wake_armed);
+    }
+  }
+  return 0;
+}
+
+#endif // ASYNC_IO_URING
+
+static void __async_io_wake(void) {
+#ifdef ASYNC_IO_URING
+  if (aio.backend == ASYNC_IO_BACKEND_URING) {
+    uint64_t one = 1;
+    while (write(aio.event_fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    return;
+  }
+#endif
+  SDL_BroadcastCondition(aio.available);
+}
+
+void async_io_init(void) {
+  aio.lock = SDL_CreateMutex();
+  aio.available = SDL_CreateCondition();
+  check_sdl_result(aio.lock != NULL && aio.available != NULL, "Failed to create async I/O primitives");
+  if (!aio.lock || !aio.available) exit(1);
+
+#ifdef ASYNC_IO_URING
+  if (__async_io_uring_setup()) {
+    aio.backend = ASYNC_IO_BACKEND_URING;
+    aio.threads[0] = SDL_CreateThread(__async_io_uring_main, "io-uring", NULL);
+    check_sdl_result(aio.threads[0] != NULL, "Failed to create io_uring thread");
+    if (!aio.threads[0]) exit(1);
+    aio.thread_count = 1;
+    LOG_INFO(LOG_CAT_ASSETS, "Async I/O started on io_uring with %u reads in flight.\n", ASYNC_IO_QUEUE_DEPTH - 1);
+    return;
+  }
+#endif
+
+  aio.backend = ASYNC_IO_BACKEND_THREADS;
+  for (uint32_t i = 0; i < ASYNC_IO_FALLBACK_THREADS; ++i) {
+    aio.threads[i] = SDL_CreateThread(__async_io_worker_main, "io-worker", NULL);
+    check_sdl_result(aio.threads[i] != NULL, "Failed to create async I/O thread");
+    if (!aio.threads[i]) exit(1);
+  }
+  aio.thread_count = ASYNC_IO_FALLBACK_THREADS;
+  LOG_INFO(LOG_CAT_ASSETS, "Async I/O started with %u reader threads.\n", ASYNC_IO_FALLBACK_THREADS);
+}
+
+void async_io_shutdown(void) {
+  if (aio.backend == ASYNC_IO_BACKEND_NONE) return;
+
+  SDL_LockMutex(aio.lock);
+  aio.stopping = true;
+  SDL_UnlockMutex(aio.lock);
+  __async_io_wake();
+  for (uint32_t i = 0; i < aio.thread_count; ++i) SDL_WaitThread(aio.threads[i], NULL);
+
+#ifdef ASYNC_IO_URING
+  if (aio.backend == ASYNC_IO_BACKEND_URING) __async_io_uring_teardown();
+#endif
+  SDL_DestroyCondition(aio.available);
+  SDL_DestroyMutex(aio.lock);
+  memset(&aio, 0, sizeof(aio));
+}
+
+async_io_backend async_io_get_backend(void) {
+  return aio.backend;
+}
+
+void async_io_read(io_request *requests, uint32_t count) {
+  if (count == 0) return;
+
+  // Every counter is raised before anything can complete, so a waiter never
+  // sees it drop to zero halfway through the batch.
+  for (uint32_t i = 0; i < count; ++i) {
+    requests[i].bytes_read = 0;
+    requests[i].error = 0;
+    requests[i].__next = i + 1 < count ? &requests[i + 1] : NULL;
+    if (requests[i].counter) job_counter_add(requests[i].counter, 1);
+  }
+
+  if (aio.backend == ASYNC_IO_BACKEND_NONE) {
+    for (uint32_t i = 0; i < count; ++i) __async_io_read_blocking(&requests[i]);
+    return;
+  }
+
+  SDL_LockMutex(aio.lock);
+  if (aio.tail) aio.tail->__next = &requests[0];
+  else aio.head = &requests[0];
+  aio.tail = &requests[count - 1];
+  SDL_UnlockMutex(aio.lock);
+  __async_io_wake();
+}
@@ -1,19 +1,83 @@
 #include <core/engine.h>
+#include <core/async_io.h>
+#include <core/job.h>
+#include <core/memory.h>
+#include <util/logger.h>
+#include <util/profiler.h>
+#include <vk/shader_registry.h>
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
 
 #ifdef __VK_BACKEND
 
 #include <vk_mem_alloc.h>
 
+typedef struct engine_shader_file_t {
+  const char *dir;
+  char name[ENGINE_SHADER_NAME_MAX];
+  // The timing report keeps the pointer, so this one has to stay valid.
+  const char *step;
+  vk_shader_code code;
+  bool loaded;
+  timing_report *timing;
+} engine_shader_file;
+
+static void __engine_load_shader_job(void *data) {
+  engine_shader_file *f = data;
+  TIMING_STEP(f->timing, f->step, f->loaded = vk_shader_load(f->dir, f->name, &f->code));
+}
+
+static void __engine_watch_shaders(engine_state *e, const vk_pipeline_config *cfg) {
+  if (!e->shader_dir) {
+    LOG_WARNING(LOG_CAT_CORE, "Shader hot reload needs shader_dir; embedded shaders cannot change.\n");
+    return;
+  }
+  if (!shader_reload_init(&e->shader_reload, &e->vk)) return;
+
+  char vs[SHADER_RELOAD_PATH_MAX], fs[SHADER_RELOAD_PATH_MAX], hlsl[SHADER_RELOAD_PATH_MAX];
+  snprintf(vs, sizeof(vs), "%s/%s-vert.spv", e->shader_dir, e->shader_name);
+  snprintf(fs, sizeof(fs), "%s/%s-frag.spv", e->shader_dir, e->shader_name);
+  snprintf(hlsl, sizeof(hlsl), "%s/%s.hlsl", e->shader_dir, e->shader_name);
+  shader_reload_track(&e->shader_reload, e->vk.tri_pipeline, vs, fs, hlsl, cfg);
+}
+
 void engine_init(engine_state *e, const char *title, int width, int height) {
+    PROFILE_FUNCTION();
+    PROFILE_THREAD("main");
+    timing_begin(&e->startup, "Startup");
+    e->first_frame_done = false;
+
+    TIMING_STEP(&e->startup, "logger + job system",
+                logger_init();
+                job_system_init(e->job_worker_count);
+                async_io_init());
+
+    // Shaders are embedded in the library; only an override directory takes
+    // file I/O, which then overlaps with the Vulkan context coming up.
+    if (!e->shader_name) e->shader_name = ENGINE_DEFAULT_SHADER;
+    engine_shader_file shaders[2] = {
+      { .dir = e->shader_dir, .step = "vertex shader", .timing = &e->startup },
+      { .dir = e->shader_dir, .step = "fragment shader", .timing = &e->startup },
+    };
+    snprintf(shaders[0].name, sizeof(shaders[0].name), "%s-vert", e->shader_name);
+    snprintf(shaders[1].name, sizeof(shaders[1].name), "%s-frag", e->shader_name);
+    job_counter shaders_read = {0};
+    job_run((job_decl[]) {
+      { __engine_load_shader_job, &shaders[0] },
+      { __engine_load_shader_job, &shaders[1] },
+    }, 2, &shaders_read);
+
+    e->vk.pipeline_cache_path = e->pipeline_cache_path;
     vk_context_init(
         &e->vk,
         title,
         width,
-        height);
+        height,
+        &e->startup);
     e->running = true;
 
     // TODO: Technically, in __vk_vma_create_allocation, we set MAPPED,
@@ -24,15 +88,34 @@ void engine_init(engine_state *e, const char *title, int width, int height) {
     
     vk_pipeline_config cfg = vk_default_pipeline_config();
 
-    cfg.layout = e->vk.pipeline_layout;
+    cfg.vertex_layout = vertex_get_layout(e->vertex_format);
     cfg.render_pass = e->vk.render_pass;
 
-    // TODO: This should be called by the program itself to load a shader.
-    // Hardcoding a shader here is not good practice.
-    e->vk.tri_pipeline = vk_pipeline_build(&e->vk, "shaders/tri-vert.spv", "shaders/tri-frag.spv", &cfg);
+    job_wait(&shaders_read);
+    for (uint32_t i = 0; i < 2; ++i) {
+      if (!shaders[i].loaded) {
+        LOG_ERROR(LOG_CAT_VULKAN, "Could not load shader '%s'.\n", shaders[i].name);
+        exit(1);
+      }
+    }
+
+    // Compiles in the background; frames before it is ready are cleared only.
+    e->vk.tri_pipeline = vk_pipeline_request(&e->vk, shaders[0].code, shaders[1].code, &cfg);
+    vk_shader_release(&shaders[0].code);
+    vk_shader_release(&shaders[1].code);
+
+    if (e->shader_hot_reload) __engine_watch_shaders(e, &cfg);
+
+    if (e->threaded_render) {
+      render_thread_start(&e->render, &e->vk, e->vertex_map, cfg.vertex_layout->stride);
+      // Nothing to write into until engine_begin_frame takes a packet.
+      e->vertex_map = NULL;
+    }
 }
 
 void engine_begin_frame(engine_state *e) {
+  if (e->threaded_render)
+    e->vertex_map = render_thread_begin_packet(&e->render)->vertices;
   e->vertex_count = 0;
 }
 
@@ -48,28 +131,125 @@ void engine_draw_triangle_basic(engine_state *e, float x1, float y1, float x2, f
 
 void engine_draw_triangle(engine_state *e, vertex v1, vertex v2, vertex v3) {
   if (e->vertex_count + 3 > MAX_VERTICES) {
-    SDL_Log("[WARNING] Attempted to draw a triangle, but exceeded MAX_VERTICES.\n");
+    LOG_WARNING(LOG_CAT_RENDER, "Attempted to draw a triangle, but exceeded MAX_VERTICES.\n");
     return;
   }
 
   if (e->vertex_map == NULL) {
-    SDL_Log("[WARNING] Attempted to draw a triangle, but GPU vertex mapping doesn't exist.\n");
+    LOG_WARNING(LOG_CAT_RENDER, "Attempted to draw a triangle, but GPU vertex mapping doesn't exist.\n");
     return;
   }
 
-  e->vertex_map[e->vertex_count + 0] = v1;
-  e->vertex_map[e->vertex_count + 1] = v2;
-  e->vertex_map[e->vertex_count + 2] = v3;
+  const vertex tri[3] = { v1, v2, v3 };
+  uint32_t stride = vertex_get_layout(e->vertex_format)->stride;
+  vertex_encode(e->vertex_format, tri, e->vertex_map + (size_t)e->vertex_count * stride, 3);
 
   e->vertex_count += 3;
 }
 
+static void __engine_report_startup(engine_state *e) {
+  e->first_frame_done = true;
+  double ms = timing_elapsed_ms(&e->startup);
+  timing_log(&e->startup);
+  if (ms > ENGINE_STARTUP_TARGET_MS)
+    LOG_WARNING(LOG_CAT_CORE, "First frame took %.1f ms, over the %.0f ms target.\n", ms, ENGINE_STARTUP_TARGET_MS);
+}
+
 void engine_do_render(engine_state *e) {
-  vk_draw_frame(&e->vk, e->vertex_count);
+  PROFILE_FUNCTION();
+  if (e->threaded_render) {
+    e->render.packets[e->render.write_index].vertex_count = e->vertex_count;
+    render_thread_submit(&e->render);
+    e->vertex_map = NULL;
+  } else {
+    vk_draw_frame(&e->vk, e->vertex_count);
+  }
+
+  if (!e->first_frame_done) __engine_report_startup(e);
+}
+
+void engine_log_memory_stats(engine_state *e) {
+  mem_log_stats();
+
+  VmaTotalStatistics stats;
+  vmaCalculateStatistics(e->vk.allocator, &stats);
+  LOG_INFO(LOG_CAT_MEMORY, "GPU memory (VMA): %llu bytes in %u allocations, %llu bytes in %u blocks.\n",
+          (unsigned long long)stats.total.statistics.allocationBytes,
+          stats.total.statistics.allocationCount,
+          (unsigned long long)stats.total.statistics.blockBytes,
+          stats.total.statistics.blockCount);
+}
+
+void engine_run(engine_state *e, const engine_app *app) {
+  if (e->tick_rate == 0) e->tick_rate = ENGINE_DEFAULT_TICK_RATE;
+  const double dt = 1.0 / (double)e->tick_rate;
+
+  const double frequency = (double)SDL_GetPerformanceFrequency();
+  const uint64_t min_frame_ns = e->max_frame_rate ? SDL_NS_PER_SECOND / e->max_frame_rate : 0;
+
+  uint64_t previous = SDL_GetPerformanceCounter();
+  double accumulator = 0.0;
+
+  while (e->running) {
+    PROFILE_SCOPE("frame");
+
+    PROFILE_BEGIN(poll, "poll_events");
+    engine_event ev;
+    while (e->running && platform_poll_events(&ev)) {
+      switch (ev.type) {
+        case ENGINE_EVENT_QUIT:
+          e->running = false;
+          break;
+        case ENGINE_EVENT_RESIZE:
+          e->vk.framebuffer_resized = true;
+          break;
+        default:
+          break;
+      }
+      if (app->event) app->event(e, &ev, app->user);
+    }
+    PROFILE_END(poll);
+    if (!e->running) break;
+
+    uint64_t now = SDL_GetPerformanceCounter();
+    double elapsed = (double)(now - previous) / frequency;
+    previous = now;
+    accumulator += SDL_min(elapsed, ENGINE_MAX_FRAME_TIME);
+
+    while (accumulator >= dt) {
+      PROFILE_SCOPE("update");
+      if (app->update) app->update(e, dt, app->user);
+      accumulator -= dt;
+      ++e->tick_count;
+    }
+
+    engine_begin_frame(e);
+    if (app->render) {
+      PROFILE_SCOPE("render");
+      app->render(e, (float)(accumulator / dt), app->user);
+    }
+    engine_do_render(e);
+
+    if (min_frame_ns) {
+      PROFILE_SCOPE("frame_cap");
+      uint64_t spent_ns = (uint64_t)((double)(SDL_GetPerformanceCounter() - now) / frequency * SDL_NS_PER_SECOND);
+      if (spent_ns < min_frame_ns) SDL_DelayNS(min_frame_ns - spent_ns);
+    }
+  }
 }
 
 [[noreturn]] void engine_quit(engine_state *e) {
+    if (e->threaded_render) render_thread_stop(&e->render);
+#ifdef ENGINE_PROFILE
+    if (e->profile_trace_path) profiler_write_chrome_trace(e->profile_trace_path);
+#endif // ENGINE_PROFILE
+    shader_reload_shutdown(&e->shader_reload);
+    engine_log_memory_stats(e);
     vk_context_shutdown(&e->vk);
+    // Before the job system, which runs the last read callbacks.
+    async_io_shutdown();
+    job_system_shutdown();
+    logger_shutdown();
     exit(0);
 }
 
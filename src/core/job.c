@@ -0,0 +1,759 @@
+// mmap flags and ucontext are behind the default feature set, which -std=c23
+// hides.
+#define _DEFAULT_SOURCE
+
+#include <core/job.h>
+#include <core/memory.h>
+
+#include <util/logger.h>
+#include <util/profiler.h>
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_thread.h>
+
+// Fibers let a job that waits on a counter park itself and hand its worker
+// thread to other work instead of running nested jobs on top of its own stack.
+// x86-64 switches with a few lines of assembly; other Unix targets fall back
+// to ucontext. Everywhere else job_wait keeps helping on the thread stack.
+#if defined(__unix__) && (defined(__x86_64__) || defined(__aarch64__))
+#define JOB_FIBERS 1
+#if defined(__x86_64__) && !defined(JOB_FIBER_UCONTEXT)
+#define JOB_FIBER_ASM 1
+#else
+#include <ucontext.h>
+#endif
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Jobs per worker deque. A worker that fills its deque runs further jobs
+// inline instead of queueing them.
+#define JOB_DEQUE_CAPACITY 4096
+#define JOB_MAX_THREADS 64
+// Failed attempts to find work before an idle worker goes to sleep.
+#define JOB_SPIN_COUNT 256
+#define JOB_CACHE_LINE 64
+// Fibers shared by all workers, and the stack each one gets (plus a guard
+// page). A job that waits while no fiber is free helps on its current stack.
+#define JOB_FIBER_COUNT 128
+#define JOB_FIBER_STACK_SIZE (256 * 1024)
+
+typedef struct job_t {
+  job_fn fn;
+  void *data;
+  job_counter *counter;
+} job;
+
+// Thieves may read a slot while its owner is overwriting it; the steal CAS
+// then fails and the value is discarded. The fields are atomics so that race
+// is well-defined.
+typedef struct job_slot_t {
+  _Atomic(job_fn) fn;
+  _Atomic(void*) data;
+  _Atomic(job_counter*) counter;
+} job_slot;
+
+// Chase-Lev deque (with the C11 memory orderings from Lê et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models"). Only the owner touches
+// `bottom`; `top` is advanced by successful steals and by the owner popping
+// the last job.
+typedef struct job_deque_t {
+  alignas(JOB_CACHE_LINE) _Atomic int64_t top;
+  alignas(JOB_CACHE_LINE) _Atomic int64_t bottom;
+  alignas(JOB_CACHE_LINE) job_slot slots[JOB_DEQUE_CAPACITY];
+} job_deque;
+
+#ifdef JOB_FIBERS
+typedef struct job_fiber_t {
+#ifdef JOB_FIBER_ASM
+  void *sp; // Must stay first, the switch code stores through it.
+#else
+  ucontext_t ctx;
+#endif
+  void *stack;
+  size_t stack_size;
+  struct job_fiber_t *next_free;
+} job_fiber;
+
+typedef struct job_wait_entry_t {
+  job_counter *counter;
+  job_fiber *fiber;
+} job_wait_entry;
+#endif
+
+// Per-thread state. With fibers a job can resume on a different thread than
+// the one it parked on, so this is only ever reached through __job_self().
+typedef struct job_thread_t {
+  int32_t index;
+  uint32_t rng;
+#ifdef JOB_FIBERS
+  job_fiber *current; // NULL while running on the thread's own stack.
+  job_fiber thread_fiber;
+  // Requests left for whichever context runs next on this thread, since a
+  // fiber cannot be handed to another thread until it has switched away.
+  job_fiber *release;
+  job_fiber *park;
+  job_counter *park_counter;
+#endif
+} job_thread;
+
+typedef struct job_system_t {
+  job_deque *deques;
+  SDL_Thread *threads[JOB_MAX_THREADS];
+  uint32_t thread_count;
+
+  SDL_Semaphore *wake;
+  SDL_AtomicInt running;
+
+  // Submissions from threads that do not own a deque.
+  SDL_Mutex *inject_lock;
+  job *inject;
+  uint32_t inject_head;
+  uint32_t inject_count;
+  uint32_t inject_capacity;
+  _Atomic uint32_t inject_pending;
+
+#ifdef JOB_FIBERS
+  job_fiber *fibers;
+  SDL_SpinLock fiber_lock;
+  job_fiber *free_fibers;
+  // Fibers whose counter reached zero, waiting for a thread to pick them up.
+  job_fiber *ready[JOB_FIBER_COUNT];
+  uint32_t ready_head;
+  uint32_t ready_count;
+  _Atomic uint32_t ready_pending;
+  // Parked fibers and the counters they wait on.
+  job_wait_entry waits[JOB_FIBER_COUNT];
+  uint32_t wait_count;
+#endif
+} job_system;
+
+static job_system js;
+
+static _Thread_local job_thread tls_thread = { .index = -1, .rng = 0x9E3779B9u };
+
+// Not inlined, and opaque to the optimizer: a fiber that migrated threads has
+// to see the new thread's TLS block rather than an address cached before it
+// switched.
+static __attribute__((noinline)) job_thread *__job_self(void) {
+  job_thread *t = &tls_thread;
+  __asm__ volatile("" : "+r"(t));
+  return t;
+}
+
+static bool __job_deque_push(job_deque *d, const job *j) {
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+  int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+  if (b - t >= JOB_DEQUE_CAPACITY) return false;
+
+  job_slot *s = &d->slots[b & (JOB_DEQUE_CAPACITY - 1)];
+  atomic_store_explicit(&s->fn, j->fn, memory_order_relaxed);
+  atomic_store_explicit(&s->data, j->data, memory_order_relaxed);
+  atomic_store_explicit(&s->counter, j->counter, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  return true;
+}
+
+static void __job_slot_read(const job_slot *s, job *out) {
+  out->fn = atomic_load_explicit(&s->fn, memory_order_relaxed);
+  out->data = atomic_load_explicit(&s->data, memory_order_relaxed);
+  out->counter = atomic_load_explicit(&s->counter, memory_order_relaxed);
+}
+
+static bool __job_deque_pop(job_deque *d, job *out) {
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+  if (t > b) {
+    // Empty.
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+
+  __job_slot_read(&d->slots[b & (JOB_DEQUE_CAPACITY - 1)], out);
+  if (t != b) return true;
+
+  // Last job: race the thieves for it.
+  bool won = atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed);
+  atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+  return won;
+}
+
+static bool __job_deque_steal(job_deque *d, job *out) {
+  int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+  if (t >= b) return false;
+
+  __job_slot_read(&d->slots[t & (JOB_DEQUE_CAPACITY - 1)], out);
+  return atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed);
+}
+
+static void __job_inject_push(const job *jobs, uint32_t count) {
+  SDL_LockMutex(js.inject_lock);
+
+  if (js.inject_count + count > js.inject_capacity) {
+    uint32_t capacity = js.inject_capacity ? js.inject_capacity : 256;
+    while (capacity < js.inject_count + count) capacity *= 2;
+
+    job *grown = mem_alloc(sizeof(job) * capacity, MEM_TAG_CORE);
+    if (!check_mem_alloc(grown)) exit(1);
+    for (uint32_t i = 0; i < js.inject_count; ++i)
+      grown[i] = js.inject[(js.inject_head + i) % js.inject_capacity];
+
+    mem_free(js.inject);
+    js.inject = grown;
+    js.inject_head = 0;
+    js.inject_capacity = capacity;
+  }
+
+  for (uint32_t i = 0; i < count; ++i)
+    js.inject[(js.inject_head + js.inject_count + i) % js.inject_capacity] = jobs[i];
+  js.inject_count += count;
+  atomic_store_explicit(&js.inject_pending, js.inject_count, memory_order_release);
+
+  SDL_UnlockMutex(js.inject_lock);
+}
+
+static bool __job_inject_pop(job *out) {
+  if (atomic_load_explicit(&js.inject_pending, memory_order_acquire) == 0) return false;
+
+  bool found = false;
+  SDL_LockMutex(js.inject_lock);
+  if (js.inject_count > 0) {
+    *out = js.inject[js.inject_head];
+    js.inject_head = (js.inject_head + 1) % js.inject_capacity;
+    --js.inject_count;
+    atomic_store_explicit(&js.inject_pending, js.inject_count, memory_order_release);
+    found = true;
+  }
+  SDL_UnlockMutex(js.inject_lock);
+  return found;
+}
+
+#ifdef JOB_FIBERS
+static void __job_ready_push_locked(job_fiber *f) {
+  js.ready[(js.ready_head + js.ready_count) % JOB_FIBER_COUNT] = f;
+  ++js.ready_count;
+  atomic_store_explicit(&js.ready_pending, js.ready_count, memory_order_release);
+  SDL_SignalSemaphore(js.wake);
+}
+
+static job_fiber *__job_ready_pop(void) {
+  if (atomic_load_explicit(&js.ready_pending, memory_order_acquire) == 0) return NULL;
+
+  job_fiber *f = NULL;
+  SDL_LockSpinlock(&js.fiber_lock);
+  if (js.ready_count > 0) {
+    f = js.ready[js.ready_head];
+    js.ready_head = (js.ready_head + 1) % JOB_FIBER_COUNT;
+    --js.ready_count;
+    atomic_store_explicit(&js.ready_pending, js.ready_count, memory_order_release);
+  }
+  SDL_UnlockSpinlock(&js.fiber_lock);
+  return f;
+}
+
+static job_fiber *__job_fiber_acquire(void) {
+  SDL_LockSpinlock(&js.fiber_lock);
+  job_fiber *f = js.free_fibers;
+  if (f) js.free_fibers = f->next_free;
+  SDL_UnlockSpinlock(&js.fiber_lock);
+  return f;
+}
+
+// Moves every fiber parked on `counter` to the ready queue. Called by whoever
+// brought the counter to zero.
+static void __job_wake_waiters(job_counter *counter) {
+  SDL_LockSpinlock(&js.fiber_lock);
+  for (uint32_t i = 0; i < js.wait_count;) {
+    // Only dereference the counter once a parked fiber is known to hold it:
+    // with no waiter left it may already be gone.
+    if (js.waits[i].counter == counter && job_counter_done(counter)) {
+      __job_ready_push_locked(js.waits[i].fiber);
+      js.waits[i] = js.waits[--js.wait_count];
+    } else {
+      ++i;
+    }
+  }
+  SDL_UnlockSpinlock(&js.fiber_lock);
+}
+
+// Runs on the context that was just switched to, finishing what the previous
+// one asked for once its registers are safely stored.
+static void __job_after_switch(void) {
+  job_thread *t = __job_self();
+
+  if (t->release) {
+    job_fiber *f = t->release;
+    t->release = NULL;
+    SDL_LockSpinlock(&js.fiber_lock);
+    f->next_free = js.free_fibers;
+    js.free_fibers = f;
+    SDL_UnlockSpinlock(&js.fiber_lock);
+  }
+
+  if (t->park) {
+    job_fiber *f = t->park;
+    job_counter *counter = t->park_counter;
+    t->park = NULL;
+    t->park_counter = NULL;
+    // Checked under the lock so a counter finishing concurrently either sees
+    // the wait entry or is seen as done here.
+    SDL_LockSpinlock(&js.fiber_lock);
+    if (job_counter_done(counter)) {
+      __job_ready_push_locked(f);
+    } else {
+      js.waits[js.wait_count++] = (job_wait_entry) { counter, f };
+    }
+    SDL_UnlockSpinlock(&js.fiber_lock);
+  }
+}
+
+#ifdef JOB_FIBER_ASM
+// Saves the callee-saved registers plus MXCSR and the x87 control word on the
+// current stack, stores the stack pointer in *from and resumes *to.
+void __job_fiber_switch(void **from, void *const *to);
+void __job_fiber_start(void);
+void __job_fiber_entry(job_fiber *self);
+
+__asm__(
+  ".text\n"
+  ".globl __job_fiber_switch\n"
+  ".hidden __job_fiber_switch\n"
+  ".type __job_fiber_switch, @function\n"
+  "__job_fiber_switch:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  subq $8, %rsp\n"
+  "  stmxcsr (%rsp)\n"
+  "  fnstcw 4(%rsp)\n"
+  "  movq %rsp, (%rdi)\n"
+  "  movq (%rsi), %rsp\n"
+  "  ldmxcsr (%rsp)\n"
+  "  fldcw 4(%rsp)\n"
+  "  addq $8, %rsp\n"
+  "  popq %r15\n"
+  "  popq %r14\n"
+  "  popq %r13\n"
+  "  popq %r12\n"
+  "  popq %rbx\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size __job_fiber_switch, .-__job_fiber_switch\n"
+  // First return target of a new fiber; the fiber pointer was placed in rbx.
+  ".globl __job_fiber_start\n"
+  ".hidden __job_fiber_start\n"
+  ".type __job_fiber_start, @function\n"
+  "__job_fiber_start:\n"
+  "  movq %rbx, %rdi\n"
+  "  call __job_fiber_entry\n"
+  "  ud2\n"
+  ".size __job_fiber_start, .-__job_fiber_start\n"
+);
+
+static void __job_fiber_prepare(job_fiber *f) {
+  uintptr_t top = ((uintptr_t)f->stack + f->stack_size) & ~(uintptr_t)15;
+  // Same layout __job_fiber_switch leaves behind: control words, r15..r12,
+  // rbx, rbp, return address. The stack is 16-byte aligned again once
+  // __job_fiber_start calls into C.
+  uint64_t *sp = (uint64_t*)(top - 80);
+  uint32_t *control = (uint32_t*)sp;
+  control[0] = 0x1F80; // MXCSR default: all exceptions masked, round to nearest.
+  control[1] = 0x037F; // x87 default control word.
+  sp[1] = sp[2] = sp[3] = sp[4] = 0;
+  sp[5] = (uint64_t)(uintptr_t)f;
+  sp[6] = 0;
+  sp[7] = (uint64_t)(uintptr_t)__job_fiber_start;
+  f->sp = sp;
+}
+
+static void __job_context_switch(job_fiber *from, job_fiber *to) {
+  __job_fiber_switch(&from->sp, &to->sp);
+}
+#else
+void __job_fiber_entry(job_fiber *self);
+
+// makecontext only passes int arguments, so the pointer travels in two halves.
+static void __job_fiber_trampoline(unsigned int hi, unsigned int lo) {
+  __job_fiber_entry((job_fiber*)(((uintptr_t)hi << 32) | (uintptr_t)lo));
+}
+
+static void __job_fiber_prepare(job_fiber *f) {
+  getcontext(&f->ctx);
+  f->ctx.uc_stack.ss_sp = f->stack;
+  f->ctx.uc_stack.ss_size = f->stack_size;
+  f->ctx.uc_link = NULL;
+  uintptr_t p = (uintptr_t)f;
+  makecontext(&f->ctx, (void (*)(void))__job_fiber_trampoline, 2,
+              (unsigned int)(p >> 32), (unsigned int)(p & 0xFFFFFFFFu));
+}
+
+static void __job_context_switch(job_fiber *from, job_fiber *to) {
+  swapcontext(&from->ctx, &to->ctx);
+}
+#endif
+
+// `to` may be the thread's own context. Execution continues here whenever the
+// calling context is resumed, possibly on another thread.
+static void __job_switch_to(job_fiber *to) {
+  job_thread *t = __job_self();
+  job_fiber *from = t->current ? t->current : &t->thread_fiber;
+  t->current = to == &t->thread_fiber ? NULL : to;
+  __job_context_switch(from, to);
+  __job_after_switch();
+}
+#endif
+
+static void __job_execute(const job *j) {
+  j->fn(j->data);
+  if (j->counter) job_counter_signal(j->counter);
+}
+
+static uint32_t __job_random(job_thread *t) {
+  // xorshift32; only used to spread steal attempts across victims.
+  uint32_t x = t->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  t->rng = x;
+  return x;
+}
+
+// Own deque first (LIFO, cache-warm), then the injection queue, then steal
+// from the other threads starting at a random victim.
+static bool __job_find(job *out) {
+  job_thread *t = __job_self();
+  int32_t self = t->index;
+
+  if (self >= 0 && __job_deque_pop(&js.deques[self], out)) return true;
+  if (__job_inject_pop(out)) return true;
+
+  uint32_t n = js.thread_count;
+  if (n == 0) return false;
+  uint32_t start = __job_random(t) % n;
+  for (uint32_t i = 0; i < n; ++i) {
+    uint32_t victim = (start + i) % n;
+    if ((int32_t)victim == self) continue;
+    if (__job_deque_steal(&js.deques[victim], out)) return true;
+  }
+
+  return false;
+}
+
+static bool __job_try_run_one(void) {
+  job j;
+  if (!__job_find(&j)) return false;
+  __job_execute(&j);
+  return true;
+}
+
+#ifdef JOB_FIBERS
+static bool __job_has_work(void) {
+  if (atomic_load_explicit(&js.ready_pending, memory_order_acquire)) return true;
+  if (atomic_load_explicit(&js.inject_pending, memory_order_acquire)) return true;
+  for (uint32_t i = 0; i < js.thread_count; ++i) {
+    job_deque *d = &js.deques[i];
+    if (atomic_load_explicit(&d->top, memory_order_acquire) <
+        atomic_load_explicit(&d->bottom, memory_order_acquire))
+      return true;
+  }
+  return false;
+}
+
+// Body of every pool fiber: resume fibers that became ready, otherwise run
+// jobs, and hand the thread back once there is nothing left. A fiber that is
+// released goes back to the pool and picks up this loop where it left off
+// the next time it is acquired.
+void __job_fiber_entry(job_fiber *self) {
+  __job_after_switch();
+
+  for (;;) {
+    job_fiber *next = __job_ready_pop();
+    if (next) {
+      __job_self()->release = self;
+      __job_switch_to(next);
+      continue;
+    }
+
+    job j;
+    if (__job_find(&j)) {
+      __job_execute(&j);
+      continue;
+    }
+
+    job_thread *t = __job_self();
+    t->release = self;
+    __job_switch_to(&t->thread_fiber);
+  }
+}
+
+static void __job_fibers_create(void) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t stack_size = (JOB_FIBER_STACK_SIZE + page - 1) & ~(page - 1);
+
+  js.fibers = mem_calloc(JOB_FIBER_COUNT, sizeof(job_fiber), MEM_TAG_CORE);
+  if (!check_mem_alloc(js.fibers)) exit(1);
+
+  for (uint32_t i = 0; i < JOB_FIBER_COUNT; ++i) {
+    job_fiber *f = &js.fibers[i];
+    uint8_t *base = mmap(NULL, stack_size + page, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (base == MAP_FAILED) {
+      LOG_ERROR(LOG_CAT_JOBS, "Failed to allocate fiber stack.\n");
+      exit(1);
+    }
+    // Guard page below the stack turns an overflow into a fault.
+    mprotect(base, page, PROT_NONE);
+
+    f->stack = base + page;
+    f->stack_size = stack_size;
+    __job_fiber_prepare(f);
+    f->next_free = js.free_fibers;
+    js.free_fibers = f;
+  }
+}
+
+static void __job_fibers_destroy(void) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  for (uint32_t i = 0; i < JOB_FIBER_COUNT; ++i) {
+    job_fiber *f = &js.fibers[i];
+    munmap((uint8_t*)f->stack - page, f->stack_size + page);
+  }
+  mem_free(js.fibers);
+}
+#endif
+
+static int __job_worker_main(void *arg) {
+  job_thread *t = __job_self();
+  t->index = (int32_t)(uintptr_t)arg;
+  t->rng ^= (uint32_t)t->index * 0x85EBCA6Bu;
+  PROFILE_THREAD("job-worker");
+
+  uint32_t idle = 0;
+  while (SDL_GetAtomicInt(&js.running)) {
+#ifdef JOB_FIBERS
+    // Jobs run on pool fibers so they can park; when the pool is exhausted
+    // they run on the thread stack like before.
+    if (__job_has_work()) {
+      job_fiber *f = __job_ready_pop();
+      if (!f) f = __job_fiber_acquire();
+      if (f) {
+        __job_switch_to(f);
+      } else {
+        __job_try_run_one();
+      }
+      idle = 0;
+      continue;
+    }
+#else
+    if (__job_try_run_one()) {
+      idle = 0;
+      continue;
+    }
+#endif
+
+    if (++idle < JOB_SPIN_COUNT) {
+      SDL_CPUPauseInstruction();
+      continue;
+    }
+
+    idle = 0;
+    SDL_WaitSemaphore(js.wake);
+  }
+
+  return 0;
+}
+
+void job_system_init(uint32_t worker_count) {
+  if (js.thread_count) {
+    LOG_WARNING(LOG_CAT_JOBS, "Job system is already initialized.\n");
+    return;
+  }
+
+  uint32_t threads = worker_count ? worker_count + 1 : (uint32_t)SDL_GetNumLogicalCPUCores();
+  threads = SDL_clamp(threads, 1, JOB_MAX_THREADS);
+
+  js.deques = mem_aligned_alloc(alignof(job_deque), sizeof(job_deque) * threads, MEM_TAG_CORE);
+  if (!check_mem_alloc(js.deques)) exit(1);
+  memset(js.deques, 0, sizeof(job_deque) * threads);
+
+  js.wake = SDL_CreateSemaphore(0);
+  js.inject_lock = SDL_CreateMutex();
+  check_sdl_result(js.wake != NULL && js.inject_lock != NULL, "Failed to create job system primitives");
+  if (!js.wake || !js.inject_lock) exit(1);
+
+#ifdef JOB_FIBERS
+  __job_fibers_create();
+#endif
+
+  SDL_SetAtomicInt(&js.running, 1);
+  js.thread_count = threads;
+  __job_self()->index = 0;
+
+  for (uint32_t i = 1; i < threads; ++i) {
+    js.threads[i] = SDL_CreateThread(__job_worker_main, "job-worker", (void*)(uintptr_t)i);
+    check_sdl_result(js.threads[i] != NULL, "Failed to create job worker thread");
+    if (!js.threads[i]) exit(1);
+  }
+
+  LOG_INFO(LOG_CAT_JOBS, "Job system started with %u threads.\n", threads);
+}
+
+void job_system_shutdown(void) {
+  if (!js.thread_count) return;
+
+  // Finish whatever is still queued before the workers go away.
+  while (__job_try_run_one()) {}
+
+  SDL_SetAtomicInt(&js.running, 0);
+  for (uint32_t i = 1; i < js.thread_count; ++i) SDL_SignalSemaphore(js.wake);
+  for (uint32_t i = 1; i < js.thread_count; ++i) SDL_WaitThread(js.threads[i], NULL);
+
+#ifdef JOB_FIBERS
+  if (js.wait_count || js.ready_count)
+    LOG_WARNING(LOG_CAT_JOBS, "Job system shut down with %u fibers still waiting.\n", js.wait_count + js.ready_count);
+  __job_fibers_destroy();
+#endif
+
+  SDL_DestroySemaphore(js.wake);
+  SDL_DestroyMutex(js.inject_lock);
+  mem_free(js.inject);
+  mem_free(js.deques);
+
+  memset(&js, 0, sizeof(js));
+  __job_self()->index = -1;
+}
+
+uint32_t job_thread_count(void) {
+  return js.thread_count;
+}
+
+int32_t job_thread_index(void) {
+  return __job_self()->index;
+}
+
+void job_run(const job_decl *jobs, uint32_t count, job_counter *counter) {
+  if (count == 0) return;
+  if (counter) SDL_AddAtomicInt(&counter->value, (int)count);
+
+  if (!js.thread_count) {
+    // No job system: run synchronously so callers work either way.
+    for (uint32_t i = 0; i < count; ++i) {
+      job j = { jobs[i].fn, jobs[i].data, counter };
+      __job_execute(&j);
+    }
+    return;
+  }
+
+  int32_t self = __job_self()->index;
+  if (self >= 0) {
+    for (uint32_t i = 0; i < count; ++i) {
+      job j = { jobs[i].fn, jobs[i].data, counter };
+      if (!__job_deque_push(&js.deques[self], &j)) __job_execute(&j);
+    }
+  } else {
+    job *batch = mem_alloc(sizeof(job) * count, MEM_TAG_CORE);
+    if (!check_mem_alloc(batch)) exit(1);
+    for (uint32_t i = 0; i < count; ++i) batch[i] = (job) { jobs[i].fn, jobs[i].data, counter };
+    __job_inject_push(batch, count);
+    mem_free(batch);
+  }
+
+  uint32_t wake = SDL_min(count, js.thread_count - 1);
+  for (uint32_t i = 0; i < wake; ++i) SDL_SignalSemaphore(js.wake);
+}
+
+void job_counter_add(job_counter *counter, uint32_t count) {
+  SDL_AddAtomicInt(&counter->value, (int)count);
+}
+
+void job_counter_signal(job_counter *counter) {
+  int previous = SDL_AddAtomicInt(&counter->value, -1);
+#ifdef JOB_FIBERS
+  if (previous == 1) __job_wake_waiters(counter);
+#else
+  (void)previous;
+#endif
+}
+
+void job_wait(job_counter *counter) {
+  while (!job_counter_done(counter)) {
+#ifdef JOB_FIBERS
+    // On a pool fiber: park until the counter's last job wakes us, and let
+    // this thread carry on with a ready fiber or a fresh one meanwhile.
+    job_thread *t = __job_self();
+    if (t->current) {
+      job_fiber *next = __job_ready_pop();
+      if (!next) next = __job_fiber_acquire();
+      if (next) {
+        t->park = t->current;
+        t->park_counter = counter;
+        __job_switch_to(next);
+        continue;
+      }
+    }
+#endif
+    // Outside a fiber (or with the pool exhausted) help on this stack.
+    if (!__job_try_run_one()) SDL_CPUPauseInstruction();
+  }
+}
+
+typedef struct job_range_ctx_t {
+  job_range_fn fn;
+  void *data;
+  uint32_t count;
+  uint32_t grain;
+  _Atomic uint64_t next;
+} job_range_ctx;
+
+// Every range job pulls chunks off a shared cursor until the range is used
+// up, so uneven chunk costs balance out without extra splitting.
+static void __job_range_worker(void *data) {
+  job_range_ctx *ctx = data;
+  for (;;) {
+    uint64_t begin = atomic_fetch_add_explicit(&ctx->next, ctx->grain, memory_order_relaxed);
+    if (begin >= ctx->count) break;
+    uint64_t end = SDL_min(begin + ctx->grain, (uint64_t)ctx->count);
+    ctx->fn(ctx->data, (uint32_t)begin, (uint32_t)end);
+  }
+}
+
+void job_parallel_for(uint32_t count, uint32_t grain, job_range_fn fn, void *data) {
+  if (count == 0) return;
+
+  uint32_t threads = js.thread_count ? js.thread_count : 1;
+  if (grain == 0) grain = SDL_max(count / (threads * 4), 1u);
+
+  uint32_t chunks = count / grain + (count % grain != 0);
+  uint32_t jobs = SDL_min(chunks, threads);
+  if (jobs <= 1) {
+    fn(data, 0, count);
+    return;
+  }
+
+  job_range_ctx ctx = { fn, data, count, grain, 0 };
+  job_decl decls[JOB_MAX_THREADS];
+  for (uint32_t i = 0; i < jobs; ++i) decls[i] = (job_decl) { __job_range_worker, &ctx };
+
+  job_counter counter = {0};
+  job_run(decls, jobs, &counter);
+  job_wait(&counter);
+}
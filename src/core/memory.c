@@ -0,0 +1,162 @@
+#include <core/memory.h>
+
+#include <util/logger.h>
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Sits right before every pointer handed out. `offset` is the distance back to
+// what malloc returned. It cannot tell aligned blocks apart, since malloc may
+// hand out an address that already has the alignment; `align_log2` does.
+typedef struct mem_header_t {
+  size_t size;
+  uint32_t offset;
+  uint16_t tag;
+  // Alignment from mem_aligned_alloc, as a power of two; 0 for blocks that
+  // only need malloc's.
+  uint16_t align_log2;
+} mem_header;
+
+// Rounded up so plain blocks keep malloc's alignment.
+#define MEM_HEADER_SIZE \
+  ((sizeof(mem_header) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+typedef struct mem_tag_counters_t {
+  _Atomic size_t live_bytes;
+  _Atomic size_t peak_bytes;
+  _Atomic uint64_t live_count;
+  _Atomic uint64_t total_count;
+} mem_tag_counters;
+
+static mem_tag_counters counters[MEM_TAG_COUNT];
+
+static const char *tag_names[MEM_TAG_COUNT] = {
+  [MEM_TAG_CORE] = "core",
+  [MEM_TAG_RENDERER] = "renderer",
+  [MEM_TAG_ASSETS] = "assets",
+  [MEM_TAG_PLATFORM] = "platform",
+};
+
+static inline mem_header *__mem_header(void *ptr) {
+  return (mem_header*)((uint8_t*)ptr - sizeof(mem_header));
+}
+
+static void __mem_track_alloc(mem_tag tag, size_t size) {
+  mem_tag_counters *c = &counters[tag];
+  size_t live = atomic_fetch_add_explicit(&c->live_bytes, size, memory_order_relaxed) + size;
+  atomic_fetch_add_explicit(&c->live_count, 1, memory_order_relaxed);
+  atomic_fetch_add_explicit(&c->total_count, 1, memory_order_relaxed);
+
+  size_t peak = atomic_load_explicit(&c->peak_bytes, memory_order_relaxed);
+  while (live > peak &&
+         !atomic_compare_exchange_weak_explicit(&c->peak_bytes, &peak, live,
+                                                memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+static void __mem_track_free(mem_tag tag, size_t size) {
+  mem_tag_counters *c = &counters[tag];
+  atomic_fetch_sub_explicit(&c->live_bytes, size, memory_order_relaxed);
+  atomic_fetch_sub_explicit(&c->live_count, 1, memory_order_relaxed);
+}
+
+static void *__mem_finish(uint8_t *raw, uint8_t *ptr, size_t size, mem_tag tag, uint16_t align_log2) {
+  mem_header *h = __mem_header(ptr);
+  h->size = size;
+  h->offset = (uint32_t)(ptr - raw);
+  h->tag = (uint16_t)tag;
+  h->align_log2 = align_log2;
+  __mem_track_alloc(tag, size);
+  return ptr;
+}
+
+void *mem_alloc(size_t size, mem_tag tag) {
+  if (size > SIZE_MAX - MEM_HEADER_SIZE) return NULL;
+  uint8_t *raw = malloc(MEM_HEADER_SIZE + size);
+  if (!raw) return NULL;
+  return __mem_finish(raw, raw + MEM_HEADER_SIZE, size, tag, 0);
+}
+
+void *mem_calloc(size_t count, size_t size, mem_tag tag) {
+  if (size && count > SIZE_MAX / size) return NULL;
+  void *ptr = mem_alloc(count * size, tag);
+  if (ptr) memset(ptr, 0, count * size);
+  return ptr;
+}
+
+void *mem_aligned_alloc(size_t align, size_t size, mem_tag tag) {
+  if (align <= alignof(max_align_t)) return mem_alloc(size, tag);
+  if (size > SIZE_MAX - MEM_HEADER_SIZE - align) return NULL;
+
+  uint8_t *raw = malloc(MEM_HEADER_SIZE + align + size);
+  if (!raw) return NULL;
+  uintptr_t ptr = ((uintptr_t)raw + MEM_HEADER_SIZE + align - 1) & ~(uintptr_t)(align - 1);
+  uint16_t align_log2 = 0;
+  while (((size_t)1 << align_log2) < align) ++align_log2;
+  return __mem_finish(raw, (uint8_t*)ptr, size, tag, align_log2);
+}
+
+void *mem_realloc(void *ptr, size_t size, mem_tag tag) {
+  if (!ptr) return mem_alloc(size, tag);
+
+  mem_header *h = __mem_header(ptr);
+  mem_tag old_tag = (mem_tag)h->tag;
+  size_t old_size = h->size;
+
+  if (h->align_log2) {
+    // Aligned blocks cannot go through realloc without losing the alignment.
+    void *grown = mem_aligned_alloc((size_t)1 << h->align_log2, size, old_tag);
+    if (!grown) return NULL;
+    memcpy(grown, ptr, old_size < size ? old_size : size);
+    mem_free(ptr);
+    return grown;
+  }
+
+  if (size > SIZE_MAX - MEM_HEADER_SIZE) return NULL;
+  uint8_t *raw = realloc((uint8_t*)ptr - MEM_HEADER_SIZE, MEM_HEADER_SIZE + size);
+  if (!raw) return NULL;
+
+  __mem_track_free(old_tag, old_size);
+  return __mem_finish(raw, raw + MEM_HEADER_SIZE, size, old_tag, 0);
+}
+
+void mem_free(void *ptr) {
+  if (!ptr) return;
+  mem_header *h = __mem_header(ptr);
+  __mem_track_free((mem_tag)h->tag, h->size);
+  free((uint8_t*)ptr - h->offset);
+}
+
+mem_stats mem_get_stats(mem_tag tag) {
+  mem_tag_counters *c = &counters[tag];
+  return (mem_stats) {
+    .live_bytes = atomic_load_explicit(&c->live_bytes, memory_order_relaxed),
+    .peak_bytes = atomic_load_explicit(&c->peak_bytes, memory_order_relaxed),
+    .live_count = atomic_load_explicit(&c->live_count, memory_order_relaxed),
+    .total_count = atomic_load_explicit(&c->total_count, memory_order_relaxed),
+  };
+}
+
+const char *mem_tag_name(mem_tag tag) {
+  return tag < MEM_TAG_COUNT ? tag_names[tag] : "unknown";
+}
+
+void mem_log_stats(void) {
+  mem_stats total = {0};
+
+  LOG_INFO(LOG_CAT_MEMORY, "Heap memory by subsystem:\n");
+  for (uint32_t i = 0; i < MEM_TAG_COUNT; ++i) {
+    mem_stats s = mem_get_stats((mem_tag)i);
+    LOG_INFO(LOG_CAT_MEMORY, "\t%-10s %10zu bytes live (peak %zu) in %llu blocks, %llu allocations total\n",
+            mem_tag_name((mem_tag)i), s.live_bytes, s.peak_bytes,
+            (unsigned long long)s.live_count, (unsigned long long)s.total_count);
+
+    total.live_bytes += s.live_bytes;
+    total.live_count += s.live_count;
+    total.total_count += s.total_count;
+  }
+  LOG_INFO(LOG_CAT_MEMORY, "\t%-10s %10zu bytes live in %llu blocks, %llu allocations total\n",
+          "total", total.live_bytes, (unsigned long long)total.live_count,
+          (unsigned long long)total.total_count);
+}
@@ -0,0 +1,79 @@
+#include <core/pool.h>
+
+#include <util/logger.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL_log.h>
+
+void pool_init(pool *p, uint32_t item_size, uint32_t capacity, mem_tag tag) {
+  if (capacity == 0 || capacity > POOL_MAX_CAPACITY) {
+    LOG_ERROR(LOG_CAT_MEMORY, "Pool capacity %u is out of range (1..%u).\n", capacity, POOL_MAX_CAPACITY);
+    exit(1);
+  }
+
+  p->items = mem_alloc((size_t)item_size * capacity, tag);
+  p->generations = mem_alloc(sizeof(uint16_t) * capacity, tag);
+  p->next_free = mem_alloc(sizeof(uint16_t) * capacity, tag);
+  p->alive = mem_calloc(capacity, sizeof(bool), tag);
+  if (!check_mem_alloc(p->items) || !check_mem_alloc(p->generations) ||
+      !check_mem_alloc(p->next_free) || !check_mem_alloc(p->alive))
+    exit(1);
+
+  p->item_size = item_size;
+  p->capacity = capacity;
+  p->count = 0;
+
+  // Chain every slot so the lowest indices are handed out first.
+  for (uint32_t i = 0; i < capacity; ++i) {
+    p->generations[i] = 1;
+    p->next_free[i] = (uint16_t)(i + 1 < capacity ? i + 1 : POOL_MAX_CAPACITY);
+  }
+  p->free_head = 0;
+}
+
+void pool_destroy(pool *p) {
+  mem_free(p->items);
+  mem_free(p->generations);
+  mem_free(p->next_free);
+  mem_free(p->alive);
+  memset(p, 0, sizeof(*p));
+}
+
+uint32_t pool_add(pool *p, const void *item) {
+  if (p->free_head == POOL_MAX_CAPACITY) {
+    LOG_WARNING(LOG_CAT_MEMORY, "Pool is full (%u items).\n", p->capacity);
+    return POOL_NULL_HANDLE;
+  }
+
+  uint32_t index = p->free_head;
+  p->free_head = p->next_free[index];
+  p->alive[index] = true;
+  ++p->count;
+
+  uint8_t *slot = p->items + (size_t)index * p->item_size;
+  if (item) memcpy(slot, item, p->item_size);
+  else memset(slot, 0, p->item_size);
+
+  return pool_handle_at(p, index);
+}
+
+void *pool_get(const pool *p, uint32_t handle) {
+  uint32_t index = pool_handle_index(handle);
+  if (handle == POOL_NULL_HANDLE || pool_handle_at(p, index) != handle) return NULL;
+  return p->items + (size_t)index * p->item_size;
+}
+
+bool pool_remove(pool *p, uint32_t handle) {
+  if (!pool_get(p, handle)) return false;
+
+  uint32_t index = pool_handle_index(handle);
+  p->alive[index] = false;
+  // Skip 0 on wrap-around so no live handle ever equals POOL_NULL_HANDLE.
+  if (++p->generations[index] == 0) p->generations[index] = 1;
+  p->next_free[index] = (uint16_t)p->free_head;
+  p->free_head = index;
+  --p->count;
+  return true;
+}
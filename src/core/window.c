@@ -2,8 +2,10 @@
 #include <core/window.h>
 
 #include <SDL3/SDL.h>
+#include <SDL3/SDL_vulkan.h>
 
 #include <util/logger.h>
+#include <util/profiler.h>
 
 #ifdef __VK_BACKEND
     #define FLAGS SDL_WINDOW_VULKAN
@@ -11,11 +13,25 @@
     #define FLAGS 0
 #endif // __VK_BACKEND
 
-void window_init(window *w, const char *title, int width, int height) {
+void window_init_video(void) {
+    if (SDL_WasInit(SDL_INIT_VIDEO)) return;
     check_sdl_result(
         SDL_Init(SDL_INIT_VIDEO),
         "Could not initialize SDL"
     );
+#ifdef __VK_BACKEND
+    // Decides which surface extensions SDL_Vulkan_GetInstanceExtensions
+    // reports, so it has to happen before the instance is created.
+    check_sdl_result(
+        SDL_Vulkan_LoadLibrary(NULL),
+        "Could not load the Vulkan library"
+    );
+#endif // __VK_BACKEND
+}
+
+void window_init(window *w, const char *title, int width, int height) {
+    PROFILE_FUNCTION();
+    window_init_video();
 
     w->window = SDL_CreateWindow(title, width, height, SDL_WINDOW_VULKAN);
     check_sdl_result(
@@ -26,5 +42,8 @@ void window_init(window *w, const char *title, int width, int height) {
 
 void window_shutdown(window *w) {
     SDL_DestroyWindow(w->window);
+#ifdef __VK_BACKEND
+    SDL_Vulkan_UnloadLibrary();
+#endif // __VK_BACKEND
     SDL_Quit();
 }
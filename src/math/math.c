@@ -1,2 +0,0 @@
-#include <math/math_types.h>
-
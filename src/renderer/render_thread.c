@@ -0,0 +1,93 @@
+#include <renderer/render_thread.h>
+
+#include <core/memory.h>
+#include <util/logger.h>
+#include <util/profiler.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL_log.h>
+
+#ifdef __VK_BACKEND
+
+static int __render_thread_main(void *data) {
+  render_thread *rt = data;
+  PROFILE_THREAD("render");
+
+  for (;;) {
+    PROFILE_BEGIN(wait, "wait_packet");
+    SDL_WaitSemaphore(rt->packet_ready);
+    PROFILE_END(wait);
+    // render_thread_stop only wakes us once every packet has been drawn.
+    if (!SDL_GetAtomicInt(&rt->running)) break;
+
+    frame_packet *packet = &rt->packets[rt->read_index];
+    memcpy(rt->gpu_vertices, packet->vertices, (size_t)packet->vertex_count * rt->stride);
+    vk_draw_frame(rt->vk, packet->vertex_count);
+
+    rt->read_index ^= 1;
+    SDL_SignalSemaphore(rt->packet_free);
+  }
+
+  return 0;
+}
+
+void render_thread_start(render_thread *rt, vk_context *vk, uint8_t *gpu_vertices, uint32_t stride) {
+  memset(rt, 0, sizeof(*rt));
+  rt->vk = vk;
+  rt->gpu_vertices = gpu_vertices;
+  rt->stride = stride;
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    rt->packets[i].vertices = mem_alloc((size_t)MAX_VERTICES * stride, MEM_TAG_RENDERER);
+    if (!check_mem_alloc(rt->packets[i].vertices)) exit(1);
+  }
+
+  rt->packet_free = SDL_CreateSemaphore(2);
+  rt->packet_ready = SDL_CreateSemaphore(0);
+  check_sdl_result(rt->packet_free != NULL && rt->packet_ready != NULL, "Failed to create render thread semaphores");
+  if (!rt->packet_free || !rt->packet_ready) exit(1);
+
+  SDL_SetAtomicInt(&rt->running, 1);
+  rt->thread = SDL_CreateThread(__render_thread_main, "render", rt);
+  check_sdl_result(rt->thread != NULL, "Failed to create render thread");
+  if (!rt->thread) exit(1);
+
+  LOG_INFO(LOG_CAT_RENDER, "Render thread started.\n");
+}
+
+#endif // __VK_BACKEND
+
+frame_packet *render_thread_begin_packet(render_thread *rt) {
+  PROFILE_FUNCTION();
+  SDL_WaitSemaphore(rt->packet_free);
+  frame_packet *packet = &rt->packets[rt->write_index];
+  packet->vertex_count = 0;
+  rt->writing = true;
+  return packet;
+}
+
+void render_thread_submit(render_thread *rt) {
+  PROFILE_FUNCTION();
+  rt->writing = false;
+  rt->write_index ^= 1;
+  SDL_SignalSemaphore(rt->packet_ready);
+}
+
+void render_thread_stop(render_thread *rt) {
+  if (!rt->thread) return;
+
+  // Both packets coming back means every submitted frame has been drawn. One
+  // may still be held by the game thread if it stops mid-frame.
+  for (uint32_t i = rt->writing ? 1 : 0; i < 2; ++i) SDL_WaitSemaphore(rt->packet_free);
+  SDL_SetAtomicInt(&rt->running, 0);
+  SDL_SignalSemaphore(rt->packet_ready);
+  SDL_WaitThread(rt->thread, NULL);
+
+  SDL_DestroySemaphore(rt->packet_free);
+  SDL_DestroySemaphore(rt->packet_ready);
+  for (uint32_t i = 0; i < 2; ++i) mem_free(rt->packets[i].vertices);
+
+  memset(rt, 0, sizeof(*rt));
+}
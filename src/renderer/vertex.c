@@ -0,0 +1,127 @@
+#include <renderer/vertex.h>
+
+#include <stddef.h>
+#include <string.h>
+
+static const vertex_layout layouts[VERTEX_FORMAT_COUNT] = {
+  [VERTEX_FORMAT_F32] = {
+    .stride = sizeof(vertex),
+    .attribute_count = 3,
+    .attributes = {
+      { 0, VERTEX_ATTR_FLOAT3, offsetof(vertex, pos) },
+      { 1, VERTEX_ATTR_FLOAT3, offsetof(vertex, color) },
+      { 2, VERTEX_ATTR_FLOAT2, offsetof(vertex, uv) },
+    }
+  },
+  [VERTEX_FORMAT_HALF] = {
+    .stride = sizeof(vertex_half),
+    .attribute_count = 3,
+    .attributes = {
+      { 0, VERTEX_ATTR_HALF4, offsetof(vertex_half, pos) },
+      { 1, VERTEX_ATTR_UNORM8X4, offsetof(vertex_half, color) },
+      { 2, VERTEX_ATTR_UNORM16X2, offsetof(vertex_half, uv) },
+    }
+  },
+  [VERTEX_FORMAT_SNORM16] = {
+    .stride = sizeof(vertex_snorm16),
+    .attribute_count = 3,
+    .attributes = {
+      { 0, VERTEX_ATTR_SNORM16X4, offsetof(vertex_snorm16, pos) },
+      { 1, VERTEX_ATTR_UNORM8X4, offsetof(vertex_snorm16, color) },
+      { 2, VERTEX_ATTR_UNORM16X2, offsetof(vertex_snorm16, uv) },
+    }
+  },
+};
+
+const vertex_layout *vertex_get_layout(vertex_format format) {
+  if (format >= VERTEX_FORMAT_COUNT) return &layouts[VERTEX_FORMAT_F32];
+  return &layouts[format];
+}
+
+static inline float clampf(float x, float lo, float hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+static inline uint8_t pack_unorm8(float x) {
+  return (uint8_t)(clampf(x, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static inline uint16_t pack_unorm16(float x) {
+  return (uint16_t)(clampf(x, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+static inline int16_t pack_snorm16(float x) {
+  return (int16_t)lroundf(clampf(x, -1.0f, 1.0f) * 32767.0f);
+}
+
+uint16_t vertex_float_to_half(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t exp = (x >> 23) & 0xFF;
+  uint32_t mant = x & 0x7FFFFF;
+
+  // Inf / NaN (keep NaNs quiet).
+  if (exp == 0xFF) return (uint16_t)(sign | 0x7C00 | (mant ? 0x200 : 0));
+
+  int32_t e = (int32_t)exp - 127 + 15;
+  if (e >= 0x1F) return (uint16_t)(sign | 0x7C00);
+
+  if (e <= 0) {
+    // Result is a half subnormal (or rounds to zero).
+    if (e < -10) return (uint16_t)sign;
+    mant |= 0x800000;
+    uint32_t shift = (uint32_t)(14 - e);
+    uint32_t h = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (h & 1))) ++h;
+    return (uint16_t)(sign | h);
+  }
+
+  // Round to nearest even; a carry out of the mantissa correctly bumps the
+  // exponent (and overflows to inf at the top).
+  uint32_t h = sign | ((uint32_t)e << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1FFF;
+  if (rem > 0x1000 || (rem == 0x1000 && (h & 1))) ++h;
+  return (uint16_t)h;
+}
+
+void vertex_encode(vertex_format format, const vertex *src, void *dst, uint32_t count) {
+  switch (format) {
+  case VERTEX_FORMAT_HALF: {
+    vertex_half *out = (vertex_half*)dst;
+    for (uint32_t i = 0; i < count; ++i) {
+      const vertex *v = &src[i];
+      out[i] = (vertex_half) {
+        .pos = {
+          vertex_float_to_half(v->pos.x),
+          vertex_float_to_half(v->pos.y),
+          vertex_float_to_half(v->pos.z),
+          0
+        },
+        .color = { pack_unorm8(v->color.r), pack_unorm8(v->color.g), pack_unorm8(v->color.b), 255 },
+        .uv = { pack_unorm16(v->uv.x), pack_unorm16(v->uv.y) }
+      };
+    }
+    break;
+  }
+  case VERTEX_FORMAT_SNORM16: {
+    vertex_snorm16 *out = (vertex_snorm16*)dst;
+    for (uint32_t i = 0; i < count; ++i) {
+      const vertex *v = &src[i];
+      out[i] = (vertex_snorm16) {
+        .pos = { pack_snorm16(v->pos.x), pack_snorm16(v->pos.y), pack_snorm16(v->pos.z), 0 },
+        .color = { pack_unorm8(v->color.r), pack_unorm8(v->color.g), pack_unorm8(v->color.b), 255 },
+        .uv = { pack_unorm16(v->uv.x), pack_unorm16(v->uv.y) }
+      };
+    }
+    break;
+  }
+  case VERTEX_FORMAT_F32:
+  default:
+    memcpy(dst, src, sizeof(vertex) * count);
+    break;
+  }
+}
@@ -0,0 +1,96 @@
+#include <util/archive.h>
+
+#include <util/logger.h>
+#include <util/lz.h>
+#include <util/profiler.h>
+
+#include <stdalign.h>
+#include <string.h>
+
+bool archive_open(archive *a, const char *path) {
+  *a = (archive) {0};
+  // Lookups jump around the table and blobs are read whole once found, so
+  // the kernel's default readahead is the right fit.
+  if (!map_file(path, &a->view, FILE_MAP_DEFAULT)) return false;
+
+  const file_view *v = &a->view;
+  if (v->size < sizeof(archive_header)) {
+    LOG_ERROR(LOG_CAT_ASSETS, "'%s' is too small to be an archive.\n", path);
+    goto fail;
+  }
+
+  const archive_header *h = (const archive_header*)v->data;
+  if (h->magic != ARCHIVE_MAGIC || h->version != ARCHIVE_VERSION) {
+    LOG_ERROR(LOG_CAT_ASSETS, "'%s' is not a version %u archive.\n", path, ARCHIVE_VERSION);
+    goto fail;
+  }
+  if (h->toc_offset % alignof(archive_entry) != 0 || h->toc_offset > v->size ||
+      h->entry_count > (v->size - h->toc_offset) / sizeof(archive_entry)) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Archive '%s' has its table of contents out of bounds.\n", path);
+    goto fail;
+  }
+
+  // Checked once here so lookups and reads can trust the table.
+  const archive_entry *entries = (const archive_entry*)(v->data + h->toc_offset);
+  for (uint32_t i = 0; i < h->entry_count; ++i) {
+    const archive_entry *e = &entries[i];
+    if (i > 0 && e->hash <= entries[i - 1].hash) {
+      LOG_ERROR(LOG_CAT_ASSETS, "Archive '%s' has an unsorted table of contents.\n", path);
+      goto fail;
+    }
+    if (e->offset > v->size || e->size > v->size - e->offset) {
+      LOG_ERROR(LOG_CAT_ASSETS, "Archive '%s' entry %016llx is out of bounds.\n", path, (unsigned long long)e->hash);
+      goto fail;
+    }
+    if ((e->flags != ARCHIVE_ENTRY_STORED && e->flags != ARCHIVE_ENTRY_LZ) ||
+        (e->flags == ARCHIVE_ENTRY_STORED && e->raw_size != e->size) || e->raw_size > SIZE_MAX) {
+      LOG_ERROR(LOG_CAT_ASSETS, "Archive '%s' entry %016llx has an unknown encoding.\n", path, (unsigned long long)e->hash);
+      goto fail;
+    }
+  }
+
+  a->entries = entries;
+  a->entry_count = h->entry_count;
+  LOG_DEBUG(LOG_CAT_ASSETS, "Opened archive '%s' with %u entries.\n", path, a->entry_count);
+  return true;
+
+fail:
+  unmap_file(&a->view);
+  return false;
+}
+
+void archive_close(archive *a) {
+  unmap_file(&a->view);
+  *a = (archive) {0};
+}
+
+const archive_entry *archive_find_hash(const archive *a, uint64_t hash) {
+  uint32_t lo = 0, hi = a->entry_count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    uint64_t h = a->entries[mid].hash;
+    if (h == hash) return &a->entries[mid];
+    if (hash < h) hi = mid;
+    else lo = mid + 1;
+  }
+  return NULL;
+}
+
+const archive_entry *archive_find(const archive *a, const char *path) {
+  return archive_find_hash(a, archive_hash_path(path));
+}
+
+bool archive_read(const archive *a, const archive_entry *entry, void *dst) {
+  PROFILE_FUNCTION();
+  const uint8_t *data = archive_entry_data(a, entry);
+  if (entry->flags == ARCHIVE_ENTRY_STORED) {
+    if (entry->size) memcpy(dst, data, (size_t)entry->size);
+    return true;
+  }
+
+  if (!lz_decompress_parallel(data, (size_t)entry->size, dst, (size_t)entry->raw_size)) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Archive entry %016llx is corrupt.\n", (unsigned long long)entry->hash);
+    return false;
+  }
+  return true;
+}
@@ -1,37 +1,134 @@
+// mmap and madvise are behind the default feature set, which -std=c23 hides.
+#define _DEFAULT_SOURCE
+
 #include <util/file_io.h>
 
+#include <core/memory.h>
+#include <util/logger.h>
+
 #include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define FILE_IO_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Size of an open file, leaving it rewound. False if it cannot be told.
+static bool __file_size(FILE *file, const char *path, size_t *size) {
+  long fsize = -1;
+  if (fseek(file, 0, SEEK_END) == 0) fsize = ftell(file);
+  if (fsize < 0) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not get the size of file '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+  rewind(file);
+  *size = (size_t)fsize;
+  return true;
+}
+
 uint8_t *read_entire_file(const char *path, size_t *size) {
   FILE *file = fopen(path, "rb");
   if (!file) {
-    fprintf(stderr, "[ERROR] Could not open file '%s': %s\n",
-	    path, strerror(errno));
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not open file '%s': %s\n", path, strerror(errno));
     return NULL;
   }
 
-  fseek(file, 0, SEEK_END);
-  size_t fsize = ftell(file);
-  rewind(file);
+  size_t fsize;
+  if (!__file_size(file, path, &fsize)) {
+    fclose(file);
+    return NULL;
+  }
 
-  uint8_t *buffer = (uint8_t*)malloc(fsize);
+  uint8_t *buffer = (uint8_t*)mem_alloc(fsize, MEM_TAG_ASSETS);
   if (!buffer) {
-    fprintf(stderr, "[ERROR] Could not allocate buffer to read file '%s'.\n", path);
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not allocate buffer to read file '%s'.\n", path);
     fclose(file);
     return NULL;
   }
 
   if (fread(buffer, 1, fsize, file) != fsize) {
-    fprintf(stderr, "[ERROR] Could not read file '%s': %s.\n", path, strerror(errno));
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not read file '%s': %s.\n", path, strerror(errno));
+    mem_free(buffer);
     fclose(file);
     return NULL;
   }
-  
+
   fclose(file);
 
   *size = fsize;
   return buffer;
 }
+
+#ifdef FILE_IO_MMAP
+
+bool map_file(const char *path, file_view *view, file_map_flags flags) {
+  *view = (file_view) {0};
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not open file '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not stat file '%s': %s\n", path, strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  // mmap refuses zero-length mappings.
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERROR(LOG_CAT_ASSETS, "Could not map file '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+
+  // Hints only; the view works the same if the kernel ignores them.
+  if (flags & FILE_MAP_SEQUENTIAL) madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+  if (flags & FILE_MAP_WILLNEED) madvise(data, (size_t)st.st_size, MADV_WILLNEED);
+
+  view->data = data;
+  view->size = (size_t)st.st_size;
+  view->mapped = true;
+  return true;
+}
+
+void unmap_file(file_view *view) {
+  if (view->mapped) munmap((void*)view->data, view->size);
+  else mem_free((void*)view->data);
+  *view = (file_view) {0};
+}
+
+#else
+
+bool map_file(const char *path, file_view *view, file_map_flags flags) {
+  (void)flags;
+  *view = (file_view) {0};
+  size_t size;
+  uint8_t *data = read_entire_file(path, &size);
+  if (!data) return false;
+  view->data = data;
+  view->size = size;
+  return true;
+}
+
+void unmap_file(file_view *view) {
+  mem_free((void*)view->data);
+  *view = (file_view) {0};
+}
+
+#endif // FILE_IO_MMAP
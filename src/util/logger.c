@@ -1,12 +1,412 @@
 #include <util/logger.h>
 
+#include <core/memory.h>
+
+#include <SDL3/SDL_cpuinfo.h>
 #include <SDL3/SDL_error.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_timer.h>
 
+#include <stdatomic.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Records in the ring; must be a power of two.
+#define LOG_RING_CAPACITY 1024
+// Room for the contents of string arguments, shared by all of a record's
+// arguments. Longer strings are truncated.
+#define LOG_STRING_BYTES 192
+#define LOG_LINE_BYTES 1024
+
+typedef union log_value_t {
+  int64_t i;
+  uint64_t u;
+  double d;
+  uint32_t string_offset;
+  const void *p;
+} log_value;
+
+typedef struct log_record_t {
+  // Vyukov bounded queue sequence: equal to the slot's position when it is
+  // free for that position, position + 1 once it holds a record.
+  _Atomic size_t sequence;
+  const char *fmt;
+  uint32_t suppressed;
+  uint8_t level;
+  uint8_t category;
+  uint8_t arg_count;
+  uint8_t types[LOG_MAX_ARGS];
+  log_value values[LOG_MAX_ARGS];
+  uint32_t string_bytes;
+  char strings[LOG_STRING_BYTES];
+} log_record;
+
+typedef struct logger_t {
+  log_record *ring;
+  _Atomic size_t enqueue_pos;
+  // Only touched by the writer thread (or under the sync path, by nobody).
+  size_t dequeue_pos;
+  _Atomic size_t dequeued;
+
+  SDL_Thread *thread;
+  SDL_Semaphore *wake;
+  _Atomic int running;
+  _Atomic int sleeping;
+  _Atomic uint32_t dropped;
+  // Set by logger_shutdown before the ring goes away; producers that see it
+  // print directly instead. `producers` counts pushes that may still be
+  // writing into the ring.
+  _Atomic int closed;
+  _Atomic int producers;
+  bool atexit_registered;
+} logger;
+
+static logger lg;
+
+uint8_t __log_levels[LOG_CAT_COUNT] = {
+  [LOG_CAT_CORE] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_JOBS] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_MEMORY] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_PLATFORM] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_RENDER] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_VULKAN] = LOG_DEFAULT_LEVEL,
+  [LOG_CAT_ASSETS] = LOG_DEFAULT_LEVEL,
+};
+
+static const char *level_names[LOG_LEVEL_OFF] = {
+  [LOG_LEVEL_TRACE] = "TRACE",
+  [LOG_LEVEL_DEBUG] = "DEBUG",
+  [LOG_LEVEL_INFO] = "INFO",
+  [LOG_LEVEL_WARNING] = "WARNING",
+  [LOG_LEVEL_ERROR] = "ERROR",
+};
+
+static const char *category_names[LOG_CAT_COUNT] = {
+  [LOG_CAT_CORE] = "core",
+  [LOG_CAT_JOBS] = "jobs",
+  [LOG_CAT_MEMORY] = "memory",
+  [LOG_CAT_PLATFORM] = "platform",
+  [LOG_CAT_RENDER] = "render",
+  [LOG_CAT_VULKAN] = "vulkan",
+  [LOG_CAT_ASSETS] = "assets",
+};
+
+const char *log_level_name(int level) {
+  return level >= 0 && level < LOG_LEVEL_OFF ? level_names[level] : "OFF";
+}
+
+const char *log_category_name(log_category category) {
+  return category < LOG_CAT_COUNT ? category_names[category] : "unknown";
+}
+
+void logger_set_level(log_category category, int level) {
+  if (category >= LOG_CAT_COUNT) return;
+  if (level < LOG_LEVEL_TRACE) level = LOG_LEVEL_TRACE;
+  if (level > LOG_LEVEL_OFF) level = LOG_LEVEL_OFF;
+  __log_levels[category] = (uint8_t)level;
+}
+
+void logger_set_all_levels(int level) {
+  for (uint32_t i = 0; i < LOG_CAT_COUNT; ++i) logger_set_level((log_category)i, level);
+}
+
+int logger_get_level(log_category category) {
+  return category < LOG_CAT_COUNT ? __log_levels[category] : LOG_LEVEL_OFF;
+}
+
+static void __log_fill(log_record *r, const log_site *site, uint32_t suppressed, uint32_t count, const log_arg *args) {
+  r->fmt = site->fmt;
+  r->suppressed = suppressed;
+  r->level = site->level;
+  r->category = site->category;
+  r->arg_count = (uint8_t)(count < LOG_MAX_ARGS ? count : LOG_MAX_ARGS);
+  r->string_bytes = 0;
+
+  for (uint32_t i = 0; i < r->arg_count; ++i) {
+    r->types[i] = (uint8_t)args[i].type;
+    if (args[i].type != LOG_ARG_STRING) {
+      r->values[i].u = args[i].u;
+      continue;
+    }
+
+    // Strings are copied since the caller's buffer may be gone by the time
+    // the record is formatted.
+    const char *s = args[i].s ? args[i].s : "(null)";
+    uint32_t room = LOG_STRING_BYTES - r->string_bytes;
+    size_t len = strlen(s);
+    if (room == 0) {
+      r->values[i].string_offset = LOG_STRING_BYTES - 1;
+      continue;
+    }
+    if (len >= room) len = room - 1;
+    memcpy(r->strings + r->string_bytes, s, len);
+    r->strings[r->string_bytes + len] = '\0';
+    r->values[i].string_offset = r->string_bytes;
+    r->string_bytes += (uint32_t)len + 1;
+  }
+}
+
+// Formats one conversion. `spec` holds "%flags width.precision" without the
+// length modifier; the modifier that matches the stored value is appended.
+static int __log_format_arg(char *out, size_t cap, char *spec, size_t spec_len, char conv,
+                            const log_record *r, uint32_t arg) {
+  log_arg_type type = (log_arg_type)r->types[arg];
+  log_value v = r->values[arg];
+
+  switch (conv) {
+    case 'd': case 'i': case 'c': {
+      int64_t value = type == LOG_ARG_U32 ? (int64_t)(int32_t)v.u
+                    : type == LOG_ARG_DOUBLE ? (int64_t)v.d : v.i;
+      if (conv == 'c') {
+        memcpy(spec + spec_len, "c", 2);
+        return snprintf(out, cap, spec, (int)value);
+      }
+      memcpy(spec + spec_len, "lld", 4);
+      spec[spec_len + 2] = conv;
+      return snprintf(out, cap, spec, (long long)value);
+    }
+    case 'u': case 'x': case 'X': case 'o': {
+      uint64_t value = type == LOG_ARG_I32 ? (uint64_t)(uint32_t)v.i
+                     : type == LOG_ARG_DOUBLE ? (uint64_t)v.d : v.u;
+      memcpy(spec + spec_len, "ll", 2);
+      spec[spec_len + 2] = conv;
+      spec[spec_len + 3] = '\0';
+      return snprintf(out, cap, spec, (unsigned long long)value);
+    }
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+      double value = type == LOG_ARG_DOUBLE ? v.d
+                   : (type == LOG_ARG_I32 || type == LOG_ARG_I64) ? (double)v.i : (double)v.u;
+      spec[spec_len] = conv;
+      spec[spec_len + 1] = '\0';
+      return snprintf(out, cap, spec, value);
+    }
+    case 's': {
+      const char *value = type == LOG_ARG_STRING ? r->strings + v.string_offset : "(?)";
+      memcpy(spec + spec_len, "s", 2);
+      return snprintf(out, cap, spec, value);
+    }
+    case 'p': {
+      memcpy(spec + spec_len, "p", 2);
+      return snprintf(out, cap, spec, type == LOG_ARG_POINTER ? v.p : NULL);
+    }
+    default:
+      return 0;
+  }
+}
+
+static void __log_format(const log_record *r, char *out, size_t cap) {
+  size_t n = 0;
+  uint32_t arg = 0;
+
+  for (const char *f = r->fmt; *f && n + 1 < cap;) {
+    if (*f != '%') {
+      out[n++] = *f++;
+      continue;
+    }
+    if (f[1] == '%') {
+      out[n++] = '%';
+      f += 2;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conversion
+    char spec[32];
+    size_t spec_len = 0;
+    const char *start = f;
+    spec[spec_len++] = *f++;
+    while (*f && strchr("-+ #0123456789.", *f) && spec_len < sizeof(spec) - 5) spec[spec_len++] = *f++;
+    while (*f && strchr("hlLqjzt", *f)) ++f;
+    char conv = *f;
+    if (!conv || !strchr("diucxXofFeEgGaAsp", conv) || arg >= r->arg_count) {
+      // Unsupported or missing argument: print the spec as written.
+      size_t len = (size_t)(f - start) + (conv ? 1 : 0);
+      if (len > cap - 1 - n) len = cap - 1 - n;
+      memcpy(out + n, start, len);
+      n += len;
+      f = start + len;
+      continue;
+    }
+    ++f;
+
+    int written = __log_format_arg(out + n, cap - n, spec, spec_len, conv, r, arg++);
+    if (written > 0) n += (size_t)written < cap - n ? (size_t)written : cap - n - 1;
+  }
+
+  out[n] = '\0';
+}
+
+static void __log_print(const log_record *r) {
+  char line[LOG_LINE_BYTES];
+  __log_format(r, line, sizeof(line));
+  const char *level = log_level_name(r->level);
+  const char *category = log_category_name((log_category)r->category);
+  if (r->suppressed)
+    SDL_Log("[%s] [%s] (%u more like the next message suppressed)\n", level, category, r->suppressed);
+  SDL_Log("[%s] [%s] %s", level, category, line);
+}
+
+static bool __log_pop_and_print(void) {
+  log_record *r = &lg.ring[lg.dequeue_pos & (LOG_RING_CAPACITY - 1)];
+  size_t seq = atomic_load_explicit(&r->sequence, memory_order_acquire);
+  if (seq != lg.dequeue_pos + 1) return false;
+
+  __log_print(r);
+
+  atomic_store_explicit(&r->sequence, lg.dequeue_pos + LOG_RING_CAPACITY, memory_order_release);
+  ++lg.dequeue_pos;
+  atomic_store_explicit(&lg.dequeued, lg.dequeue_pos, memory_order_release);
+  return true;
+}
+
+static int __log_writer_main(void *data) {
+  (void)data;
+
+  for (;;) {
+    bool printed = false;
+    while (__log_pop_and_print()) printed = true;
+
+    uint32_t dropped = atomic_exchange_explicit(&lg.dropped, 0, memory_order_relaxed);
+    if (dropped) SDL_Log("[WARNING] [core] Log ring full, %u messages dropped.\n", dropped);
+
+    if (printed) continue;
+    if (!atomic_load(&lg.running)) break;
+
+    // Producers only signal when they see this flag, so logging stays free of
+    // syscalls while the writer is busy. The timeout covers the window where
+    // a producer checked the flag just before it was set.
+    atomic_store(&lg.sleeping, 1);
+    if (!__log_pop_and_print()) SDL_WaitSemaphoreTimeout(lg.wake, 50);
+    atomic_store(&lg.sleeping, 0);
+  }
+
+  return 0;
+}
+
+void logger_init(void) {
+  if (lg.ring) return;
+
+  // Nothing goes into the ring until it and the writer are ready.
+  atomic_store(&lg.closed, 1);
+  lg.ring = mem_alloc(sizeof(log_record) * LOG_RING_CAPACITY, MEM_TAG_CORE);
+  if (!check_mem_alloc(lg.ring)) exit(1);
+  for (size_t i = 0; i < LOG_RING_CAPACITY; ++i) atomic_init(&lg.ring[i].sequence, i);
+  atomic_store(&lg.enqueue_pos, 0);
+  lg.dequeue_pos = 0;
+  atomic_store(&lg.dequeued, 0);
+
+  lg.wake = SDL_CreateSemaphore(0);
+  check_sdl_result(lg.wake != NULL, "Failed to create logger semaphore");
+  if (!lg.wake) exit(1);
+
+  atomic_store(&lg.running, 1);
+  lg.thread = SDL_CreateThread(__log_writer_main, "logger", NULL);
+  check_sdl_result(lg.thread != NULL, "Failed to create logger thread");
+  if (!lg.thread) exit(1);
+  atomic_store(&lg.closed, 0);
+
+  if (!lg.atexit_registered) {
+    atexit(logger_shutdown);
+    lg.atexit_registered = true;
+  }
+}
+
+void logger_shutdown(void) {
+  if (!lg.ring || atomic_load(&lg.closed)) return;
+
+  // Threads that were never joined (late job callbacks, I/O workers) may
+  // still log. From here on they print directly; wait out the ones already
+  // writing into the ring before it is drained and freed.
+  atomic_store(&lg.closed, 1);
+  while (atomic_load(&lg.producers) != 0) SDL_CPUPauseInstruction();
+
+  atomic_store(&lg.running, 0);
+  SDL_SignalSemaphore(lg.wake);
+  SDL_WaitThread(lg.thread, NULL);
+  SDL_DestroySemaphore(lg.wake);
+
+  // Anything pushed while the writer was exiting.
+  while (__log_pop_and_print()) {}
+
+  mem_free(lg.ring);
+  lg.ring = NULL;
+  lg.thread = NULL;
+  lg.wake = NULL;
+}
+
+void logger_flush(void) {
+  if (!lg.ring || !atomic_load(&lg.running)) return;
+
+  size_t target = atomic_load(&lg.enqueue_pos);
+  while (atomic_load_explicit(&lg.dequeued, memory_order_acquire) < target) {
+    SDL_SignalSemaphore(lg.wake);
+    SDL_Delay(1);
+  }
+}
+
+// Counts the message against its site's window; true if it is over the limit.
+static bool __log_rate_limited(log_site *site) {
+  if (site->unlimited) return false;
+
+  uint32_t now_ms = (uint32_t)(SDL_GetTicksNS() / SDL_NS_PER_MS);
+  uint32_t window_start = SDL_GetAtomicU32(&site->window_start_ms);
+  if (now_ms - window_start >= LOG_RATE_WINDOW_MS &&
+      SDL_CompareAndSwapAtomicU32(&site->window_start_ms, window_start, now_ms))
+    SDL_SetAtomicInt(&site->window_count, 0);
+
+  if (SDL_AddAtomicInt(&site->window_count, 1) >= LOG_RATE_LIMIT) {
+    SDL_AddAtomicInt(&site->suppressed, 1);
+    return true;
+  }
+  return false;
+}
+
+void __log_push(log_site *site, uint32_t count, const log_arg *args) {
+  if (__log_rate_limited(site)) return;
+  uint32_t suppressed = (uint32_t)SDL_SetAtomicInt(&site->suppressed, 0);
+
+  // Counted in before `closed` is checked, so logger_shutdown either sees
+  // this push or this push sees it closed.
+  atomic_fetch_add(&lg.producers, 1);
+  if (!lg.ring || atomic_load(&lg.closed)) {
+    atomic_fetch_sub_explicit(&lg.producers, 1, memory_order_release);
+    log_record r;
+    __log_fill(&r, site, suppressed, count, args);
+    __log_print(&r);
+    return;
+  }
+
+  size_t pos = atomic_load_explicit(&lg.enqueue_pos, memory_order_relaxed);
+  log_record *r;
+  for (;;) {
+    r = &lg.ring[pos & (LOG_RING_CAPACITY - 1)];
+    size_t seq = atomic_load_explicit(&r->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&lg.enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      atomic_fetch_add_explicit(&lg.dropped, 1, memory_order_relaxed);
+      atomic_fetch_sub_explicit(&lg.producers, 1, memory_order_release);
+      return;
+    } else {
+      pos = atomic_load_explicit(&lg.enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  __log_fill(r, site, suppressed, count, args);
+  atomic_store_explicit(&r->sequence, pos + 1, memory_order_release);
+
+  if (atomic_load(&lg.sleeping) && atomic_exchange(&lg.sleeping, 0))
+    SDL_SignalSemaphore(lg.wake);
+  atomic_fetch_sub_explicit(&lg.producers, 1, memory_order_release);
+}
 
 void check_sdl_result(bool res, const char *msg) {
     if (!res) {
-        SDL_Log("[ERROR] %s: %s\n",
+        LOG_ERROR(LOG_CAT_PLATFORM, "%s: %s\n",
             msg,
             SDL_GetError());
     }
@@ -14,7 +414,7 @@ void check_sdl_result(bool res, const char *msg) {
 
 bool check_mem_alloc(void *ptr) {
     if (ptr == NULL) {
-        SDL_Log("[ERROR] Tried to allocate, but ran out of memory.\n");
+        LOG_ERROR(LOG_CAT_MEMORY, "Tried to allocate, but ran out of memory.\n");
         return false;
     }
     return true;
@@ -26,7 +426,7 @@ bool check_mem_alloc(void *ptr) {
 
 void check_vk_result(VkResult res, const char *msg) {
     if (res != VK_SUCCESS) {
-        SDL_Log("[VK_ERROR] %s: %s (%d)\n",
+        LOG_ERROR(LOG_CAT_VULKAN, "%s: %s (%d)\n",
             msg,
             string_VkResult(res),
         res);
@@ -34,4 +434,4 @@ void check_vk_result(VkResult res, const char *msg) {
     }
 }
 
-#endif // __VK_BACKEND
\ No newline at end of file
+#endif // __VK_BACKEND
@@ -0,0 +1,249 @@
+#include <util/lz.h>
+
+#include <string.h>
+
+// Limits of the LZ4 block format: a match is at least 4 bytes, the last 5
+// bytes of a block are always literals, and the last match starts at least
+// 12 bytes before the end. The decoder relies on none of them, but other
+// decoders do.
+#define LZ_MIN_MATCH 4
+#define LZ_LAST_LITERALS 5
+#define LZ_MFLIMIT 12
+// Block offsets fit 16 bits, so this table is 16 KiB of stack.
+#define LZ_HASH_BITS 13
+// How quickly the compressor starts skipping over input that does not
+// match, trading ratio on incompressible data for speed.
+#define LZ_SKIP_SHIFT 6
+
+static inline uint32_t __lz_read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t __lz_hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline uint8_t *__lz_write_length(uint8_t *op, size_t length) {
+  for (; length >= 255; length -= 255) *op++ = 255;
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+// Worst case bytes a sequence with these lengths takes in the output.
+static inline size_t __lz_sequence_bound(size_t literals, size_t match) {
+  return 1 + literals / 255 + 1 + literals + 2 + match / 255 + 1;
+}
+
+size_t lz_compress_block(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+  if (size > LZ_BLOCK_SIZE) return 0;
+
+  const uint8_t *ip = src;
+  const uint8_t *anchor = src;
+  const uint8_t *iend = src + size;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + capacity;
+
+  if (size > LZ_MFLIMIT) {
+    const uint8_t *mflimit = iend - LZ_MFLIMIT;
+    const uint8_t *matchlimit = iend - LZ_LAST_LITERALS;
+    uint16_t table[1 << LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    ++ip;
+    while (ip <= mflimit) {
+      uint32_t sequence = __lz_read32(ip);
+      uint32_t h = __lz_hash(sequence);
+      const uint8_t *ref = src + table[h];
+      table[h] = (uint16_t)(ip - src);
+      if (__lz_read32(ref) != sequence || ref >= ip) {
+        ip += 1 + ((size_t)(ip - anchor) >> LZ_SKIP_SHIFT);
+        continue;
+      }
+
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+      const uint8_t *end = ip + LZ_MIN_MATCH;
+      const uint8_t *rend = ref + LZ_MIN_MATCH;
+      while (end + 8 <= matchlimit) {
+        uint64_t a, b;
+        memcpy(&a, end, 8);
+        memcpy(&b, rend, 8);
+        if (a != b) break;
+        end += 8;
+        rend += 8;
+      }
+      while (end < matchlimit && *end == *rend) {
+        ++end;
+        ++rend;
+      }
+
+      size_t literals = (size_t)(ip - anchor);
+      size_t match = (size_t)(end - ip) - LZ_MIN_MATCH;
+      if (__lz_sequence_bound(literals, match) > (size_t)(oend - op)) return 0;
+
+      uint8_t *token = op++;
+      *token = (uint8_t)((literals < 15 ? literals : 15) << 4);
+      if (literals >= 15) op = __lz_write_length(op, literals - 15);
+      memcpy(op, anchor, literals);
+      op += literals;
+
+      size_t offset = (size_t)(ip - ref);
+      *op++ = (uint8_t)offset;
+      *op++ = (uint8_t)(offset >> 8);
+      *token |= (uint8_t)(match < 15 ? match : 15);
+      if (match >= 15) op = __lz_write_length(op, match - 15);
+
+      ip = anchor = end;
+      // Seed the table just behind the match, where the next one often is.
+      if (ip <= mflimit) table[__lz_hash(__lz_read32(ip - 2))] = (uint16_t)(ip - 2 - src);
+    }
+  }
+
+  size_t literals = (size_t)(iend - anchor);
+  if (1 + literals / 255 + 1 + literals > (size_t)(oend - op)) return 0;
+  uint8_t *token = op++;
+  *token = (uint8_t)((literals < 15 ? literals : 15) << 4);
+  if (literals >= 15) op = __lz_write_length(op, literals - 15);
+  memcpy(op, anchor, literals);
+  op += literals;
+  return (size_t)(op - dst);
+}
+
+// Adds a length extension to `length`: bytes of 255 continue it.
+static inline bool __lz_read_length(const uint8_t **ip, const uint8_t *iend, size_t *length) {
+  uint8_t b;
+  do {
+    if (*ip >= iend) return false;
+    b = *(*ip)++;
+    *length += b;
+  } while (b == 255);
+  return true;
+}
+
+bool lz_decompress_block(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size) {
+  const uint8_t *ip = src;
+  const uint8_t *iend = src + size;
+  uint8_t *op = dst;
+  uint8_t *oend = dst + raw_size;
+
+  for (;;) {
+    if (ip >= iend) return false;
+    uint8_t token = *ip++;
+
+    size_t literals = token >> 4;
+    if (literals == 15 && !__lz_read_length(&ip, iend, &literals)) return false;
+    if (literals > (size_t)(iend - ip) || literals > (size_t)(oend - op)) return false;
+    // Short runs are the common case; one fixed-size copy beats a memcpy
+    // call while both buffers have the room.
+    if (literals <= 16 && iend - ip >= 16 && oend - op >= 16) memcpy(op, ip, 16);
+    else memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+
+    // The last sequence has literals only.
+    if (ip == iend) return op == oend;
+
+    if (iend - ip < 2) return false;
+    size_t offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - dst)) return false;
+
+    size_t match = token & 15;
+    if (match == 15 && !__lz_read_length(&ip, iend, &match)) return false;
+    match += LZ_MIN_MATCH;
+    if (match > (size_t)(oend - op)) return false;
+
+    const uint8_t *ref = op - offset;
+    if (offset >= 16 && (size_t)(oend - op) >= match + 16) {
+      // Chunks 16 bytes apart never overlap; the tail written past the match
+      // is overwritten by what follows.
+      for (size_t i = 0; i < match; i += 16) memcpy(op + i, ref + i, 16);
+    } else if (offset >= match) {
+      memcpy(op, ref, match);
+    } else {
+      // Overlapping: the match repeats the last `offset` bytes.
+      for (size_t i = 0; i < match; ++i) op[i] = ref[i];
+    }
+    op += match;
+  }
+}
+
+static uint64_t __lz_block_count(uint64_t raw_size) {
+  return (raw_size + LZ_BLOCK_SIZE - 1) / LZ_BLOCK_SIZE;
+}
+
+size_t lz_frame_bound(size_t raw_size) {
+  // Blocks that do not shrink are stored, so no block grows.
+  return sizeof(lz_frame_header) + (size_t)__lz_block_count(raw_size) * sizeof(uint32_t) + raw_size;
+}
+
+size_t lz_compress(const uint8_t *src, size_t size, uint8_t *dst, size_t capacity) {
+  uint64_t block_count = __lz_block_count(size);
+  size_t table_size = (size_t)block_count * sizeof(uint32_t);
+  if (block_count > UINT32_MAX || capacity < sizeof(lz_frame_header) + table_size) return 0;
+
+  lz_frame_header header = { LZ_FRAME_MAGIC, (uint32_t)block_count, size };
+  memcpy(dst, &header, sizeof(header));
+  uint8_t *sizes = dst + sizeof(header);
+  uint8_t *op = sizes + table_size;
+  uint8_t *oend = dst + capacity;
+
+  for (uint64_t i = 0; i < block_count; ++i) {
+    const uint8_t *block = src + i * LZ_BLOCK_SIZE;
+    size_t raw = size - i * LZ_BLOCK_SIZE < LZ_BLOCK_SIZE ? size - i * LZ_BLOCK_SIZE : LZ_BLOCK_SIZE;
+    size_t room = (size_t)(oend - op);
+
+    // Only worth keeping compressed if it comes out smaller.
+    uint32_t stored = (uint32_t)lz_compress_block(block, raw, op, room < raw ? room : raw - 1);
+    if (stored == 0) {
+      if (room < raw) return 0;
+      memcpy(op, block, raw);
+      stored = (uint32_t)raw | LZ_BLOCK_STORED;
+    }
+    memcpy(sizes + i * sizeof(uint32_t), &stored, sizeof(stored));
+    op += stored & ~LZ_BLOCK_STORED;
+  }
+  return (size_t)(op - dst);
+}
+
+bool lz_frame_raw_size(const uint8_t *src, size_t size, uint64_t *raw_size) {
+  lz_frame_header header;
+  if (size < sizeof(header)) return false;
+  memcpy(&header, src, sizeof(header));
+  if (header.magic != LZ_FRAME_MAGIC || header.block_count != __lz_block_count(header.raw_size)) return false;
+  if ((size - sizeof(header)) / sizeof(uint32_t) < header.block_count) return false;
+  *raw_size = header.raw_size;
+  return true;
+}
+
+bool lz_decompress(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size) {
+  uint64_t frame_raw_size;
+  if (!lz_frame_raw_size(src, size, &frame_raw_size) || frame_raw_size != raw_size) return false;
+
+  uint64_t block_count = __lz_block_count(raw_size);
+  const uint8_t *sizes = src + sizeof(lz_frame_header);
+  const uint8_t *ip = sizes + block_count * sizeof(uint32_t);
+  const uint8_t *iend = src + size;
+
+  for (uint64_t i = 0; i < block_count; ++i) {
+    uint32_t stored;
+    memcpy(&stored, sizes + i * sizeof(uint32_t), sizeof(stored));
+    size_t length = stored & ~LZ_BLOCK_STORED;
+    size_t raw = raw_size - i * LZ_BLOCK_SIZE < LZ_BLOCK_SIZE ? raw_size - i * LZ_BLOCK_SIZE : LZ_BLOCK_SIZE;
+    if (length > (size_t)(iend - ip)) return false;
+
+    uint8_t *out = dst + i * LZ_BLOCK_SIZE;
+    if (stored & LZ_BLOCK_STORED) {
+      if (length != raw) return false;
+      memcpy(out, ip, raw);
+    } else if (!lz_decompress_block(ip, length, out, raw)) {
+      return false;
+    }
+    ip += length;
+  }
+  return true;
+}
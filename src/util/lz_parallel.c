@@ -0,0 +1,75 @@
+// Kept apart from lz.c so build tools can link the codec without the job
+// system.
+
+#include <util/lz.h>
+
+#include <core/job.h>
+#include <core/memory.h>
+#include <util/logger.h>
+#include <util/profiler.h>
+
+#include <stdatomic.h>
+#include <string.h>
+
+typedef struct lz_parallel_ctx_t {
+  const uint8_t *src;
+  // Where each block starts in `src`, plus one past the last.
+  uint64_t *offsets;
+  uint8_t *dst;
+  size_t raw_size;
+  atomic_bool failed;
+} lz_parallel_ctx;
+
+static void __lz_decompress_range(void *data, uint32_t begin, uint32_t end) {
+  PROFILE_SCOPE("lz_decompress_range");
+  lz_parallel_ctx *ctx = data;
+  for (uint32_t i = begin; i < end; ++i) {
+    uint64_t first = (uint64_t)i * LZ_BLOCK_SIZE;
+    size_t raw = ctx->raw_size - first < LZ_BLOCK_SIZE ? (size_t)(ctx->raw_size - first) : LZ_BLOCK_SIZE;
+    const uint8_t *block = ctx->src + ctx->offsets[i];
+    size_t length = (size_t)(ctx->offsets[i + 1] - ctx->offsets[i]);
+
+    uint32_t stored;
+    memcpy(&stored, ctx->src + sizeof(lz_frame_header) + (size_t)i * sizeof(uint32_t), sizeof(stored));
+    bool ok;
+    if (stored & LZ_BLOCK_STORED) {
+      ok = length == raw;
+      if (ok) memcpy(ctx->dst + first, block, raw);
+    } else {
+      ok = lz_decompress_block(block, length, ctx->dst + first, raw);
+    }
+    if (!ok) atomic_store_explicit(&ctx->failed, true, memory_order_relaxed);
+  }
+}
+
+bool lz_decompress_parallel(const uint8_t *src, size_t size, uint8_t *dst, size_t raw_size) {
+  uint64_t frame_raw_size;
+  if (!lz_frame_raw_size(src, size, &frame_raw_size) || frame_raw_size != raw_size) return false;
+
+  uint32_t block_count = (uint32_t)((raw_size + LZ_BLOCK_SIZE - 1) / LZ_BLOCK_SIZE);
+  if (block_count < 2 || job_thread_count() < 2) return lz_decompress(src, size, dst, raw_size);
+
+  // Block sizes only tell where a block ends once all before it are
+  // summed, so that one pass is serial; it also bounds every block.
+  uint64_t *offsets = mem_alloc(sizeof(uint64_t) * ((size_t)block_count + 1), MEM_TAG_ASSETS);
+  if (!check_mem_alloc(offsets)) return false;
+  uint64_t offset = sizeof(lz_frame_header) + (uint64_t)block_count * sizeof(uint32_t);
+  for (uint32_t i = 0; i < block_count; ++i) {
+    uint32_t stored;
+    memcpy(&stored, src + sizeof(lz_frame_header) + (size_t)i * sizeof(uint32_t), sizeof(stored));
+    offsets[i] = offset;
+    offset += stored & ~LZ_BLOCK_STORED;
+  }
+  offsets[block_count] = offset;
+  if (offset > size) {
+    mem_free(offsets);
+    return false;
+  }
+
+  lz_parallel_ctx ctx = { src, offsets, dst, raw_size, false };
+  // Blocks cost about the same, and ranges are handed out one at a time off
+  // a shared cursor anyway.
+  job_parallel_for(block_count, 1, __lz_decompress_range, &ctx);
+  mem_free(offsets);
+  return !atomic_load_explicit(&ctx.failed, memory_order_relaxed);
+}
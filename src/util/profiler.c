@@ -0,0 +1,179 @@
+#include <util/profiler.h>
+
+#include <core/memory.h>
+#include <util/logger.h>
+
+#include <SDL3/SDL_atomic.h>
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct profile_event_t {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+} profile_event;
+
+// Written only by its own thread. `written` counts every event ever recorded,
+// so the newest PROFILE_EVENTS_PER_THREAD of them are the live ones; `first`
+// moves forward on profiler_clear.
+typedef struct profile_thread_t {
+  profile_event *events;
+  _Atomic uint64_t written;
+  _Atomic uint64_t first;
+  char name[32];
+} profile_thread;
+
+typedef struct profiler_t {
+  profile_thread threads[PROFILE_MAX_THREADS];
+  _Atomic uint32_t thread_count;
+  SDL_SpinLock lock;
+  bool overflow_reported;
+} profiler;
+
+static profiler prof;
+static _Thread_local profile_thread *tls_thread;
+
+bool __profile_enabled = true;
+
+// NULL once PROFILE_MAX_THREADS threads have registered; their zones are lost.
+static profile_thread *__profile_thread(void) {
+  if (tls_thread) return tls_thread;
+
+  SDL_LockSpinlock(&prof.lock);
+  uint32_t index = atomic_load_explicit(&prof.thread_count, memory_order_relaxed);
+  profile_thread *t = NULL;
+  if (index < PROFILE_MAX_THREADS) {
+    t = &prof.threads[index];
+    t->events = mem_alloc(sizeof(profile_event) * PROFILE_EVENTS_PER_THREAD, MEM_TAG_CORE);
+    if (t->events) {
+      snprintf(t->name, sizeof(t->name), "thread %u", index);
+      atomic_store_explicit(&prof.thread_count, index + 1, memory_order_release);
+    } else {
+      t = NULL;
+    }
+  }
+  bool report = !t && !prof.overflow_reported;
+  prof.overflow_reported |= report;
+  SDL_UnlockSpinlock(&prof.lock);
+
+  if (report) LOG_WARNING(LOG_CAT_CORE, "Profiler has no room for more threads; their zones are dropped.\n");
+  tls_thread = t;
+  return t;
+}
+
+void __profile_record(const char *name, uint64_t start, uint64_t end) {
+  profile_thread *t = __profile_thread();
+  if (!t) return;
+
+  uint64_t n = atomic_load_explicit(&t->written, memory_order_relaxed);
+  t->events[n & (PROFILE_EVENTS_PER_THREAD - 1)] = (profile_event) { name, start, end };
+  atomic_store_explicit(&t->written, n + 1, memory_order_release);
+}
+
+void profiler_set_enabled(bool enabled) {
+  __profile_enabled = enabled;
+}
+
+bool profiler_is_enabled(void) {
+  return __profile_enabled;
+}
+
+void profiler_set_thread_name(const char *name) {
+  profile_thread *t = __profile_thread();
+  if (!t) return;
+  SDL_LockSpinlock(&prof.lock);
+  snprintf(t->name, sizeof(t->name), "%s", name);
+  SDL_UnlockSpinlock(&prof.lock);
+}
+
+void profiler_clear(void) {
+  uint32_t count = atomic_load_explicit(&prof.thread_count, memory_order_acquire);
+  for (uint32_t i = 0; i < count; ++i) {
+    profile_thread *t = &prof.threads[i];
+    atomic_store(&t->first, atomic_load(&t->written));
+  }
+}
+
+static void __profile_write_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') fputc('\\', f);
+    if ((unsigned char)*s >= 0x20) fputc(*s, f);
+  }
+  fputc('"', f);
+}
+
+bool profiler_write_chrome_trace(const char *path) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    LOG_ERROR(LOG_CAT_CORE, "Could not open '%s' for the profiler trace.\n", path);
+    return false;
+  }
+
+  uint32_t count = atomic_load_explicit(&prof.thread_count, memory_order_acquire);
+  const double us_per_tick = 1e6 / (double)SDL_GetPerformanceFrequency();
+
+  // Timestamps are made relative to the oldest buffered zone.
+  uint64_t epoch = UINT64_MAX;
+  for (uint32_t i = 0; i < count; ++i) {
+    profile_thread *t = &prof.threads[i];
+    uint64_t written = atomic_load_explicit(&t->written, memory_order_acquire);
+    uint64_t first = atomic_load(&t->first);
+    uint64_t begin = written > PROFILE_EVENTS_PER_THREAD ? written - PROFILE_EVENTS_PER_THREAD : 0;
+    for (uint64_t n = begin > first ? begin : first; n < written; ++n) {
+      uint64_t start = t->events[n & (PROFILE_EVENTS_PER_THREAD - 1)].start;
+      if (start < epoch) epoch = start;
+    }
+  }
+
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+  bool first_event = true;
+  uint64_t zones = 0;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    profile_thread *t = &prof.threads[i];
+
+    SDL_LockSpinlock(&prof.lock);
+    char name[sizeof(t->name)];
+    memcpy(name, t->name, sizeof(name));
+    SDL_UnlockSpinlock(&prof.lock);
+
+    fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first_event ? "" : ",", i);
+    __profile_write_string(f, name);
+    fputs("}}", f);
+    first_event = false;
+
+    uint64_t written = atomic_load_explicit(&t->written, memory_order_acquire);
+    uint64_t first = atomic_load(&t->first);
+    uint64_t begin = written > PROFILE_EVENTS_PER_THREAD ? written - PROFILE_EVENTS_PER_THREAD : 0;
+
+    for (uint64_t n = begin > first ? begin : first; n < written; ++n) {
+      profile_event ev = t->events[n & (PROFILE_EVENTS_PER_THREAD - 1)];
+
+      // The owning thread keeps recording while we read; skip slots it may
+      // have overwritten in the meantime. Event n + PROFILE_EVENTS_PER_THREAD
+      // is written into slot n before `written` moves past it, so the slot
+      // is already suspect once `written` reaches that event.
+      atomic_thread_fence(memory_order_acquire);
+      if (atomic_load_explicit(&t->written, memory_order_relaxed) - n >= PROFILE_EVENTS_PER_THREAD)
+        continue;
+
+      fputs(",\n{\"name\":", f);
+      __profile_write_string(f, ev.name);
+      fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+              i, (double)(ev.start - epoch) * us_per_tick, (double)(ev.end - ev.start) * us_per_tick);
+      ++zones;
+    }
+  }
+
+  fputs("\n]}\n", f);
+  bool ok = !ferror(f);
+  ok &= fclose(f) == 0;
+
+  if (ok) LOG_INFO(LOG_CAT_CORE, "Wrote %llu profiler zones to '%s'.\n", (unsigned long long)zones, path);
+  else LOG_ERROR(LOG_CAT_CORE, "Failed to write the profiler trace to '%s'.\n", path);
+  return ok;
+}
@@ -0,0 +1,44 @@
+#include <util/timing.h>
+
+#include <util/logger.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+void timing_begin(timing_report *r, const char *title) {
+  memset(r, 0, sizeof(*r));
+  r->title = title;
+  r->start = SDL_GetPerformanceCounter();
+}
+
+void timing_record(timing_report *r, const char *name, uint64_t start) {
+  if (!r) return;
+  uint64_t end = SDL_GetPerformanceCounter();
+  int index = SDL_AddAtomicInt(&r->step_count, 1);
+  if (index >= TIMING_MAX_STEPS) return;
+  r->steps[index] = (timing_step) { name, start, end };
+}
+
+double timing_elapsed_ms(const timing_report *r) {
+  return timing_ticks_to_ms(SDL_GetPerformanceCounter() - r->start);
+}
+
+static int __timing_compare(const void *a, const void *b) {
+  const timing_step *x = a, *y = b;
+  return (x->start > y->start) - (x->start < y->start);
+}
+
+void timing_log(timing_report *r) {
+  uint32_t count = (uint32_t)SDL_GetAtomicInt(&r->step_count);
+  if (count > TIMING_MAX_STEPS) count = TIMING_MAX_STEPS;
+  qsort(r->steps, count, sizeof(timing_step), __timing_compare);
+
+  LOG_INFO(LOG_CAT_CORE, "%s took %.2f ms:\n", r->title, timing_elapsed_ms(r));
+  // Up to TIMING_MAX_STEPS rows in one go, more than the rate limit lets
+  // through.
+  for (uint32_t i = 0; i < count; ++i) {
+    const timing_step *s = &r->steps[i];
+    LOG_INFO_UNLIMITED(LOG_CAT_CORE, "\t+%8.2f ms %8.2f ms  %s\n",
+             timing_ticks_to_ms(s->start - r->start), timing_ticks_to_ms(s->end - s->start), s->name);
+  }
+}
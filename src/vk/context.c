@@ -1,18 +1,26 @@
 #include <SDL3/SDL_video.h>
 #include <vk/context.h>
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
 #include <vulkan/vulkan.h>
 
+#include <core/arena.h>
+#include <core/job.h>
+#include <core/memory.h>
 #include <util/file_io.h>
 #include <util/logger.h>
+#include <util/profiler.h>
+#include <util/timing.h>
 #include <renderer/vertex.h>
+#include <vk/spirv_reflect.h>
 
 #define UNUSED(x) ((void)x)
-#define TODO(msg) { SDL_Log("[TODO] %s\n", msg); exit(1); } 
+#define TODO(msg) { LOG_ERROR(LOG_CAT_VULKAN, "TODO: %s\n", msg); exit(1); } 
 
 void __vk_create_instance(vk_context *ctx);
 void __vk_create_surface(vk_context *ctx);
@@ -22,6 +30,7 @@ void __vk_get_device_queue(vk_context *ctx);
 void __vk_vma_create_allocator(vk_context *ctx);
 void __vk_vma_create_buffer(vk_context *ctx, VkDeviceSize size);
 void __vk_create_pipeline_layout(vk_context *ctx);
+void __vk_create_pipeline_cache(vk_context *ctx);
 void __vk_create_swapchain(vk_context *ctx);
 void __vk_create_image_views(vk_context *ctx);
 void __vk_create_render_pass(vk_context *ctx);
@@ -30,34 +39,72 @@ void __vk_create_command_pool(vk_context *ctx, VkCommandPool *target, uint32_t q
 void __vk_create_graphics_command_buffers(vk_context *ctx);
 void __vk_create_sync_objects(vk_context *ctx);
 
-void vk_context_init(vk_context *ctx, const char *title, int width,
-                     int height) {
-  window_init(&ctx->win, title, width, height);
-  
-  __vk_create_instance(ctx);
-  __vk_create_surface(ctx);
+// Jobs for the parts of vk_context_init that only depend on the device.
+static void __vk_init_instance_job(void *data) {
+  vk_context *ctx = data;
+  TIMING_STEP(ctx->init_timing, "vulkan instance", __vk_create_instance(ctx));
+}
 
-  __vk_pick_physical_device(ctx);
-  __vk_create_logical_device(ctx);
-  __vk_get_device_queue(ctx);
+static void __vk_init_memory_job(void *data) {
+  vk_context *ctx = data;
+  TIMING_STEP(ctx->init_timing, "vma allocator", __vk_vma_create_allocator(ctx));
+  TIMING_STEP(ctx->init_timing, "vertex buffer", __vk_vma_create_buffer(ctx, sizeof(vertex) * MAX_VERTICES));
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    arena_init(&ctx->frame_arenas[i], VK_FRAME_ARENA_SIZE, MEM_TAG_RENDERER);
+}
 
-  __vk_vma_create_allocator(ctx);
+static void __vk_init_commands_job(void *data) {
+  vk_context *ctx = data;
+  TIMING_STEP(ctx->init_timing, "command pool",
+              __vk_create_command_pool(ctx, &ctx->graphics_pool, ctx->graphics_family_idx);
+              __vk_create_graphics_command_buffers(ctx));
+}
 
-  VkDeviceSize buffer_size = sizeof(vertex) * MAX_VERTICES;
-  __vk_vma_create_buffer(ctx, buffer_size);
-  
-  __vk_create_pipeline_layout(ctx);
-  
-  __vk_create_swapchain(ctx);
-  __vk_create_image_views(ctx);
+static void __vk_init_layout_job(void *data) {
+  vk_context *ctx = data;
+  TIMING_STEP(ctx->init_timing, "pipeline layout", __vk_create_pipeline_layout(ctx));
+  TIMING_STEP(ctx->init_timing, "pipeline cache", __vk_create_pipeline_cache(ctx));
+}
 
-  __vk_create_render_pass(ctx);
-  __vk_create_framebuffers(ctx);
+void vk_context_init(vk_context *ctx, const char *title, int width,
+                     int height, timing_report *timing) {
+  PROFILE_FUNCTION();
+  ctx->init_timing = timing;
+
+  // The window has to be created on this thread; the instance does not
+  // depend on it, only on the video subsystem being up.
+  TIMING_STEP(timing, "video init", window_init_video());
+  job_counter instance_done = {0};
+  job_run(&(job_decl) { __vk_init_instance_job, ctx }, 1, &instance_done);
+  TIMING_STEP(timing, "window", window_init(&ctx->win, title, width, height));
+  job_wait(&instance_done);
+
+  TIMING_STEP(timing, "surface", __vk_create_surface(ctx));
+  TIMING_STEP(timing, "physical device", __vk_pick_physical_device(ctx));
+  TIMING_STEP(timing, "logical device",
+              __vk_create_logical_device(ctx);
+              __vk_get_device_queue(ctx));
+
+  vk_pipeline_pool_init(&ctx->pipelines, VK_MAX_PIPELINES, MEM_TAG_RENDERER);
+
+  // Everything below only needs the device. Each job writes its own fields;
+  // the swapchain chain stays on this thread since it queries the window.
+  job_counter device_jobs = {0};
+  job_decl jobs[] = {
+    { __vk_init_memory_job, ctx },
+    { __vk_init_commands_job, ctx },
+    { __vk_init_layout_job, ctx },
+  };
+  job_run(jobs, sizeof(jobs) / sizeof(jobs[0]), &device_jobs);
 
-  __vk_create_command_pool(ctx, &ctx->graphics_pool, ctx->graphics_family_idx);
-  __vk_create_graphics_command_buffers(ctx);
+  TIMING_STEP(timing, "swapchain", __vk_create_swapchain(ctx));
+  TIMING_STEP(timing, "image views", __vk_create_image_views(ctx));
+  TIMING_STEP(timing, "render pass", __vk_create_render_pass(ctx));
+  TIMING_STEP(timing, "framebuffers", __vk_create_framebuffers(ctx));
+  TIMING_STEP(timing, "sync objects", __vk_create_sync_objects(ctx));
 
-  __vk_create_sync_objects(ctx);
+  job_wait(&device_jobs);
+  ctx->init_timing = NULL;
 }
 
 #define VK_LAYER_KHRONOS_VALIDATION_NAME "VK_LAYER_KHRONOS_validation"
@@ -65,8 +112,9 @@ void vk_context_init(vk_context *ctx, const char *title, int width,
 bool __vk_is_khronos_validation_supported() {
   uint32_t instance_layer_count = 0;
   vkEnumerateInstanceLayerProperties(&instance_layer_count, NULL);
-  VkLayerProperties *layer_properties = (VkLayerProperties *)malloc(
-      sizeof(VkLayerProperties) * instance_layer_count);
+  arena_scope scratch = arena_scratch_begin();
+  VkLayerProperties *layer_properties =
+      arena_alloc_array(scratch.owner, VkLayerProperties, instance_layer_count);
   vkEnumerateInstanceLayerProperties(&instance_layer_count, layer_properties);
 
   bool is_khronos_validation_supported = false;
@@ -78,22 +126,23 @@ bool __vk_is_khronos_validation_supported() {
     }
   }
 
-  free(layer_properties);
+  arena_scope_end(scratch);
 
   return is_khronos_validation_supported;
 }
 
 void __vk_create_instance(vk_context *ctx) {
+  PROFILE_FUNCTION();
   const char *layers[] = {VK_LAYER_KHRONOS_VALIDATION_NAME};
 
   uint32_t extension_count = 0;
   const char *const *extensions =
       SDL_Vulkan_GetInstanceExtensions(&extension_count);
 
-  SDL_Log("[INFO] Enumerating instance extensions:\n");
+  LOG_DEBUG(LOG_CAT_VULKAN, "Enumerating instance extensions:\n");
   for (uint32_t i = 0; i < extension_count; ++i) {
     const char *const ext = extensions[i];
-    SDL_Log("\t%s\n", ext);
+    LOG_DEBUG(LOG_CAT_VULKAN, "\t%s\n", ext);
   }
 
   VkApplicationInfo app_info = {
@@ -116,44 +165,44 @@ void __vk_create_instance(vk_context *ctx) {
     vk_create_info.enabledLayerCount = 1;
     vk_create_info.ppEnabledLayerNames = layers;
   } else {
-    SDL_Log("[WARNING] Khronos validation is not supported by your system. "
+    LOG_WARNING(LOG_CAT_VULKAN, "Khronos validation is not supported by your system. "
             "Debug information may be limited or non-existant.\n");
   }
 
   check_vk_result(vkCreateInstance(&vk_create_info, NULL, &ctx->instance),
                   "Failed to create Vulkan instance");
-  SDL_Log("[INFO] Vulkan instance created successfully.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Vulkan instance created successfully.\n");
 }
 
 void __vk_create_surface(vk_context *ctx) {
+  PROFILE_FUNCTION();
   check_sdl_result(SDL_Vulkan_CreateSurface(ctx->win.window, ctx->instance,
                                             NULL, &ctx->surface),
                    "Failed to create VkSurfaceKHR");
-  SDL_Log("[INFO] Window surface created successfully.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Window surface created successfully.\n");
 }
 
 void __vk_pick_physical_device(vk_context *ctx) {
+  PROFILE_FUNCTION();
   uint32_t physical_device_count = 0;
   vkEnumeratePhysicalDevices(ctx->instance, &physical_device_count, NULL);
   if (physical_device_count == 0) {
     // TODO: We need to shutdown the engine on failure rather than just straight `exit(1)`.
     // Just not sure how to pass the engine from.. within the engine.
-    SDL_Log("[ERROR] Failed to find physical GPUs with Vulkan support.\n");
+    LOG_ERROR(LOG_CAT_VULKAN, "Failed to find physical GPUs with Vulkan support.\n");
     exit(1);
   }
 
+  arena_scope scratch = arena_scratch_begin();
   VkPhysicalDevice *physical_devices =
-      (VkPhysicalDevice *)malloc(sizeof(VkPhysicalDevice) * physical_device_count);
-  if (!check_mem_alloc(physical_devices)) {
-    exit(1);
-  }
+      arena_alloc_array(scratch.owner, VkPhysicalDevice, physical_device_count);
   vkEnumeratePhysicalDevices(ctx->instance, &physical_device_count, physical_devices);
 
   ctx->physical_device = VK_NULL_HANDLE;
   for (uint32_t i = 0; i < physical_device_count; ++i) {
     VkPhysicalDeviceProperties pd_properties = {0};
     vkGetPhysicalDeviceProperties(physical_devices[i], &pd_properties);
-    SDL_Log("[INFO] Found GPU Device: %s\n", pd_properties.deviceName);
+    LOG_INFO(LOG_CAT_VULKAN, "Found GPU Device: %s\n", pd_properties.deviceName);
 
     const char *type;
     switch (pd_properties.deviceType) {
@@ -173,8 +222,8 @@ void __vk_pick_physical_device(vk_context *ctx) {
       type = "Other";
       break;
     }
-    SDL_Log("\tType: %s\n", type);
-    SDL_Log("\tAPI Version: %u.%u.%u\n",
+    LOG_INFO(LOG_CAT_VULKAN, "\tType: %s\n", type);
+    LOG_INFO(LOG_CAT_VULKAN, "\tAPI Version: %u.%u.%u\n",
             VK_API_VERSION_MAJOR(pd_properties.apiVersion),
             VK_API_VERSION_MINOR(pd_properties.apiVersion),
             VK_API_VERSION_PATCH(pd_properties.apiVersion));
@@ -182,7 +231,7 @@ void __vk_pick_physical_device(vk_context *ctx) {
     if (pd_properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) {
       ctx->physical_device = physical_devices[i];
 
-      SDL_Log("[INFO] '%s' chosen as target physical device.\n", pd_properties.deviceName);
+      LOG_INFO(LOG_CAT_VULKAN, "'%s' chosen as target physical device.\n", pd_properties.deviceName);
       break;
     }
   }
@@ -190,19 +239,16 @@ void __vk_pick_physical_device(vk_context *ctx) {
   if (ctx->physical_device == VK_NULL_HANDLE) {
     // TODO: Is it really a good idea to just fall back on device 0?
     ctx->physical_device = physical_devices[0];
-    SDL_Log("[WARNING] Discrete GPU not found; falling back to first option.\n");
+    LOG_WARNING(LOG_CAT_VULKAN, "Discrete GPU not found; falling back to first option.\n");
   }
 
-  free(physical_devices);
+  arena_scope_end(scratch);
 }
 
-void __vk_query_queue_families(vk_context *ctx) {
+void __vk_query_queue_families(vk_context *ctx, arena *a) {
   vkGetPhysicalDeviceQueueFamilyProperties(ctx->physical_device, &ctx->queue_family_count, NULL);
-  ctx->queue_family_properties = 
-    (VkQueueFamilyProperties*)malloc(sizeof(VkQueueFamilyProperties) * ctx->queue_family_count);
-  if (!check_mem_alloc(ctx->queue_family_properties)) {
-    exit(1);
-  }
+  ctx->queue_family_properties =
+    arena_alloc_array(a, VkQueueFamilyProperties, ctx->queue_family_count);
   vkGetPhysicalDeviceQueueFamilyProperties(ctx->physical_device, &ctx->queue_family_count, ctx->queue_family_properties);
 }
 
@@ -239,17 +285,21 @@ void __vk_find_queue_families(vk_context *ctx) {
 
   if (ctx->compute_family_idx == (uint32_t)-1) ctx->compute_family_idx = ctx->graphics_family_idx;
   if (ctx->transfer_family_idx == (uint32_t)-1) ctx->transfer_family_idx = ctx->graphics_family_idx;
-  
-  free(ctx->queue_family_properties);
-  SDL_Log("[INFO] Chosen queue families:\n");
-  SDL_Log("\tGraphics: %d\n", ctx->graphics_family_idx);
-  SDL_Log("\tCompute: %d\n", ctx->compute_family_idx);
-  SDL_Log("\tTransfer: %d\n", ctx->transfer_family_idx);
+
+  LOG_INFO(LOG_CAT_VULKAN, "Chosen queue families:\n");
+  LOG_INFO(LOG_CAT_VULKAN, "\tGraphics: %d\n", ctx->graphics_family_idx);
+  LOG_INFO(LOG_CAT_VULKAN, "\tCompute: %d\n", ctx->compute_family_idx);
+  LOG_INFO(LOG_CAT_VULKAN, "\tTransfer: %d\n", ctx->transfer_family_idx);
 }
 
 void __vk_create_logical_device(vk_context *ctx) {
-  __vk_query_queue_families(ctx);
+  PROFILE_FUNCTION();
+  // Queue family properties are only needed to pick the families.
+  arena_scope scratch = arena_scratch_begin();
+  __vk_query_queue_families(ctx, scratch.owner);
   __vk_find_queue_families(ctx);
+  arena_scope_end(scratch);
+  ctx->queue_family_properties = NULL;
 
   // TODO: Don't hardcode "3" as we may add video_decode/encode.
   // Also, we should check for stuff like VK_QUEUE_IGNORED
@@ -301,10 +351,11 @@ void __vk_create_logical_device(vk_context *ctx) {
     "Failed to create logical device"
   );
 
-  SDL_Log("[INFO] Created logical device.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created logical device.\n");
 }
 
 void __vk_get_device_queue(vk_context *ctx) {
+  PROFILE_FUNCTION();
   vkGetDeviceQueue(
     ctx->device, 
     ctx->graphics_family_idx,
@@ -314,6 +365,7 @@ void __vk_get_device_queue(vk_context *ctx) {
 }
 
 void __vk_vma_create_allocator(vk_context *ctx) {
+  PROFILE_FUNCTION();
   /* uint32_t api_version = VK_API_VERSION_1_0; */
   /* PFN_vkEnumerateInstanceVersion pfnEnumerateInstanceVersion =  */
   /*   (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(NULL, "vkEnumerateInstanceVersion"); */
@@ -322,7 +374,7 @@ void __vk_vma_create_allocator(vk_context *ctx) {
   /*   pfnEnumerateInstanceVersion(&api_version); */
   /* } else { */
   /*   // NOTE: Interestingly, as vkEnumerateInstanceVersion was introduced in version 1.1, not being able to load it dynamically MEANS we are on version 1.0. But whatever, I'm printing a warning message anyway. */
-  /*   SDL_Log("[WARNING] Could not load vkEnumerateInstanceVersion - allocator falling back to Vulkan API version 1.0.\n"); */
+  /*   LOG_WARNING(LOG_CAT_VULKAN, "Could not load vkEnumerateInstanceVersion - allocator falling back to Vulkan API version 1.0.\n"); */
   /* } */
 
   // ^ Since we create the instance with API 1.0, we need to just use 1.0 for allocator.
@@ -342,10 +394,11 @@ void __vk_vma_create_allocator(vk_context *ctx) {
 
   check_vk_result(vmaCreateAllocator(&alloc_create_info, &ctx->allocator), "Failed to create VMA allocator");
 
-  SDL_Log("[INFO] Created VMA allocator.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created VMA allocator.\n");
 }
 
 void __vk_vma_create_buffer(vk_context *ctx, VkDeviceSize size) {
+  PROFILE_FUNCTION();
   VkBufferCreateInfo buffer_create_info = {
     .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
     .size = size,
@@ -360,21 +413,234 @@ void __vk_vma_create_buffer(vk_context *ctx, VkDeviceSize size) {
 
   check_vk_result(vmaCreateBuffer(ctx->allocator, &buffer_create_info, &alloc_create_info, &ctx->buffer, &ctx->allocation, NULL), "Failed to create VMA buffer");
 
-  SDL_Log("[INFO] Created VMA buffer.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created VMA buffer.\n");
 }
 
 void __vk_create_pipeline_layout(vk_context *ctx) {
-  VkPipelineLayoutCreateInfo layout_info = {
-    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-    .setLayoutCount = 0,
-    .pSetLayouts = NULL,
-    .pushConstantRangeCount = 0,
-    .pPushConstantRanges = NULL
+  PROFILE_FUNCTION();
+  ctx->layout_lock = SDL_CreateMutex();
+  check_sdl_result(ctx->layout_lock != NULL, "Failed to create the pipeline layout lock");
+  if (!ctx->layout_lock) exit(1);
+
+  static const vk_pipeline_layout_desc empty = {0};
+  ctx->pipeline_layout = vk_pipeline_layout_get(ctx, &empty);
+  if (ctx->pipeline_layout == VK_NULL_HANDLE) exit(1);
+
+  LOG_INFO(LOG_CAT_VULKAN, "Created empty pipeline layout.\n");
+}
+
+// Called with layout_lock held.
+static VkDescriptorSetLayout __vk_set_layout_get(vk_context *ctx, const vk_set_layout_desc *desc) {
+  for (uint32_t i = 0; i < ctx->set_layout_count; ++i) {
+    const vk_set_layout_desc *other = &ctx->set_layouts[i].desc;
+    if (other->binding_count == desc->binding_count &&
+        memcmp(other->bindings, desc->bindings, sizeof(VkDescriptorSetLayoutBinding) * desc->binding_count) == 0)
+      return ctx->set_layouts[i].layout;
+  }
+
+  if (ctx->set_layout_count == VK_MAX_SET_LAYOUTS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Ran out of descriptor set layouts (VK_MAX_SET_LAYOUTS is %d).\n", VK_MAX_SET_LAYOUTS);
+    return VK_NULL_HANDLE;
+  }
+
+  VkDescriptorSetLayoutCreateInfo layout_info = {
+    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+    .bindingCount = desc->binding_count,
+    .pBindings = desc->bindings
   };
 
-  check_vk_result(vkCreatePipelineLayout(ctx->device, &layout_info, NULL, &ctx->pipeline_layout), "Failed to create pipeline layout");
-  
-  SDL_Log("[INFO] Created empty pipeline layout.\n");
+  VkDescriptorSetLayout layout;
+  VkResult res = vkCreateDescriptorSetLayout(ctx->device, &layout_info, NULL, &layout);
+  if (res != VK_SUCCESS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Failed to create descriptor set layout (%d).\n", res);
+    return VK_NULL_HANDLE;
+  }
+
+  vk_set_layout_entry *entry = &ctx->set_layouts[ctx->set_layout_count++];
+  memset(entry, 0, sizeof(*entry));
+  entry->desc.binding_count = desc->binding_count;
+  memcpy(entry->desc.bindings, desc->bindings, sizeof(VkDescriptorSetLayoutBinding) * desc->binding_count);
+  entry->layout = layout;
+  return layout;
+}
+
+static bool __vk_push_constants_equal(const VkPushConstantRange *a, const VkPushConstantRange *b) {
+  if (a->size == 0 || b->size == 0) return a->size == b->size;
+  return a->stageFlags == b->stageFlags && a->offset == b->offset && a->size == b->size;
+}
+
+VkPipelineLayout vk_pipeline_layout_get(vk_context *ctx, const vk_pipeline_layout_desc *desc) {
+  if (desc->set_count > VK_MAX_DESCRIPTOR_SETS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Pipeline layout uses %u descriptor sets, more than VK_MAX_DESCRIPTOR_SETS.\n", desc->set_count);
+    return VK_NULL_HANDLE;
+  }
+
+  SDL_LockMutex(ctx->layout_lock);
+
+  VkDescriptorSetLayout sets[VK_MAX_DESCRIPTOR_SETS] = {0};
+  VkPipelineLayout layout = VK_NULL_HANDLE;
+  bool ok = true;
+  for (uint32_t i = 0; i < desc->set_count && ok; ++i) {
+    sets[i] = __vk_set_layout_get(ctx, &desc->sets[i]);
+    ok = sets[i] != VK_NULL_HANDLE;
+  }
+
+  for (uint32_t i = 0; i < ctx->pipeline_layout_count && ok; ++i) {
+    const vk_pipeline_layout_entry *entry = &ctx->pipeline_layouts[i];
+    if (entry->set_count == desc->set_count &&
+        memcmp(entry->sets, sets, sizeof(VkDescriptorSetLayout) * desc->set_count) == 0 &&
+        __vk_push_constants_equal(&entry->push_constants, &desc->push_constants)) {
+      layout = entry->layout;
+      break;
+    }
+  }
+
+  if (ok && layout == VK_NULL_HANDLE) {
+    if (ctx->pipeline_layout_count == VK_MAX_PIPELINE_LAYOUTS) {
+      LOG_ERROR(LOG_CAT_VULKAN, "Ran out of pipeline layouts (VK_MAX_PIPELINE_LAYOUTS is %d).\n", VK_MAX_PIPELINE_LAYOUTS);
+    } else {
+      VkPipelineLayoutCreateInfo layout_info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = desc->set_count,
+        .pSetLayouts = sets,
+        .pushConstantRangeCount = desc->push_constants.size ? 1 : 0,
+        .pPushConstantRanges = &desc->push_constants
+      };
+
+      VkResult res = vkCreatePipelineLayout(ctx->device, &layout_info, NULL, &layout);
+      if (res == VK_SUCCESS) {
+        vk_pipeline_layout_entry *entry = &ctx->pipeline_layouts[ctx->pipeline_layout_count++];
+        entry->set_count = desc->set_count;
+        memcpy(entry->sets, sets, sizeof(sets));
+        entry->push_constants = desc->push_constants;
+        entry->layout = layout;
+      } else {
+        LOG_ERROR(LOG_CAT_VULKAN, "Failed to create pipeline layout (%d).\n", res);
+        layout = VK_NULL_HANDLE;
+      }
+    }
+  }
+
+  SDL_UnlockMutex(ctx->layout_lock);
+  return layout;
+}
+
+// Merges the resources of every stage into one layout. Stages that share a
+// binding must agree on what it is.
+static VkPipelineLayout __vk_pipeline_layout_from_reflection(vk_context *ctx, const spirv_reflection *stages, uint32_t stage_count) {
+  vk_pipeline_layout_desc desc;
+  memset(&desc, 0, sizeof(desc));
+
+  for (uint32_t s = 0; s < stage_count; ++s) {
+    const spirv_reflection *stage = &stages[s];
+
+    for (uint32_t i = 0; i < stage->binding_count; ++i) {
+      const spirv_binding *b = &stage->bindings[i];
+      if (b->set >= VK_MAX_DESCRIPTOR_SETS) {
+        LOG_ERROR(LOG_CAT_VULKAN, "Shader uses descriptor set %u; VK_MAX_DESCRIPTOR_SETS is %d.\n", b->set, VK_MAX_DESCRIPTOR_SETS);
+        return VK_NULL_HANDLE;
+      }
+      if (b->set >= desc.set_count) desc.set_count = b->set + 1;
+      vk_set_layout_desc *set = &desc.sets[b->set];
+
+      uint32_t at = 0;
+      while (at < set->binding_count && set->bindings[at].binding < b->binding) ++at;
+
+      VkDescriptorSetLayoutBinding *existing = at < set->binding_count ? &set->bindings[at] : NULL;
+      if (existing && existing->binding == b->binding) {
+        if (existing->descriptorType != b->type || existing->descriptorCount != b->count) {
+          LOG_ERROR(LOG_CAT_VULKAN, "Shader stages disagree on set %u, binding %u.\n", b->set, b->binding);
+          return VK_NULL_HANDLE;
+        }
+        existing->stageFlags |= stage->stage;
+        continue;
+      }
+
+      if (set->binding_count == SPIRV_MAX_BINDINGS) {
+        LOG_ERROR(LOG_CAT_VULKAN, "Descriptor set %u has more than %d bindings.\n", b->set, SPIRV_MAX_BINDINGS);
+        return VK_NULL_HANDLE;
+      }
+      memmove(&set->bindings[at + 1], &set->bindings[at], sizeof(VkDescriptorSetLayoutBinding) * (set->binding_count - at));
+      set->bindings[at] = (VkDescriptorSetLayoutBinding) {
+        .binding = b->binding,
+        .descriptorType = b->type,
+        .descriptorCount = b->count,
+        .stageFlags = stage->stage
+      };
+      ++set->binding_count;
+    }
+
+    // One range over the largest block, visible to every stage that has one.
+    if (stage->push_constant_size) {
+      desc.push_constants.stageFlags |= stage->stage;
+      if (stage->push_constant_size > desc.push_constants.size) desc.push_constants.size = stage->push_constant_size;
+    }
+  }
+
+  return vk_pipeline_layout_get(ctx, &desc);
+}
+
+static bool __vk_reflect_stage(vk_shader_code code, VkShaderStageFlagBits stage, spirv_reflection *out) {
+  if (!spirv_reflect(code.code, code.size, out)) return false;
+  if (out->stage != stage) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Shader entry point '%s' is for stage 0x%x, expected 0x%x.\n",
+              out->entry_point, out->stage, stage);
+    return false;
+  }
+  return true;
+}
+
+VkPipelineLayout vk_pipeline_layout_from_code(vk_context *ctx, vk_shader_code vs, vk_shader_code fs) {
+  spirv_reflection stages[2];
+  if (!__vk_reflect_stage(vs, VK_SHADER_STAGE_VERTEX_BIT, &stages[0]) ||
+      !__vk_reflect_stage(fs, VK_SHADER_STAGE_FRAGMENT_BIT, &stages[1]))
+    return VK_NULL_HANDLE;
+  return __vk_pipeline_layout_from_reflection(ctx, stages, 2);
+}
+
+void __vk_create_pipeline_cache(vk_context *ctx) {
+  PROFILE_FUNCTION();
+  file_view data = {0};
+
+  // A missing cache file is normal on first launch, so only read it if it is
+  // there. The driver ignores data from another device or driver version.
+  if (ctx->pipeline_cache_path) {
+    FILE *f = fopen(ctx->pipeline_cache_path, "rb");
+    if (f) {
+      fclose(f);
+      map_file(ctx->pipeline_cache_path, &data, FILE_MAP_SEQUENTIAL | FILE_MAP_WILLNEED);
+    }
+  }
+
+  VkPipelineCacheCreateInfo cache_info = {
+    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+    .initialDataSize = data.size,
+    .pInitialData = data.data
+  };
+
+  check_vk_result(vkCreatePipelineCache(ctx->device, &cache_info, NULL, &ctx->pipeline_cache), "Failed to create pipeline cache");
+  size_t loaded = data.size;
+  unmap_file(&data);
+
+  LOG_INFO(LOG_CAT_VULKAN, "Created pipeline cache (%zu bytes loaded).\n", loaded);
+}
+
+void __vk_save_pipeline_cache(vk_context *ctx) {
+  if (!ctx->pipeline_cache_path || ctx->pipeline_cache == VK_NULL_HANDLE) return;
+
+  size_t size = 0;
+  vkGetPipelineCacheData(ctx->device, ctx->pipeline_cache, &size, NULL);
+  void *data = mem_alloc(size, MEM_TAG_RENDERER);
+  if (!check_mem_alloc(data)) return;
+
+  FILE *f = NULL;
+  if (vkGetPipelineCacheData(ctx->device, ctx->pipeline_cache, &size, data) == VK_SUCCESS)
+    f = fopen(ctx->pipeline_cache_path, "wb");
+  if (f && fwrite(data, 1, size, f) == size && fclose(f) == 0)
+    LOG_INFO(LOG_CAT_VULKAN, "Saved pipeline cache (%zu bytes) to '%s'.\n", size, ctx->pipeline_cache_path);
+  else
+    LOG_WARNING(LOG_CAT_VULKAN, "Could not save the pipeline cache to '%s'.\n", ctx->pipeline_cache_path);
+  mem_free(data);
 }
 
 VkSurfaceFormatKHR __vk_choose_swap_surface_format(VkSurfaceFormatKHR *formats, uint32_t format_count) {
@@ -398,22 +664,20 @@ VkPresentModeKHR __vk_choose_swap_present_mode(VkPresentModeKHR *present_modes,
   return VK_PRESENT_MODE_FIFO_KHR;
 }
 
-swapchain_support_details __vk_query_swapchain_support(VkPhysicalDevice device, VkSurfaceKHR surface) {
+swapchain_support_details __vk_query_swapchain_support(VkPhysicalDevice device, VkSurfaceKHR surface, arena *a) {
   swapchain_support_details support = {0};
 
   vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &support.caps);
   
   vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &support.format_count, NULL);
   if (support.format_count != 0) {
-    support.formats = (VkSurfaceFormatKHR*)malloc(sizeof(VkSurfaceFormatKHR) * support.format_count);
-    check_mem_alloc(support.formats);
+    support.formats = arena_alloc_array(a, VkSurfaceFormatKHR, support.format_count);
     vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &support.format_count, support.formats);
   }
 
   vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &support.present_mode_count, NULL);
   if (support.present_mode_count != 0) {
-    support.present_modes = (VkPresentModeKHR*)malloc(sizeof(VkPresentModeKHR) * support.present_mode_count);
-    check_mem_alloc(support.present_modes);
+    support.present_modes = arena_alloc_array(a, VkPresentModeKHR, support.present_mode_count);
     vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &support.present_mode_count, support.present_modes);
   }
 
@@ -432,7 +696,9 @@ void __vk_get_swapchain_extent(vk_context *ctx) {
 }
 
 void __vk_create_swapchain(vk_context *ctx) {
-  ctx->swapchain_support = __vk_query_swapchain_support(ctx->physical_device, ctx->surface);
+  PROFILE_FUNCTION();
+  arena_scope scratch = arena_scratch_begin();
+  ctx->swapchain_support = __vk_query_swapchain_support(ctx->physical_device, ctx->surface, scratch.owner);
   
   VkSurfaceFormatKHR format = __vk_choose_swap_surface_format(ctx->swapchain_support.formats, ctx->swapchain_support.format_count);
   VkPresentModeKHR present_mode = __vk_choose_swap_present_mode(ctx->swapchain_support.present_modes, ctx->swapchain_support.present_mode_count);
@@ -469,21 +735,23 @@ void __vk_create_swapchain(vk_context *ctx) {
   ctx->swapchain_format = format.format;
 
   vkGetSwapchainImagesKHR(ctx->device, ctx->swapchain, &ctx->image_count, NULL);
-  ctx->swapchain_images = (VkImage*)malloc(sizeof(VkImage) * ctx->image_count);
+  ctx->swapchain_images = (VkImage*)mem_alloc(sizeof(VkImage) * ctx->image_count, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->swapchain_images);
   vkGetSwapchainImagesKHR(ctx->device, ctx->swapchain, &ctx->image_count, ctx->swapchain_images);
 
-  free(ctx->swapchain_support.formats);
-  free(ctx->swapchain_support.present_modes);
+  arena_scope_end(scratch);
+  ctx->swapchain_support.formats = NULL;
+  ctx->swapchain_support.present_modes = NULL;
 
-  SDL_Log("[INFO] Created swapchain.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created swapchain.\n");
 }
 
 void __vk_create_image_views(vk_context *ctx) {
-  ctx->swapchain_image_views = (VkImageView*)malloc(sizeof(VkImageView) * ctx->image_count);
+  PROFILE_FUNCTION();
+  ctx->swapchain_image_views = (VkImageView*)mem_alloc(sizeof(VkImageView) * ctx->image_count, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->swapchain_image_views);
 
-  SDL_Log("[INFO] Creating image views:\n");
+  LOG_DEBUG(LOG_CAT_VULKAN, "Creating image views:\n");
 
   for (uint32_t i = 0; i < ctx->image_count; ++i) {
     VkImageViewCreateInfo view_create_info = {
@@ -510,11 +778,12 @@ void __vk_create_image_views(vk_context *ctx) {
       vkCreateImageView(ctx->device, &view_create_info, NULL, &ctx->swapchain_image_views[i]),
       "Failed to create image view."
     );
-    SDL_Log("\tImage View %u created.\n", i);
+    LOG_DEBUG(LOG_CAT_VULKAN, "\tImage View %u created.\n", i);
   }
 }
 
 void __vk_create_render_pass(vk_context *ctx) {
+  PROFILE_FUNCTION();
   VkAttachmentDescription color_attachment = {
     .format = ctx->swapchain_format,
     .samples = VK_SAMPLE_COUNT_1_BIT,
@@ -561,14 +830,15 @@ void __vk_create_render_pass(vk_context *ctx) {
     "Failed to create render pass"
   );
 
-  SDL_Log("[INFO] Created render pass.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created render pass.\n");
 }
 
 void __vk_create_framebuffers(vk_context *ctx) {
-  ctx->framebuffers = (VkFramebuffer*)malloc(sizeof(VkFramebuffer) * ctx->image_count);
+  PROFILE_FUNCTION();
+  ctx->framebuffers = (VkFramebuffer*)mem_alloc(sizeof(VkFramebuffer) * ctx->image_count, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->framebuffers);
 
-  SDL_Log("[INFO] Creating framebuffers:\n");
+  LOG_DEBUG(LOG_CAT_VULKAN, "Creating framebuffers:\n");
 
   for (uint32_t i = 0; i < ctx->image_count; ++i) {
     VkImageView attachments[] = {
@@ -590,11 +860,12 @@ void __vk_create_framebuffers(vk_context *ctx) {
       "Failed to create framebuffer."
     );
 
-    SDL_Log("\tFramebuffer %u created.\n", i);
+    LOG_DEBUG(LOG_CAT_VULKAN, "\tFramebuffer %u created.\n", i);
   }
 }
 
 void __vk_create_command_pool(vk_context *ctx, VkCommandPool *target, uint32_t queue_idx) {
+  PROFILE_FUNCTION();
   VkCommandPoolCreateInfo pool_create_info = {
     .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
     .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
@@ -606,11 +877,12 @@ void __vk_create_command_pool(vk_context *ctx, VkCommandPool *target, uint32_t q
     "Failed to create command pool"
   );
 
-  SDL_Log("[INFO] Created command pool for queue family %u\n", queue_idx);
+  LOG_INFO(LOG_CAT_VULKAN, "Created command pool for queue family %u\n", queue_idx);
 }
 
 void __vk_create_graphics_command_buffers(vk_context *ctx) {
-  ctx->command_buffers = (VkCommandBuffer*)malloc(sizeof(VkCommandBuffer) * MAX_FRAMES_IN_FLIGHT);
+  PROFILE_FUNCTION();
+  ctx->command_buffers = (VkCommandBuffer*)mem_alloc(sizeof(VkCommandBuffer) * MAX_FRAMES_IN_FLIGHT, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->command_buffers);
 
   VkCommandBufferAllocateInfo buffer_allocate_info = {
@@ -625,17 +897,18 @@ void __vk_create_graphics_command_buffers(vk_context *ctx) {
     "Failed to allocate command buffers"
   );
 
-  SDL_Log("[INFO] Allocated graphics command buffers (%u).\n", MAX_FRAMES_IN_FLIGHT);
+  LOG_INFO(LOG_CAT_VULKAN, "Allocated graphics command buffers (%u).\n", MAX_FRAMES_IN_FLIGHT);
 }
 
 void __vk_create_sync_objects(vk_context *ctx) {
-  ctx->image_available_semaphores = (VkSemaphore*)malloc(sizeof(VkSemaphore) * ctx->image_count);
+  PROFILE_FUNCTION();
+  ctx->image_available_semaphores = (VkSemaphore*)mem_alloc(sizeof(VkSemaphore) * ctx->image_count, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->image_available_semaphores);
   
-ctx->render_finished_semaphores = (VkSemaphore*)malloc(sizeof(VkSemaphore) * ctx->image_count);
+ctx->render_finished_semaphores = (VkSemaphore*)mem_alloc(sizeof(VkSemaphore) * ctx->image_count, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->render_finished_semaphores);
 
-  ctx->in_flight_fences = (VkFence*)malloc(sizeof(VkFence) * MAX_FRAMES_IN_FLIGHT);
+  ctx->in_flight_fences = (VkFence*)mem_alloc(sizeof(VkFence) * MAX_FRAMES_IN_FLIGHT, MEM_TAG_RENDERER);
   check_mem_alloc(ctx->in_flight_fences);
   
   VkSemaphoreCreateInfo semaphore_create_info = {
@@ -664,10 +937,18 @@ ctx->render_finished_semaphores = (VkSemaphore*)malloc(sizeof(VkSemaphore) * ctx
 		    );
   }
 
-  SDL_Log("[INFO] Created synchonization objects.\n");
+  LOG_INFO(LOG_CAT_VULKAN, "Created synchonization objects.\n");
 }
 
+
+// VK_NULL_HANDLE on failure, so a broken shader in a requested pipeline or a
+// hot reload does not take the process down.
 VkShaderModule __vk_create_shader_module(vk_context *ctx, const uint32_t *code, size_t size) {
+  if (size < 20 || size % 4 != 0 || code[0] != SPIRV_MAGIC) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Shader code is not SPIR-V (%zu bytes).\n", size);
+    return VK_NULL_HANDLE;
+  }
+
   VkShaderModuleCreateInfo module_create_info = {
     .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
     .codeSize = size,
@@ -675,26 +956,27 @@ VkShaderModule __vk_create_shader_module(vk_context *ctx, const uint32_t *code,
   };
 
   VkShaderModule module;
-  check_vk_result(vkCreateShaderModule(ctx->device, &module_create_info, NULL, &module), "Could not create shader module");
+  VkResult res = vkCreateShaderModule(ctx->device, &module_create_info, NULL, &module);
+  if (res != VK_SUCCESS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Could not create shader module (%d).\n", res);
+    return VK_NULL_HANDLE;
+  }
 
   return module;
 }
 
-VkShaderModule __vk_load_shader(vk_context *ctx, const char *path) {
-  size_t size;
-  uint8_t *file_contents = read_entire_file(path, &size);
-
-  if (file_contents == NULL) {
-    SDL_Log("[ERROR] Tried to open shader file '%s', but failed.\n", path);
+// The code is read straight out of the mapping; unmap it once the pipeline
+// is built.
+file_view __vk_map_shader(const char *path) {
+  PROFILE_FUNCTION();
+  file_view view;
+  if (!map_file(path, &view, FILE_MAP_SEQUENTIAL | FILE_MAP_WILLNEED)) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Tried to open shader file '%s', but failed.\n", path);
     exit(1);
   }
 
-  VkShaderModule module = __vk_create_shader_module(ctx, (const uint32_t*)file_contents, size);
-
-  free(file_contents);
-  SDL_Log("[INFO] Loaded shader '%s' successfully.\n", path);
-
-  return module;
+  LOG_INFO(LOG_CAT_VULKAN, "Loaded shader '%s' successfully.\n", path);
+  return view;
 }
 
 vk_pipeline_config vk_default_pipeline_config() {
@@ -722,36 +1004,123 @@ vk_pipeline_config vk_default_pipeline_config() {
     VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
   cfg.color_blend_attachment.blendEnable = VK_FALSE;
 
+  cfg.vertex_layout = vertex_get_layout(VERTEX_FORMAT_F32);
+
   cfg.layout = VK_FALSE;
   cfg.render_pass = VK_FALSE;
   
   return cfg;
 }
 
-VkPipeline vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *fs_path, vk_pipeline_config *config) {
+VkFormat __vk_vertex_attr_format(vertex_attr_format format) {
+  switch (format) {
+  case VERTEX_ATTR_FLOAT2: return VK_FORMAT_R32G32_SFLOAT;
+  case VERTEX_ATTR_FLOAT3: return VK_FORMAT_R32G32B32_SFLOAT;
+  case VERTEX_ATTR_HALF4: return VK_FORMAT_R16G16B16A16_SFLOAT;
+  case VERTEX_ATTR_SNORM16X4: return VK_FORMAT_R16G16B16A16_SNORM;
+  case VERTEX_ATTR_UNORM16X2: return VK_FORMAT_R16G16_UNORM;
+  case VERTEX_ATTR_UNORM8X4: return VK_FORMAT_R8G8B8A8_UNORM;
+  }
+
+  LOG_ERROR(LOG_CAT_VULKAN, "Unknown vertex attribute format %d.\n", format);
+  exit(1);
+}
+
+vk_pipeline_handle vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *fs_path, vk_pipeline_config *config) {
+  PROFILE_FUNCTION();
+  file_view vs = __vk_map_shader(vs_path);
+  file_view fs = __vk_map_shader(fs_path);
+
+  vk_pipeline_handle handle = vk_pipeline_build_from_code(
+      ctx,
+      (vk_shader_code) { (const uint32_t*)vs.data, vs.size },
+      (vk_shader_code) { (const uint32_t*)fs.data, fs.size },
+      config);
+  unmap_file(&vs);
+  unmap_file(&fs);
+  return handle;
+}
+
+void __vk_pipeline_check_config(const vk_pipeline_config *config) {
   if (config == NULL) {
-    SDL_Log("[ERROR] Null pointer was passed to vk_pipeline_build. This will segfault.\n");
+    LOG_ERROR(LOG_CAT_VULKAN, "Null pointer was passed to vk_pipeline_build. This will segfault.\n");
     exit(1);
-  } else if (config->layout == VK_NULL_HANDLE || config->render_pass == VK_NULL_HANDLE) {
-    SDL_Log("[ERROR] Pipeline config has either layout or render_pass unset.\n");
+  } else if (config->render_pass == VK_NULL_HANDLE) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Pipeline config has render_pass unset.\n");
     exit(1);
   }
-  
-  VkShaderModule vs = __vk_load_shader(ctx, vs_path);
-  VkShaderModule fs = __vk_load_shader(ctx, fs_path);
+}
+
+// Binds the vertex shader's inputs: from `layout` when there is one,
+// otherwise tightly packed in location order. Returns the vertex stride, or
+// false when `layout` lacks an input the shader reads.
+static bool __vk_vertex_input(const spirv_reflection *vs, const vertex_layout *layout,
+                              VkVertexInputAttributeDescription *attrs, uint32_t *stride) {
+  *stride = 0;
+  for (uint32_t i = 0; i < vs->input_count; ++i) {
+    const spirv_input *input = &vs->inputs[i];
+    attrs[i] = (VkVertexInputAttributeDescription) { .location = input->location, .binding = 0 };
+
+    if (layout == NULL) {
+      attrs[i].format = input->format;
+      attrs[i].offset = *stride;
+      *stride += input->size;
+      continue;
+    }
+
+    const vertex_attr *attr = NULL;
+    for (uint32_t a = 0; a < layout->attribute_count && !attr; ++a)
+      if (layout->attributes[a].location == input->location) attr = &layout->attributes[a];
+    if (!attr) {
+      LOG_ERROR(LOG_CAT_VULKAN, "Vertex shader reads location %u, which the vertex layout does not have.\n", input->location);
+      return false;
+    }
+    attrs[i].format = __vk_vertex_attr_format(attr->format);
+    attrs[i].offset = attr->offset;
+  }
+
+  if (layout) *stride = layout->stride;
+  return true;
+}
+
+VkPipeline vk_pipeline_compile(vk_context *ctx, vk_shader_code vs_code, vk_shader_code fs_code, const vk_pipeline_config *config) {
+  PROFILE_FUNCTION();
+  spirv_reflection reflection[2];
+  if (!__vk_reflect_stage(vs_code, VK_SHADER_STAGE_VERTEX_BIT, &reflection[0]) ||
+      !__vk_reflect_stage(fs_code, VK_SHADER_STAGE_FRAGMENT_BIT, &reflection[1]))
+    return VK_NULL_HANDLE;
+
+  VkPipelineLayout pipeline_layout = config->layout;
+  if (pipeline_layout == VK_NULL_HANDLE) {
+    pipeline_layout = __vk_pipeline_layout_from_reflection(ctx, reflection, 2);
+    if (pipeline_layout == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+  }
+
+  VkVertexInputAttributeDescription vertex_attr_descs[SPIRV_MAX_INPUTS];
+  uint32_t vertex_stride;
+  if (!__vk_vertex_input(&reflection[0], config->vertex_layout, vertex_attr_descs, &vertex_stride))
+    return VK_NULL_HANDLE;
+
+  VkShaderModule vs = __vk_create_shader_module(ctx, vs_code.code, vs_code.size);
+  VkShaderModule fs = __vk_create_shader_module(ctx, fs_code.code, fs_code.size);
+  if (vs == VK_NULL_HANDLE || fs == VK_NULL_HANDLE) {
+    vkDestroyShaderModule(ctx->device, vs, NULL);
+    vkDestroyShaderModule(ctx->device, fs, NULL);
+    return VK_NULL_HANDLE;
+  }
 
   VkPipelineShaderStageCreateInfo stages[2] = {
     {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
       .stage = VK_SHADER_STAGE_VERTEX_BIT,
       .module = vs,
-      .pName = "MainVS"
+      .pName = reflection[0].entry_point
     },
     {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
       .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
       .module = fs,
-      .pName = "MainFS"      
+      .pName = reflection[1].entry_point
     }
   };
 
@@ -781,36 +1150,15 @@ VkPipeline vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *f
 
   VkVertexInputBindingDescription vertex_binding_desc = {
     .binding = 0,
-    .stride = sizeof(vertex),
+    .stride = vertex_stride,
     .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
   };
 
-  VkVertexInputAttributeDescription vertex_attr_descs[3] = {
-    {
-      .location = 0,
-      .binding = 0,
-      .format = VK_FORMAT_R32G32B32_SFLOAT,
-      .offset = offsetof(vertex, pos)
-    },
-    {
-      .location = 1,
-      .binding = 0,
-      .format = VK_FORMAT_R32G32B32_SFLOAT,
-      .offset = offsetof(vertex, color)
-    },
-    {
-      .location = 2,
-      .binding = 0,
-      .format = VK_FORMAT_R32G32_SFLOAT,
-      .offset = offsetof(vertex, uv)
-    }
-  };
-
   VkPipelineVertexInputStateCreateInfo vertex_input_create_info = {
     .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-    .vertexBindingDescriptionCount = 1,
+    .vertexBindingDescriptionCount = reflection[0].input_count ? 1 : 0,
     .pVertexBindingDescriptions = &vertex_binding_desc,
-    .vertexAttributeDescriptionCount = 3,
+    .vertexAttributeDescriptionCount = reflection[0].input_count,
     .pVertexAttributeDescriptions = vertex_attr_descs
   };
   
@@ -825,22 +1173,265 @@ VkPipeline vk_pipeline_build(vk_context *ctx, const char *vs_path, const char *f
     .pMultisampleState = &config->multisampling,
     .pColorBlendState = &color_blending,
     .pDynamicState = &dynamic_state_info,
-    .layout = config->layout,
+    .layout = pipeline_layout,
     .renderPass = config->render_pass,
     .subpass = 0,
   };
 
-  VkPipeline pipeline;
-  check_vk_result(vkCreateGraphicsPipelines(ctx->device, VK_NULL_HANDLE, 1, &pipeline_info, NULL, &pipeline), "Failed to create graphics pipeline");
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  VkResult res = vkCreateGraphicsPipelines(ctx->device, ctx->pipeline_cache, 1, &pipeline_info, NULL, &pipeline);
+  if (res != VK_SUCCESS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Failed to create graphics pipeline (%d).\n", res);
+    pipeline = VK_NULL_HANDLE;
+  }
   
   vkDestroyShaderModule(ctx->device, vs, NULL);
   vkDestroyShaderModule(ctx->device, fs, NULL);  
+
+  return pipeline;
+}
+
+// Pipelines the engine cannot run without, built synchronously at startup:
+// failure is fatal. Requested pipelines fall back instead; see
+// __vk_pipeline_compile_job.
+static VkPipeline __vk_pipeline_create(vk_context *ctx, vk_shader_code vs_code, vk_shader_code fs_code, const vk_pipeline_config *config) {
+  VkPipeline pipeline = vk_pipeline_compile(ctx, vs_code, fs_code, config);
+  if (pipeline == VK_NULL_HANDLE) exit(1);
   return pipeline;
 }
 
+vk_pipeline_handle vk_pipeline_build_from_code(vk_context *ctx, vk_shader_code vs_code, vk_shader_code fs_code, vk_pipeline_config *config) {
+  PROFILE_FUNCTION();
+  __vk_pipeline_check_config(config);
+
+  vk_pipeline_slot slot = { .pipeline = __vk_pipeline_create(ctx, vs_code, fs_code, config) };
+  SDL_SetAtomicInt(&slot.ready, 1);
+
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  vk_pipeline_handle handle = vk_pipeline_pool_add(&ctx->pipelines, &slot);
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+  if (handle.id == POOL_NULL_HANDLE) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Could not store pipeline, VK_MAX_PIPELINES (%d) reached.\n", VK_MAX_PIPELINES);
+    vkDestroyPipeline(ctx->device, slot.pipeline, NULL);
+  }
+  return handle;
+}
+
+// Owns copies of everything the compile needs; the SPIR-V follows the struct
+// in the same allocation.
+typedef struct vk_pipeline_job_t {
+  vk_context *ctx;
+  vk_pipeline_slot *slot;
+  vk_pipeline_config config;
+  vk_shader_code vs;
+  vk_shader_code fs;
+} vk_pipeline_job;
+
+static void __vk_pipeline_compile_job(void *data) {
+  vk_pipeline_job *req = data;
+  uint64_t start = SDL_GetPerformanceCounter();
+
+  VkPipeline pipeline = vk_pipeline_compile(req->ctx, req->vs, req->fs, &req->config);
+  if (pipeline == VK_NULL_HANDLE) {
+    // vk_pipeline_compile logged why. Draws keep using the default pipeline.
+    LOG_ERROR(LOG_CAT_VULKAN, "Requested pipeline failed to compile; drawing it with the default pipeline.\n");
+    SDL_SetAtomicInt(&req->slot->failed, 1);
+    mem_free(req);
+    return;
+  }
+
+  req->slot->pipeline = pipeline;
+  // Publishes `pipeline` to whoever sees `ready` set.
+  SDL_SetAtomicInt(&req->slot->ready, 1);
+
+  LOG_DEBUG(LOG_CAT_VULKAN, "Pipeline compiled in %.2f ms.\n", timing_ticks_to_ms(SDL_GetPerformanceCounter() - start));
+  mem_free(req);
+}
+
+vk_pipeline_handle vk_pipeline_request(vk_context *ctx, vk_shader_code vs, vk_shader_code fs, const vk_pipeline_config *config) {
+  PROFILE_FUNCTION();
+  __vk_pipeline_check_config(config);
+
+  // The render thread may be removing destroyed pipelines from the pool.
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  vk_pipeline_handle handle = vk_pipeline_pool_add(&ctx->pipelines, NULL);
+  vk_pipeline_slot *slot = vk_pipeline_pool_get(&ctx->pipelines, handle);
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+  if (handle.id == POOL_NULL_HANDLE) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Could not store pipeline, VK_MAX_PIPELINES (%d) reached.\n", VK_MAX_PIPELINES);
+    return handle;
+  }
+
+  vk_pipeline_job *req = mem_alloc(sizeof(vk_pipeline_job) + vs.size + fs.size, MEM_TAG_RENDERER);
+  if (!check_mem_alloc(req)) exit(1);
+
+  uint8_t *code = (uint8_t*)(req + 1);
+  memcpy(code, vs.code, vs.size);
+  memcpy(code + vs.size, fs.code, fs.size);
+
+  *req = (vk_pipeline_job) {
+    .ctx = ctx,
+    // Pool storage never moves, and the slot outlives the job since a
+    // destroy is held back until its compile has finished.
+    .slot = slot,
+    .config = *config,
+    .vs = { (const uint32_t*)code, vs.size },
+    .fs = { (const uint32_t*)(code + vs.size), fs.size },
+  };
+
+  job_run(&(job_decl) { __vk_pipeline_compile_job, req }, 1, &ctx->pipeline_jobs);
+  return handle;
+}
+
+bool vk_pipeline_ready(vk_context *ctx, vk_pipeline_handle pipeline) {
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  vk_pipeline_slot *slot = vk_pipeline_pool_get(&ctx->pipelines, pipeline);
+  bool ready = slot && SDL_GetAtomicInt(&slot->ready);
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+  return ready;
+}
+
+void vk_pipeline_set_default(vk_context *ctx, vk_pipeline_handle pipeline) {
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  ctx->default_pipeline = pipeline;
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+}
+
+// Render thread only: it is the one removing pipelines, so slots it finds
+// stay valid until it returns.
+VkPipeline vk_pipeline_resolve(vk_context *ctx, vk_pipeline_handle pipeline) {
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  vk_pipeline_handle fallback = ctx->default_pipeline;
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+
+  vk_pipeline_slot *slot = vk_pipeline_pool_get(&ctx->pipelines, pipeline);
+  if (slot && SDL_GetAtomicInt(&slot->ready)) return slot->pipeline;
+
+  slot = vk_pipeline_pool_get(&ctx->pipelines, fallback);
+  if (slot && SDL_GetAtomicInt(&slot->ready)) return slot->pipeline;
+
+  return VK_NULL_HANDLE;
+}
+
+void vk_pipeline_replace(vk_context *ctx, vk_pipeline_handle handle, VkPipeline replacement) {
+  VkPipeline unused = VK_NULL_HANDLE;
+
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  uint32_t i = 0;
+  while (i < ctx->swap_count && ctx->swaps[i].handle.id != handle.id) ++i;
+  if (i < ctx->swap_count) {
+    unused = ctx->swaps[i].pipeline;
+    ctx->swaps[i].pipeline = replacement;
+  } else if (ctx->swap_count < VK_MAX_PIPELINE_SWAPS) {
+    ctx->swaps[ctx->swap_count++] = (vk_pipeline_swap) { handle, replacement };
+  } else {
+    unused = replacement;
+  }
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+
+  // Never bound by any frame, so it can go right away.
+  if (unused == replacement) LOG_WARNING(LOG_CAT_VULKAN, "Too many pending pipeline swaps; dropping one.\n");
+  if (unused != VK_NULL_HANDLE) vkDestroyPipeline(ctx->device, unused, NULL);
+}
+
+// Runs at the start of a frame, after its fence wait: nothing is being
+// recorded, and frames older than MAX_FRAMES_IN_FLIGHT are known to be done.
+void __vk_apply_pipeline_changes(vk_context *ctx) {
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < ctx->retired_count; ++i) {
+    if (ctx->frame_index >= ctx->retired[i].destroy_at_frame)
+      vkDestroyPipeline(ctx->device, ctx->retired[i].pipeline, NULL);
+    else
+      ctx->retired[kept++] = ctx->retired[i];
+  }
+  ctx->retired_count = kept;
+
+  // Destroys go first so that swaps still queued for those handles find
+  // their slot gone and drop the replacement.
+  kept = 0;
+  for (uint32_t i = 0; i < ctx->destroy_count; ++i) {
+    vk_pipeline_handle handle = ctx->destroys[i];
+    vk_pipeline_slot *slot = vk_pipeline_pool_get(&ctx->pipelines, handle);
+    if (!slot) continue;
+
+    bool compiling = !SDL_GetAtomicInt(&slot->ready) && !SDL_GetAtomicInt(&slot->failed);
+    if (compiling || (slot->pipeline != VK_NULL_HANDLE && ctx->retired_count == VK_MAX_RETIRED_PIPELINES)) {
+      // The compile job still writes into the slot, or nowhere to park the
+      // pipeline yet: next frame.
+      ctx->destroys[kept++] = handle;
+      continue;
+    }
+
+    if (slot->pipeline != VK_NULL_HANDLE) {
+      ctx->retired[ctx->retired_count++] = (vk_retired_pipeline) {
+        slot->pipeline, ctx->frame_index + MAX_FRAMES_IN_FLIGHT
+      };
+    }
+    vk_pipeline_pool_remove(&ctx->pipelines, handle);
+    if (ctx->default_pipeline.id == handle.id) ctx->default_pipeline = (vk_pipeline_handle) {0};
+  }
+  ctx->destroy_count = kept;
+
+  uint32_t pending = 0;
+  for (uint32_t i = 0; i < ctx->swap_count; ++i) {
+    vk_pipeline_swap swap = ctx->swaps[i];
+    vk_pipeline_slot *slot = vk_pipeline_pool_get(&ctx->pipelines, swap.handle);
+
+    if (!slot) {
+      vkDestroyPipeline(ctx->device, swap.pipeline, NULL);
+    } else if (SDL_GetAtomicInt(&slot->failed)) {
+      // Its compile failed, so there is no old pipeline to retire; the
+      // replacement (say, a fixed shader from hot reload) just takes over.
+      slot->pipeline = swap.pipeline;
+      SDL_SetAtomicInt(&slot->failed, 0);
+      SDL_SetAtomicInt(&slot->ready, 1);
+    } else if (!SDL_GetAtomicInt(&slot->ready) || ctx->retired_count == VK_MAX_RETIRED_PIPELINES) {
+      // Still compiling, or nowhere to park the old one yet: next frame.
+      ctx->swaps[pending++] = swap;
+    } else {
+      ctx->retired[ctx->retired_count++] = (vk_retired_pipeline) {
+        slot->pipeline, ctx->frame_index + MAX_FRAMES_IN_FLIGHT
+      };
+      slot->pipeline = swap.pipeline;
+    }
+  }
+  ctx->swap_count = pending;
+
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+}
+
+// Only queues the handle: removing it from the pool has to wait until no
+// frame is being recorded, so the render thread does it in
+// __vk_apply_pipeline_changes.
+void vk_pipeline_destroy(vk_context *ctx, vk_pipeline_handle pipeline) {
+  bool queued = false;
+
+  SDL_LockSpinlock(&ctx->pipeline_lock);
+  uint32_t i = 0;
+  while (i < ctx->destroy_count && ctx->destroys[i].id != pipeline.id) ++i;
+  // A live handle takes one pool slot, so there is always room for it.
+  if (i == ctx->destroy_count && ctx->destroy_count < VK_MAX_PIPELINES &&
+      vk_pipeline_pool_get(&ctx->pipelines, pipeline)) {
+    ctx->destroys[ctx->destroy_count++] = pipeline;
+    queued = true;
+  }
+  SDL_UnlockSpinlock(&ctx->pipeline_lock);
+
+  if (!queued) LOG_WARNING(LOG_CAT_VULKAN, "Attempted to destroy a pipeline that no longer exists.\n");
+}
+
 void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
+  PROFILE_FUNCTION();
+
+  PROFILE_BEGIN(fence_wait, "fence_wait");
   vkWaitForFences(ctx->device, 1, &ctx->in_flight_fences[ctx->current_frame], VK_TRUE, UINT64_MAX);
+  PROFILE_END(fence_wait);
+  arena_reset(vk_frame_arena(ctx));
+  __vk_apply_pipeline_changes(ctx);
 
+  PROFILE_BEGIN(acquire, "acquire_image");
   uint32_t img_idx;
   VkResult res = vkAcquireNextImageKHR(
     ctx->device,
@@ -850,14 +1441,16 @@ void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
     VK_NULL_HANDLE,
     &img_idx
   );
+  PROFILE_END(acquire);
 
   if (res == VK_ERROR_OUT_OF_DATE_KHR) {
-    SDL_Log("[UNHANDLED] Resize event.\n");
+    LOG_ERROR(LOG_CAT_VULKAN, "Unhandled: Resize event.\n");
     abort();
   }
 
   vkResetFences(ctx->device, 1, &ctx->in_flight_fences[ctx->current_frame]);
   
+  PROFILE_BEGIN(record, "record");
   VkCommandBuffer cmd = ctx->command_buffers[ctx->current_frame];
   vkResetCommandBuffer(cmd, 0);
 
@@ -879,7 +1472,10 @@ void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
 
   vkCmdBeginRenderPass(cmd, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
 
-  vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, ctx->tri_pipeline);
+  // Not compiled yet and no default pipeline: the frame is cleared but
+  // nothing is drawn.
+  VkPipeline pipeline = vk_pipeline_resolve(ctx, ctx->tri_pipeline);
+  if (pipeline != VK_NULL_HANDLE) vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
   VkDeviceSize offsets[] = {0};
   vkCmdBindVertexBuffers(cmd, 0, 1, &ctx->buffer, offsets);
   
@@ -899,11 +1495,12 @@ void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
   };
   vkCmdSetScissor(cmd, 0, 1, &scissor);
   
-  if (vertex_count > 0)
+  if (pipeline != VK_NULL_HANDLE && vertex_count > 0)
     vkCmdDraw(cmd, vertex_count, 1, 0, 0);
   
   vkCmdEndRenderPass(cmd);
   vkEndCommandBuffer(cmd);
+  PROFILE_END(record);
 
   VkPipelineStageFlags wait_stages[] = {
     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
@@ -920,7 +1517,9 @@ void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
     .pSignalSemaphores = &ctx->render_finished_semaphores[img_idx]
   };
 
+  PROFILE_BEGIN(submit, "submit");
   vkQueueSubmit(ctx->graphics_queue, 1, &submit_info, ctx->in_flight_fences[ctx->current_frame]);
+  PROFILE_END(submit);
 
   VkPresentInfoKHR present_info = {
     .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
@@ -931,47 +1530,83 @@ void vk_draw_frame(vk_context *ctx, uint32_t vertex_count) {
     .pImageIndices = &img_idx
   };
 
+  PROFILE_BEGIN(present, "present");
   vkQueuePresentKHR(ctx->graphics_queue, &present_info);
+  PROFILE_END(present);
 
   ctx->current_frame = (ctx->current_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+  ++ctx->frame_index;
 }
 
 void vk_context_shutdown(vk_context *ctx) {
+  PROFILE_FUNCTION();
+  job_wait(&ctx->pipeline_jobs);
   if (ctx->device != VK_NULL_HANDLE)
     vkDeviceWaitIdle(ctx->device);
 
-  if (ctx->tri_pipeline != VK_NULL_HANDLE)
-    vkDestroyPipeline(ctx->device, ctx->tri_pipeline, NULL);
+  if (ctx->pipelines.items != NULL) {
+    for (uint32_t i = 0; i < ctx->pipelines.capacity; ++i) {
+      vk_pipeline_handle pipeline = { pool_handle_at(&ctx->pipelines, i) };
+      if (pipeline.id != POOL_NULL_HANDLE)
+        vkDestroyPipeline(ctx->device, vk_pipeline_pool_get(&ctx->pipelines, pipeline)->pipeline, NULL);
+    }
+    pool_destroy(&ctx->pipelines);
+  }
+
+  for (uint32_t i = 0; i < ctx->swap_count; ++i)
+    vkDestroyPipeline(ctx->device, ctx->swaps[i].pipeline, NULL);
+  for (uint32_t i = 0; i < ctx->retired_count; ++i)
+    vkDestroyPipeline(ctx->device, ctx->retired[i].pipeline, NULL);
+  // Pipelines still queued for destroy went with the pool above.
+  ctx->swap_count = ctx->retired_count = ctx->destroy_count = 0;
 
-  if (ctx->pipeline_layout != VK_NULL_HANDLE)
-    vkDestroyPipelineLayout(ctx->device, ctx->pipeline_layout, NULL);
+  if (ctx->pipeline_cache != VK_NULL_HANDLE) {
+    __vk_save_pipeline_cache(ctx);
+    vkDestroyPipelineCache(ctx->device, ctx->pipeline_cache, NULL);
+  }
+
+  for (uint32_t i = 0; i < ctx->pipeline_layout_count; ++i)
+    vkDestroyPipelineLayout(ctx->device, ctx->pipeline_layouts[i].layout, NULL);
+  for (uint32_t i = 0; i < ctx->set_layout_count; ++i)
+    vkDestroyDescriptorSetLayout(ctx->device, ctx->set_layouts[i].layout, NULL);
+  ctx->pipeline_layout_count = ctx->set_layout_count = 0;
+  ctx->pipeline_layout = VK_NULL_HANDLE;
+  if (ctx->layout_lock) SDL_DestroyMutex(ctx->layout_lock);
+  ctx->layout_lock = NULL;
   
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    arena_destroy(&ctx->frame_arenas[i]);
+
   if (ctx->in_flight_fences != NULL) {
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
       vkDestroyFence(ctx->device, ctx->in_flight_fences[i], NULL);
     }
   }
+  mem_free(ctx->in_flight_fences);
   
   if (ctx->image_available_semaphores != NULL) {
     for (uint32_t i = 0; i < ctx->image_count; ++i) {
       vkDestroySemaphore(ctx->device, ctx->image_available_semaphores[i], NULL);
     }
   }
+  mem_free(ctx->image_available_semaphores);
   
   if (ctx->render_finished_semaphores != NULL) {
     for (uint32_t i = 0; i < ctx->image_count; ++i) {
       vkDestroySemaphore(ctx->device, ctx->render_finished_semaphores[i], NULL);
     }
   }
+  mem_free(ctx->render_finished_semaphores);
       
   if (ctx->graphics_pool != VK_NULL_HANDLE)
     vkDestroyCommandPool(ctx->device, ctx->graphics_pool, NULL);
+  mem_free(ctx->command_buffers);
   
   if (ctx->framebuffers != NULL) {
     for (uint32_t i = 0; i < ctx->image_count; ++i)
       vkDestroyFramebuffer(ctx->device, ctx->framebuffers[i], NULL);
   }
-  free(ctx->framebuffers);
+  mem_free(ctx->framebuffers);
 
   if (ctx->render_pass != VK_NULL_HANDLE)
     vkDestroyRenderPass(ctx->device, ctx->render_pass, NULL);
@@ -980,13 +1615,13 @@ void vk_context_shutdown(vk_context *ctx) {
     for (uint32_t i = 0; i < ctx->image_count; ++i) {
       vkDestroyImageView(ctx->device, ctx->swapchain_image_views[i], NULL); 
     }
-    free(ctx->swapchain_image_views);
+    mem_free(ctx->swapchain_image_views);
   }
   
   if (ctx->swapchain != VK_NULL_HANDLE)
     vkDestroySwapchainKHR(ctx->device, ctx->swapchain, NULL);
 
-  free(ctx->swapchain_images);
+  mem_free(ctx->swapchain_images);
 
   if (ctx->device != VK_NULL_HANDLE)
     vkDestroyDevice(ctx->device, NULL);
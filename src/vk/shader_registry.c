@@ -0,0 +1,61 @@
+#include <vk/shader_registry.h>
+
+#include <core/memory.h>
+#include <util/file_io.h>
+#include <util/logger.h>
+
+#include <stdio.h>
+#include <string.h>
+
+const vk_shader_code *vk_shader_find_embedded(const char *name) {
+  uint32_t lo = 0, hi = __vk_embedded_shader_count;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int cmp = strcmp(name, __vk_embedded_shaders[mid].name);
+    if (cmp == 0) return &__vk_embedded_shaders[mid].code;
+    if (cmp < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  return NULL;
+}
+
+static bool __vk_shader_is_embedded(const uint32_t *code) {
+  for (uint32_t i = 0; i < __vk_embedded_shader_count; ++i)
+    if (__vk_embedded_shaders[i].code.code == code) return true;
+  return false;
+}
+
+bool vk_shader_load(const char *dir, const char *name, vk_shader_code *out) {
+  if (dir) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s.spv", dir, name);
+
+    // A file missing from the override directory is not an error; the
+    // embedded copy is used instead.
+    FILE *f = fopen(path, "rb");
+    if (f) {
+      fclose(f);
+      size_t size = 0;
+      uint8_t *code = read_entire_file(path, &size);
+      if (code) {
+        *out = (vk_shader_code) { (const uint32_t*)code, size };
+        LOG_DEBUG(LOG_CAT_VULKAN, "Loaded shader '%s' from '%s'.\n", name, path);
+        return true;
+      }
+    }
+  }
+
+  const vk_shader_code *embedded = vk_shader_find_embedded(name);
+  if (!embedded) {
+    LOG_ERROR(LOG_CAT_VULKAN, "No shader named '%s' is embedded%s%s.\n", name, dir ? " or found in " : "", dir ? dir : "");
+    return false;
+  }
+
+  *out = *embedded;
+  return true;
+}
+
+void vk_shader_release(vk_shader_code *code) {
+  if (code->code && !__vk_shader_is_embedded(code->code)) mem_free((void*)code->code);
+  *code = (vk_shader_code) {0};
+}
@@ -0,0 +1,262 @@
+// inotify, poll and posix_spawn are behind the default feature set, which
+// -std=c23 hides.
+#define _DEFAULT_SOURCE
+
+#include <vk/shader_reload.h>
+
+#include <core/memory.h>
+#include <util/file_io.h>
+#include <util/logger.h>
+#include <util/profiler.h>
+
+#include <SDL3/SDL_timer.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <poll.h>
+#include <stdalign.h>
+#include <spawn.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+// Editors and dxc may touch a file several times in a row; changes are acted
+// on once the directory has been quiet this long.
+#define SHADER_RELOAD_DEBOUNCE_MS 50
+#define SHADER_RELOAD_POLL_MS 100
+
+static const char *__shader_reload_basename(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+static int __shader_reload_watch(shader_reload *r, const char *path) {
+  char dir[SHADER_RELOAD_PATH_MAX];
+  const char *slash = strrchr(path, '/');
+  if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+  else snprintf(dir, sizeof(dir), ".");
+
+  // Watching the directory rather than the file survives editors that save
+  // by writing a new file and renaming it over the old one. inotify hands out
+  // the same descriptor when a directory is watched twice.
+  int wd = inotify_add_watch(r->inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd < 0)
+    LOG_WARNING(LOG_CAT_VULKAN, "Could not watch '%s' for shader changes: %s\n", dir, strerror(errno));
+  return wd;
+}
+
+static bool __shader_reload_run_dxc(const char *profile, const char *entry, const char *hlsl_path, const char *out_path) {
+  char *argv[] = {
+    "dxc", "-T", (char*)profile, "-E", (char*)entry, "-spirv", (char*)hlsl_path, "-Fo", (char*)out_path, NULL
+  };
+
+  pid_t pid;
+  int err = posix_spawnp(&pid, "dxc", NULL, NULL, argv, environ);
+  if (err != 0) {
+    LOG_WARNING(LOG_CAT_VULKAN, "Could not run dxc for '%s': %s\n", hlsl_path, strerror(err));
+    return false;
+  }
+
+  int status;
+  while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    LOG_WARNING(LOG_CAT_VULKAN, "dxc failed to compile '%s' (%s); keeping the old shader.\n", hlsl_path, entry);
+    return false;
+  }
+  return true;
+}
+
+// The rewritten SPIR-V raises its own events, which rebuild the pipeline.
+static void __shader_reload_compile_hlsl(const shader_reload_entry *entry) {
+  PROFILE_FUNCTION();
+  const char *hlsl = entry->paths[SHADER_RELOAD_HLSL];
+  LOG_INFO(LOG_CAT_VULKAN, "'%s' changed, recompiling.\n", hlsl);
+  __shader_reload_run_dxc("vs_6_0", "MainVS", hlsl, entry->paths[SHADER_RELOAD_VS]);
+  __shader_reload_run_dxc("ps_6_0", "MainFS", hlsl, entry->paths[SHADER_RELOAD_FS]);
+}
+
+static void __shader_reload_rebuild(shader_reload *r, const shader_reload_entry *entry) {
+  PROFILE_FUNCTION();
+  const char *vs_path = entry->paths[SHADER_RELOAD_VS];
+  const char *fs_path = entry->paths[SHADER_RELOAD_FS];
+
+  // Copied rather than mapped: the files are being rewritten by dxc or a
+  // build while we look, and reading a mapping of a file that was truncated
+  // underneath it raises SIGBUS. A short read just fails the rebuild.
+  size_t vs_size = 0, fs_size = 0;
+  uint8_t *vs = read_entire_file(vs_path, &vs_size);
+  uint8_t *fs = read_entire_file(fs_path, &fs_size);
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  if (vs && fs) {
+    pipeline = vk_pipeline_compile(
+        r->ctx,
+        (vk_shader_code) { (const uint32_t*)vs, vs_size },
+        (vk_shader_code) { (const uint32_t*)fs, fs_size },
+        &entry->config);
+  }
+  mem_free(vs);
+  mem_free(fs);
+
+  if (pipeline == VK_NULL_HANDLE) {
+    LOG_WARNING(LOG_CAT_VULKAN, "Could not rebuild the pipeline from '%s' and '%s'; keeping the old one.\n",
+                vs_path, fs_path);
+    return;
+  }
+
+  vk_pipeline_replace(r->ctx, entry->pipeline, pipeline);
+  LOG_INFO(LOG_CAT_VULKAN, "Reloaded the pipeline from '%s' and '%s'.\n", vs_path, fs_path);
+}
+
+// Marks the files of every entry that `ev` refers to.
+static void __shader_reload_mark(shader_reload *r, const struct inotify_event *ev, uint8_t *dirty) {
+  if (ev->len == 0) return;
+
+  SDL_LockSpinlock(&r->lock);
+  for (uint32_t i = 0; i < r->entry_count; ++i) {
+    const shader_reload_entry *entry = &r->entries[i];
+    for (uint32_t f = 0; f < SHADER_RELOAD_FILE_COUNT; ++f) {
+      if (entry->watches[f] == ev->wd && strcmp(__shader_reload_basename(entry->paths[f]), ev->name) == 0)
+        dirty[i] |= 1u << f;
+    }
+  }
+  SDL_UnlockSpinlock(&r->lock);
+}
+
+static int __shader_reload_main(void *data) {
+  PROFILE_THREAD("shader-reload");
+  shader_reload *r = data;
+
+  uint8_t dirty[SHADER_RELOAD_MAX_PIPELINES] = {0};
+  bool pending = false;
+  uint64_t last_event = 0;
+
+  // Large enough for several events with names up to NAME_MAX.
+  alignas(struct inotify_event) char buf[4096];
+
+  while (SDL_GetAtomicInt(&r->running)) {
+    struct pollfd pfd = { .fd = r->inotify_fd, .events = POLLIN };
+    int ready = poll(&pfd, 1, pending ? SHADER_RELOAD_DEBOUNCE_MS : SHADER_RELOAD_POLL_MS);
+
+    if (ready > 0) {
+      ssize_t len;
+      while ((len = read(r->inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len;) {
+          const struct inotify_event *ev = (const struct inotify_event*)p;
+          __shader_reload_mark(r, ev, dirty);
+          p += sizeof(struct inotify_event) + ev->len;
+        }
+      }
+      for (uint32_t i = 0; i < SHADER_RELOAD_MAX_PIPELINES; ++i) pending |= dirty[i] != 0;
+      last_event = SDL_GetTicks();
+      continue;
+    }
+
+    if (!pending || SDL_GetTicks() - last_event < SHADER_RELOAD_DEBOUNCE_MS) continue;
+    pending = false;
+
+    for (uint32_t i = 0; i < SHADER_RELOAD_MAX_PIPELINES; ++i) {
+      if (!dirty[i]) continue;
+
+      // Entries only ever get appended, so a copy taken under the lock stays
+      // valid while the (slow) compile runs without it.
+      SDL_LockSpinlock(&r->lock);
+      shader_reload_entry entry = r->entries[i];
+      SDL_UnlockSpinlock(&r->lock);
+
+      if (dirty[i] & (1u << SHADER_RELOAD_HLSL)) __shader_reload_compile_hlsl(&entry);
+      else __shader_reload_rebuild(r, &entry);
+      dirty[i] = 0;
+    }
+  }
+
+  return 0;
+}
+
+bool shader_reload_init(shader_reload *r, vk_context *ctx) {
+  memset(r, 0, sizeof(*r));
+  r->ctx = ctx;
+
+  r->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (r->inotify_fd < 0) {
+    LOG_WARNING(LOG_CAT_VULKAN, "Shader hot reload is off: inotify_init1 failed: %s\n", strerror(errno));
+    return false;
+  }
+
+  SDL_SetAtomicInt(&r->running, 1);
+  r->thread = SDL_CreateThread(__shader_reload_main, "shader-reload", r);
+  if (!r->thread) {
+    LOG_WARNING(LOG_CAT_VULKAN, "Shader hot reload is off: could not start its thread: %s\n", SDL_GetError());
+    close(r->inotify_fd);
+    r->inotify_fd = -1;
+    return false;
+  }
+
+  LOG_INFO(LOG_CAT_VULKAN, "Shader hot reload is watching for changes.\n");
+  return true;
+}
+
+void shader_reload_track(shader_reload *r, vk_pipeline_handle pipeline,
+                         const char *vs_path, const char *fs_path, const char *hlsl_path,
+                         const vk_pipeline_config *config) {
+  if (!r->thread) return;
+
+  shader_reload_entry entry = {0};
+  entry.pipeline = pipeline;
+  entry.config = *config;
+  const char *paths[SHADER_RELOAD_FILE_COUNT] = { vs_path, fs_path, hlsl_path };
+  for (uint32_t f = 0; f < SHADER_RELOAD_FILE_COUNT; ++f) {
+    entry.watches[f] = -1;
+    if (!paths[f]) continue;
+    if (strlen(paths[f]) >= SHADER_RELOAD_PATH_MAX) {
+      LOG_WARNING(LOG_CAT_VULKAN, "Shader path '%s' is too long to watch.\n", paths[f]);
+      return;
+    }
+    strcpy(entry.paths[f], paths[f]);
+    entry.watches[f] = __shader_reload_watch(r, paths[f]);
+  }
+
+  SDL_LockSpinlock(&r->lock);
+  bool added = r->entry_count < SHADER_RELOAD_MAX_PIPELINES;
+  if (added) r->entries[r->entry_count++] = entry;
+  SDL_UnlockSpinlock(&r->lock);
+
+  if (!added) LOG_WARNING(LOG_CAT_VULKAN, "Shader hot reload tracks at most %d pipelines.\n", SHADER_RELOAD_MAX_PIPELINES);
+}
+
+void shader_reload_shutdown(shader_reload *r) {
+  if (!r->thread) return;
+  SDL_SetAtomicInt(&r->running, 0);
+  SDL_WaitThread(r->thread, NULL);
+  r->thread = NULL;
+  close(r->inotify_fd);
+  r->inotify_fd = -1;
+}
+
+#else
+
+bool shader_reload_init(shader_reload *r, vk_context *ctx) {
+  memset(r, 0, sizeof(*r));
+  r->ctx = ctx;
+  r->inotify_fd = -1;
+  LOG_WARNING(LOG_CAT_VULKAN, "Shader hot reload is only supported on Linux.\n");
+  return false;
+}
+
+void shader_reload_track(shader_reload *r, vk_pipeline_handle pipeline,
+                         const char *vs_path, const char *fs_path, const char *hlsl_path,
+                         const vk_pipeline_config *config) {
+  (void)r; (void)pipeline; (void)vs_path; (void)fs_path; (void)hlsl_path; (void)config;
+}
+
+void shader_reload_shutdown(shader_reload *r) {
+  (void)r;
+}
+
+#endif // __linux__
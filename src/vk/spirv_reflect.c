@@ -0,0 +1,518 @@
+#include <vk/spirv_reflect.h>
+
+#include <core/memory.h>
+#include <util/logger.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// The subset of the SPIR-V grammar the reflection looks at.
+enum {
+  SPV_OP_ENTRY_POINT = 15,
+  SPV_OP_TYPE_INT = 21,
+  SPV_OP_TYPE_FLOAT = 22,
+  SPV_OP_TYPE_VECTOR = 23,
+  SPV_OP_TYPE_MATRIX = 24,
+  SPV_OP_TYPE_IMAGE = 25,
+  SPV_OP_TYPE_SAMPLER = 26,
+  SPV_OP_TYPE_SAMPLED_IMAGE = 27,
+  SPV_OP_TYPE_ARRAY = 28,
+  SPV_OP_TYPE_RUNTIME_ARRAY = 29,
+  SPV_OP_TYPE_STRUCT = 30,
+  SPV_OP_TYPE_POINTER = 32,
+  SPV_OP_CONSTANT = 43,
+  SPV_OP_VARIABLE = 59,
+  SPV_OP_DECORATE = 71,
+  SPV_OP_MEMBER_DECORATE = 72,
+  SPV_OP_TYPE_ACCELERATION_STRUCTURE = 5341,
+};
+
+enum {
+  SPV_EXEC_VERTEX = 0,
+  SPV_EXEC_TESS_CONTROL = 1,
+  SPV_EXEC_TESS_EVALUATION = 2,
+  SPV_EXEC_GEOMETRY = 3,
+  SPV_EXEC_FRAGMENT = 4,
+  SPV_EXEC_GL_COMPUTE = 5,
+};
+
+enum {
+  SPV_DECORATION_BLOCK = 2,
+  SPV_DECORATION_BUFFER_BLOCK = 3,
+  SPV_DECORATION_ROW_MAJOR = 4,
+  SPV_DECORATION_ARRAY_STRIDE = 6,
+  SPV_DECORATION_MATRIX_STRIDE = 7,
+  SPV_DECORATION_BUILT_IN = 11,
+  SPV_DECORATION_LOCATION = 30,
+  SPV_DECORATION_BINDING = 33,
+  SPV_DECORATION_DESCRIPTOR_SET = 34,
+  SPV_DECORATION_OFFSET = 35,
+};
+
+enum {
+  SPV_STORAGE_UNIFORM_CONSTANT = 0,
+  SPV_STORAGE_INPUT = 1,
+  SPV_STORAGE_UNIFORM = 2,
+  SPV_STORAGE_PUSH_CONSTANT = 9,
+  SPV_STORAGE_STORAGE_BUFFER = 12,
+};
+
+enum {
+  SPV_DIM_BUFFER = 5,
+  SPV_DIM_SUBPASS_DATA = 6,
+};
+
+#define SPIRV_HEADER_WORDS 5
+// Ids past this are taken as a corrupt header rather than allocated for.
+#define SPIRV_MAX_BOUND (1u << 22)
+// Types nest deeper than this only in malformed modules.
+#define SPIRV_MAX_TYPE_DEPTH 16
+#define SPIRV_MAX_STRUCT_MEMBERS 64
+
+typedef enum spirv_id_flag_t {
+  SPIRV_ID_LOCATION = 1 << 0,
+  SPIRV_ID_BINDING = 1 << 1,
+  SPIRV_ID_SET = 1 << 2,
+  SPIRV_ID_BUILT_IN = 1 << 3,
+  SPIRV_ID_BLOCK = 1 << 4,
+  SPIRV_ID_BUFFER_BLOCK = 1 << 5,
+} spirv_id_flag;
+
+// What is known about one result id: the instruction that defines it, if it
+// is one we care about, and its decorations.
+typedef struct spirv_id_t {
+  uint32_t opcode;
+  // Word index of the defining instruction.
+  uint32_t offset;
+  uint32_t location;
+  uint32_t binding;
+  uint32_t set;
+  uint32_t array_stride;
+  uint32_t flags;
+} spirv_id;
+
+typedef struct spirv_module_t {
+  const uint32_t *words;
+  uint32_t word_count;
+  uint32_t bound;
+  spirv_id *ids;
+} spirv_module;
+
+// Fewest words each recorded instruction must have; shorter ones are
+// malformed. Zero for opcodes that are skipped.
+static uint32_t __spirv_min_words(uint32_t opcode) {
+  switch (opcode) {
+  case SPV_OP_ENTRY_POINT: return 4;
+  case SPV_OP_TYPE_INT: return 4;
+  case SPV_OP_TYPE_FLOAT: return 3;
+  case SPV_OP_TYPE_VECTOR: return 4;
+  case SPV_OP_TYPE_MATRIX: return 4;
+  case SPV_OP_TYPE_IMAGE: return 9;
+  case SPV_OP_TYPE_SAMPLER: return 2;
+  case SPV_OP_TYPE_SAMPLED_IMAGE: return 3;
+  case SPV_OP_TYPE_ARRAY: return 4;
+  case SPV_OP_TYPE_RUNTIME_ARRAY: return 3;
+  case SPV_OP_TYPE_STRUCT: return 2;
+  case SPV_OP_TYPE_POINTER: return 4;
+  case SPV_OP_CONSTANT: return 4;
+  case SPV_OP_VARIABLE: return 4;
+  case SPV_OP_DECORATE: return 3;
+  case SPV_OP_MEMBER_DECORATE: return 4;
+  case SPV_OP_TYPE_ACCELERATION_STRUCTURE: return 2;
+  default: return 0;
+  }
+}
+
+// Word index of the result id in the recorded instructions that define one.
+static uint32_t __spirv_result_word(uint32_t opcode) {
+  return opcode == SPV_OP_CONSTANT || opcode == SPV_OP_VARIABLE ? 2 : 1;
+}
+
+static const uint32_t *__spirv_def(const spirv_module *m, uint32_t id, uint32_t opcode) {
+  if (id >= m->bound || m->ids[id].opcode != opcode) return NULL;
+  return m->words + m->ids[id].offset;
+}
+
+static uint32_t __spirv_opcode(const spirv_module *m, uint32_t id) {
+  return id < m->bound ? m->ids[id].opcode : 0;
+}
+
+static bool __spirv_constant(const spirv_module *m, uint32_t id, uint32_t *value) {
+  const uint32_t *ins = __spirv_def(m, id, SPV_OP_CONSTANT);
+  if (!ins) return false;
+  *value = ins[3];
+  return true;
+}
+
+static uint32_t __spirv_type_size(const spirv_module *m, uint32_t type, uint32_t matrix_stride, bool row_major, uint32_t depth);
+
+static uint32_t __spirv_struct_size(const spirv_module *m, uint32_t type, uint32_t depth) {
+  const uint32_t *ins = __spirv_def(m, type, SPV_OP_TYPE_STRUCT);
+  uint32_t member_count = (ins[0] >> 16) - 2;
+  if (member_count > SPIRV_MAX_STRUCT_MEMBERS) return 0;
+
+  uint32_t offsets[SPIRV_MAX_STRUCT_MEMBERS] = {0};
+  uint32_t matrix_strides[SPIRV_MAX_STRUCT_MEMBERS] = {0};
+  bool row_major[SPIRV_MAX_STRUCT_MEMBERS] = {0};
+
+  // Member layout lives in OpMemberDecorate, which has no id of its own to
+  // index by; structs are few, so just scan for them.
+  for (uint32_t i = SPIRV_HEADER_WORDS; i < m->word_count; i += m->words[i] >> 16) {
+    const uint32_t *d = m->words + i;
+    if ((d[0] & 0xffff) != SPV_OP_MEMBER_DECORATE || d[1] != type || d[2] >= member_count) continue;
+    bool has_literal = (d[0] >> 16) >= 5;
+    switch (d[3]) {
+    case SPV_DECORATION_OFFSET: if (has_literal) offsets[d[2]] = d[4]; break;
+    case SPV_DECORATION_MATRIX_STRIDE: if (has_literal) matrix_strides[d[2]] = d[4]; break;
+    case SPV_DECORATION_ROW_MAJOR: row_major[d[2]] = true; break;
+    default: break;
+    }
+  }
+
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < member_count; ++i) {
+    uint32_t end = offsets[i] + __spirv_type_size(m, ins[2 + i], matrix_strides[i], row_major[i], depth + 1);
+    if (end > size) size = end;
+  }
+  return size;
+}
+
+// Size in bytes of `type` as laid out in a buffer or push constant block.
+static uint32_t __spirv_type_size(const spirv_module *m, uint32_t type, uint32_t matrix_stride, bool row_major, uint32_t depth) {
+  if (depth > SPIRV_MAX_TYPE_DEPTH || type >= m->bound) return 0;
+  const uint32_t *ins = m->words + m->ids[type].offset;
+
+  switch (m->ids[type].opcode) {
+  case SPV_OP_TYPE_INT:
+  case SPV_OP_TYPE_FLOAT:
+    return ins[2] / 8;
+  case SPV_OP_TYPE_VECTOR:
+    return ins[3] * __spirv_type_size(m, ins[2], 0, false, depth + 1);
+  case SPV_OP_TYPE_MATRIX: {
+    uint32_t columns = ins[3];
+    const uint32_t *column = __spirv_def(m, ins[2], SPV_OP_TYPE_VECTOR);
+    if (!column) return 0;
+    if (matrix_stride) return (row_major ? column[3] : columns) * matrix_stride;
+    return columns * __spirv_type_size(m, ins[2], 0, false, depth + 1);
+  }
+  case SPV_OP_TYPE_ARRAY: {
+    uint32_t length;
+    if (!__spirv_constant(m, ins[3], &length)) return 0;
+    uint32_t stride = m->ids[type].array_stride;
+    if (!stride) stride = __spirv_type_size(m, ins[2], matrix_stride, row_major, depth + 1);
+    return length * stride;
+  }
+  case SPV_OP_TYPE_STRUCT:
+    return __spirv_struct_size(m, type, depth);
+  default:
+    return 0;
+  }
+}
+
+static VkFormat __spirv_input_format(const spirv_module *m, uint32_t type, uint32_t *size) {
+  static const VkFormat f16[4] = { VK_FORMAT_R16_SFLOAT, VK_FORMAT_R16G16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT };
+  static const VkFormat f32[4] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+  static const VkFormat f64[4] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+  static const VkFormat s16[4] = { VK_FORMAT_R16_SINT, VK_FORMAT_R16G16_SINT, VK_FORMAT_R16G16B16_SINT, VK_FORMAT_R16G16B16A16_SINT };
+  static const VkFormat u16[4] = { VK_FORMAT_R16_UINT, VK_FORMAT_R16G16_UINT, VK_FORMAT_R16G16B16_UINT, VK_FORMAT_R16G16B16A16_UINT };
+  static const VkFormat s32[4] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+  static const VkFormat u32[4] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+  uint32_t components = 1;
+  const uint32_t *vector = __spirv_def(m, type, SPV_OP_TYPE_VECTOR);
+  if (vector) {
+    components = vector[3];
+    type = vector[2];
+  }
+  if (components < 1 || components > 4) return VK_FORMAT_UNDEFINED;
+
+  const VkFormat *formats = NULL;
+  const uint32_t *scalar;
+  if ((scalar = __spirv_def(m, type, SPV_OP_TYPE_FLOAT))) {
+    formats = scalar[2] == 16 ? f16 : scalar[2] == 32 ? f32 : scalar[2] == 64 ? f64 : NULL;
+  } else if ((scalar = __spirv_def(m, type, SPV_OP_TYPE_INT))) {
+    bool is_signed = scalar[3] != 0;
+    if (scalar[2] == 16) formats = is_signed ? s16 : u16;
+    else if (scalar[2] == 32) formats = is_signed ? s32 : u32;
+  }
+  if (!formats) return VK_FORMAT_UNDEFINED;
+
+  *size = components * scalar[2] / 8;
+  return formats[components - 1];
+}
+
+// Adds one input per location `type` covers, starting at `*location`.
+static bool __spirv_add_input(const spirv_module *m, spirv_reflection *r, uint32_t type, uint32_t *location, uint32_t depth) {
+  if (depth > SPIRV_MAX_TYPE_DEPTH) return false;
+
+  uint32_t count = 0;
+  const uint32_t *ins;
+  if ((ins = __spirv_def(m, type, SPV_OP_TYPE_MATRIX))) count = ins[3];
+  else if ((ins = __spirv_def(m, type, SPV_OP_TYPE_ARRAY)) && !__spirv_constant(m, ins[3], &count)) return false;
+
+  if (ins) {
+    for (uint32_t i = 0; i < count; ++i)
+      if (!__spirv_add_input(m, r, ins[2], location, depth + 1)) return false;
+    return true;
+  }
+
+  spirv_input input = { .location = *location };
+  input.format = __spirv_input_format(m, type, &input.size);
+  if (input.format == VK_FORMAT_UNDEFINED || r->input_count == SPIRV_MAX_INPUTS) return false;
+  r->inputs[r->input_count++] = input;
+  // 64-bit three- and four-component vectors take two locations.
+  *location += input.size > 16 ? 2 : 1;
+  return true;
+}
+
+static VkDescriptorType __spirv_descriptor_type(const spirv_module *m, uint32_t storage, uint32_t type) {
+  const uint32_t *ins;
+  switch (storage) {
+  case SPV_STORAGE_UNIFORM:
+    if (__spirv_opcode(m, type) != SPV_OP_TYPE_STRUCT) break;
+    return m->ids[type].flags & SPIRV_ID_BUFFER_BLOCK ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  case SPV_STORAGE_STORAGE_BUFFER:
+    return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  case SPV_STORAGE_UNIFORM_CONSTANT:
+    switch (__spirv_opcode(m, type)) {
+    case SPV_OP_TYPE_SAMPLER:
+      return VK_DESCRIPTOR_TYPE_SAMPLER;
+    case SPV_OP_TYPE_ACCELERATION_STRUCTURE:
+      return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+    case SPV_OP_TYPE_SAMPLED_IMAGE:
+      ins = __spirv_def(m, m->words[m->ids[type].offset + 2], SPV_OP_TYPE_IMAGE);
+      if (ins && ins[3] == SPV_DIM_BUFFER) return VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+      return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case SPV_OP_TYPE_IMAGE:
+      ins = m->words + m->ids[type].offset;
+      // Word 7 is "sampled": 1 for images read through a sampler, 2 for
+      // storage images.
+      if (ins[3] == SPV_DIM_SUBPASS_DATA) return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+      if (ins[3] == SPV_DIM_BUFFER)
+        return ins[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+      return ins[7] == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    default:
+      break;
+    }
+    break;
+  default:
+    break;
+  }
+  return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+static bool __spirv_add_binding(const spirv_module *m, spirv_reflection *r, const spirv_id *var, uint32_t storage, uint32_t type) {
+  if ((var->flags & (SPIRV_ID_BINDING | SPIRV_ID_SET)) != (SPIRV_ID_BINDING | SPIRV_ID_SET)) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V resource has no descriptor set or binding.\n");
+    return false;
+  }
+
+  spirv_binding b = { .set = var->set, .binding = var->binding, .count = 1 };
+  const uint32_t *ins;
+  for (uint32_t depth = 0; (ins = __spirv_def(m, type, SPV_OP_TYPE_ARRAY)); ++depth) {
+    uint32_t length;
+    if (depth > SPIRV_MAX_TYPE_DEPTH || !__spirv_constant(m, ins[3], &length)) return false;
+    b.count *= length;
+    type = ins[2];
+  }
+  if (__spirv_opcode(m, type) == SPV_OP_TYPE_RUNTIME_ARRAY) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V uses an unbounded descriptor array (set %u, binding %u), which is not supported.\n",
+              b.set, b.binding);
+    return false;
+  }
+
+  b.type = __spirv_descriptor_type(m, storage, type);
+  if (b.type == VK_DESCRIPTOR_TYPE_MAX_ENUM) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V resource at set %u, binding %u has an unsupported type.\n", b.set, b.binding);
+    return false;
+  }
+
+  // Several variables may alias one binding as long as they agree on it.
+  for (uint32_t i = 0; i < r->binding_count; ++i) {
+    spirv_binding *other = &r->bindings[i];
+    if (other->set != b.set || other->binding != b.binding) continue;
+    if (other->type == b.type && other->count == b.count) return true;
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V declares set %u, binding %u twice with different types.\n", b.set, b.binding);
+    return false;
+  }
+
+  if (r->binding_count == SPIRV_MAX_BINDINGS) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V module has more than %d descriptor bindings.\n", SPIRV_MAX_BINDINGS);
+    return false;
+  }
+  r->bindings[r->binding_count++] = b;
+  return true;
+}
+
+static bool __spirv_read_entry_point(const uint32_t *ins, spirv_reflection *r) {
+  switch (ins[1]) {
+  case SPV_EXEC_VERTEX: r->stage = VK_SHADER_STAGE_VERTEX_BIT; break;
+  case SPV_EXEC_TESS_CONTROL: r->stage = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT; break;
+  case SPV_EXEC_TESS_EVALUATION: r->stage = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT; break;
+  case SPV_EXEC_GEOMETRY: r->stage = VK_SHADER_STAGE_GEOMETRY_BIT; break;
+  case SPV_EXEC_FRAGMENT: r->stage = VK_SHADER_STAGE_FRAGMENT_BIT; break;
+  case SPV_EXEC_GL_COMPUTE: r->stage = VK_SHADER_STAGE_COMPUTE_BIT; break;
+  default:
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V entry point has unsupported execution model %u.\n", ins[1]);
+    return false;
+  }
+
+  // The name is a nul-terminated string packed into the words after the
+  // entry point's id.
+  const char *name = (const char*)(ins + 3);
+  size_t max = ((ins[0] >> 16) - 3) * sizeof(uint32_t);
+  const char *end = memchr(name, '\0', max);
+  size_t len = end ? (size_t)(end - name) : max;
+  if (!end || len >= SPIRV_MAX_ENTRY_POINT_NAME) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V entry point name is malformed or too long.\n");
+    return false;
+  }
+  memcpy(r->entry_point, name, len + 1);
+  return true;
+}
+
+static int __spirv_compare_inputs(const void *a, const void *b) {
+  const spirv_input *x = a, *y = b;
+  return (x->location > y->location) - (x->location < y->location);
+}
+
+static int __spirv_compare_bindings(const void *a, const void *b) {
+  const spirv_binding *x = a, *y = b;
+  if (x->set != y->set) return (x->set > y->set) - (x->set < y->set);
+  return (x->binding > y->binding) - (x->binding < y->binding);
+}
+
+// Records every id-defining instruction we care about and folds decorations
+// into the ids they apply to.
+static bool __spirv_index(spirv_module *m, spirv_reflection *r, bool *has_entry_point) {
+  for (uint32_t i = SPIRV_HEADER_WORDS; i < m->word_count;) {
+    const uint32_t *ins = m->words + i;
+    uint32_t opcode = ins[0] & 0xffff;
+    uint32_t word_count = ins[0] >> 16;
+    if (word_count == 0 || word_count > m->word_count - i) {
+      LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V instruction at word %u overruns the module.\n", i);
+      return false;
+    }
+
+    uint32_t min_words = __spirv_min_words(opcode);
+    if (min_words && word_count < min_words) {
+      LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V instruction %u at word %u is truncated.\n", opcode, i);
+      return false;
+    }
+
+    if (opcode == SPV_OP_ENTRY_POINT) {
+      if (!*has_entry_point && !__spirv_read_entry_point(ins, r)) return false;
+      *has_entry_point = true;
+    } else if (opcode == SPV_OP_DECORATE) {
+      if (ins[1] >= m->bound) {
+        LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V decorates out-of-bounds id %u.\n", ins[1]);
+        return false;
+      }
+      spirv_id *target = &m->ids[ins[1]];
+      bool has_literal = word_count >= 4;
+      switch (ins[2]) {
+      case SPV_DECORATION_BLOCK: target->flags |= SPIRV_ID_BLOCK; break;
+      case SPV_DECORATION_BUFFER_BLOCK: target->flags |= SPIRV_ID_BUFFER_BLOCK; break;
+      case SPV_DECORATION_BUILT_IN: target->flags |= SPIRV_ID_BUILT_IN; break;
+      case SPV_DECORATION_ARRAY_STRIDE: if (has_literal) target->array_stride = ins[3]; break;
+      case SPV_DECORATION_LOCATION:
+        if (has_literal) { target->location = ins[3]; target->flags |= SPIRV_ID_LOCATION; }
+        break;
+      case SPV_DECORATION_BINDING:
+        if (has_literal) { target->binding = ins[3]; target->flags |= SPIRV_ID_BINDING; }
+        break;
+      case SPV_DECORATION_DESCRIPTOR_SET:
+        if (has_literal) { target->set = ins[3]; target->flags |= SPIRV_ID_SET; }
+        break;
+      default: break;
+      }
+    } else if (min_words && opcode != SPV_OP_MEMBER_DECORATE) {
+      uint32_t id = ins[__spirv_result_word(opcode)];
+      if (id >= m->bound) {
+        LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V id %u is out of bounds.\n", id);
+        return false;
+      }
+      m->ids[id].opcode = opcode;
+      m->ids[id].offset = i;
+    }
+
+    i += word_count;
+  }
+  return true;
+}
+
+static bool __spirv_reflect_variables(const spirv_module *m, spirv_reflection *r) {
+  for (uint32_t id = 0; id < m->bound; ++id) {
+    const spirv_id *var = &m->ids[id];
+    if (var->opcode != SPV_OP_VARIABLE) continue;
+
+    const uint32_t *ins = m->words + var->offset;
+    uint32_t storage = ins[3];
+    const uint32_t *pointer = __spirv_def(m, ins[1], SPV_OP_TYPE_POINTER);
+    if (!pointer) return false;
+    uint32_t type = pointer[3];
+
+    switch (storage) {
+    case SPV_STORAGE_INPUT: {
+      if (r->stage != VK_SHADER_STAGE_VERTEX_BIT) break;
+      if (var->flags & SPIRV_ID_BUILT_IN || !(var->flags & SPIRV_ID_LOCATION)) break;
+      uint32_t location = var->location;
+      if (!__spirv_add_input(m, r, type, &location, 0)) {
+        LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V vertex input at location %u has an unsupported type.\n", var->location);
+        return false;
+      }
+      break;
+    }
+    case SPV_STORAGE_UNIFORM:
+    case SPV_STORAGE_UNIFORM_CONSTANT:
+    case SPV_STORAGE_STORAGE_BUFFER:
+      if (!__spirv_add_binding(m, r, var, storage, type)) return false;
+      break;
+    case SPV_STORAGE_PUSH_CONSTANT: {
+      uint32_t size = __spirv_type_size(m, type, 0, false, 0);
+      if (size > r->push_constant_size) r->push_constant_size = size;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+  return true;
+}
+
+bool spirv_reflect(const uint32_t *code, size_t size, spirv_reflection *out) {
+  memset(out, 0, sizeof(*out));
+
+  if (size < SPIRV_HEADER_WORDS * sizeof(uint32_t) || size % sizeof(uint32_t) != 0 || code[0] != SPIRV_MAGIC) {
+    LOG_ERROR(LOG_CAT_VULKAN, "Shader code is not SPIR-V (%zu bytes).\n", size);
+    return false;
+  }
+
+  spirv_module m = {
+    .words = code,
+    .word_count = (uint32_t)(size / sizeof(uint32_t)),
+    .bound = code[3],
+  };
+  if (m.bound == 0 || m.bound > SPIRV_MAX_BOUND) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V id bound %u is out of range.\n", m.bound);
+    return false;
+  }
+
+  m.ids = mem_alloc(sizeof(spirv_id) * m.bound, MEM_TAG_RENDERER);
+  if (!check_mem_alloc(m.ids)) return false;
+  memset(m.ids, 0, sizeof(spirv_id) * m.bound);
+
+  bool has_entry_point = false;
+  bool ok = __spirv_index(&m, out, &has_entry_point);
+  if (ok && !has_entry_point) {
+    LOG_ERROR(LOG_CAT_VULKAN, "SPIR-V module has no entry point.\n");
+    ok = false;
+  }
+  ok = ok && __spirv_reflect_variables(&m, out);
+  mem_free(m.ids);
+  if (!ok) return false;
+
+  qsort(out->inputs, out->input_count, sizeof(spirv_input), __spirv_compare_inputs);
+  qsort(out->bindings, out->binding_count, sizeof(spirv_binding), __spirv_compare_bindings);
+  return true;
+}
@@ -0,0 +1,120 @@
+// Build-time tool: turns compiled SPIR-V files into a C source file that
+// defines the engine's embedded shader registry (see vk/shader_registry.h).
+//
+//   embed_spirv <output.c> <shader.spv>...
+//
+// Each shader is registered under its file name without directory and
+// extension, so "shaders/tri-vert.spv" becomes "tri-vert".
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SPIRV_MAGIC 0x07230203u
+#define NAME_MAX_LEN 128
+
+typedef struct shader_file_t {
+  const char *path;
+  char name[NAME_MAX_LEN];
+  uint32_t *words;
+  size_t word_count;
+} shader_file;
+
+static int read_shader(shader_file *s) {
+  const char *base = strrchr(s->path, '/');
+  base = base ? base + 1 : s->path;
+  const char *dot = strrchr(base, '.');
+  size_t len = dot ? (size_t)(dot - base) : strlen(base);
+  if (len == 0 || len >= NAME_MAX_LEN) {
+    fprintf(stderr, "embed_spirv: bad shader name in '%s'\n", s->path);
+    return 0;
+  }
+  memcpy(s->name, base, len);
+  s->name[len] = '\0';
+
+  FILE *f = fopen(s->path, "rb");
+  if (!f) {
+    perror(s->path);
+    return 0;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  rewind(f);
+
+  if (size < 20 || size % 4 != 0) {
+    fprintf(stderr, "embed_spirv: '%s' is not SPIR-V (%ld bytes)\n", s->path, size);
+    fclose(f);
+    return 0;
+  }
+
+  s->word_count = (size_t)size / 4;
+  s->words = malloc((size_t)size);
+  int ok = s->words && fread(s->words, 4, s->word_count, f) == s->word_count;
+  fclose(f);
+  if (!ok || s->words[0] != SPIRV_MAGIC) {
+    fprintf(stderr, "embed_spirv: could not read SPIR-V from '%s'\n", s->path);
+    return 0;
+  }
+  return 1;
+}
+
+static int compare_names(const void *a, const void *b) {
+  return strcmp(((const shader_file*)a)->name, ((const shader_file*)b)->name);
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s <output.c> <shader.spv>...\n", argv[0]);
+    return 1;
+  }
+
+  int count = argc - 2;
+  shader_file *shaders = calloc((size_t)count, sizeof(shader_file));
+  if (!shaders) return 1;
+  for (int i = 0; i < count; ++i) {
+    shaders[i].path = argv[i + 2];
+    if (!read_shader(&shaders[i])) return 1;
+  }
+
+  // Sorted so the registry can be binary searched.
+  qsort(shaders, (size_t)count, sizeof(shader_file), compare_names);
+  for (int i = 1; i < count; ++i) {
+    if (strcmp(shaders[i - 1].name, shaders[i].name) == 0) {
+      fprintf(stderr, "embed_spirv: '%s' and '%s' have the same name\n", shaders[i - 1].path, shaders[i].path);
+      return 1;
+    }
+  }
+
+  FILE *out = fopen(argv[1], "w");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  fprintf(out, "// Generated by tools/embed_spirv.c. Do not edit.\n\n");
+  fprintf(out, "#include <vk/shader_registry.h>\n\n");
+
+  for (int i = 0; i < count; ++i) {
+    fprintf(out, "// %s\n", shaders[i].path);
+    fprintf(out, "static const uint32_t __embedded_shader_%d[] = {", i);
+    for (size_t w = 0; w < shaders[i].word_count; ++w)
+      fprintf(out, "%s0x%08xu,", w % 8 == 0 ? "\n  " : " ", shaders[i].words[w]);
+    fprintf(out, "\n};\n\n");
+  }
+
+  fprintf(out, "const vk_embedded_shader __vk_embedded_shaders[] = {\n");
+  for (int i = 0; i < count; ++i)
+    fprintf(out, "  { \"%s\", { __embedded_shader_%d, sizeof(__embedded_shader_%d) } },\n", shaders[i].name, i, i);
+  fprintf(out, "};\n\n");
+  fprintf(out, "const uint32_t __vk_embedded_shader_count = %d;\n", count);
+
+  if (fclose(out) != 0) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  for (int i = 0; i < count; ++i) free(shaders[i].words);
+  free(shaders);
+  return 0;
+}
@@ -0,0 +1,227 @@
+// Build-time tool: packs asset files into an archive (see util/archive.h).
+//
+//   pack_archive [-s] <output.pak> <root> [<path>...]
+//
+// Each file is read from <root>/<path> and stored under <path>, which is what
+// the runtime looks it up by. With no paths on the command line they are read
+// from stdin, one per line, so a whole tree can be packed with
+//
+//   (cd assets && find . -type f | sed 's|^\./||') | pack_archive out.pak assets
+//
+// Blobs are written in the order the paths are given: list assets that are
+// loaded together next to each other. Each blob is compressed with the lz
+// codec when that pays off; -s stores everything as is.
+
+#include <util/archive.h>
+#include <util/lz.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PATH_MAX_LEN 1024
+// Blobs are only stored compressed when that makes them at least 1/16
+// smaller; below that the decode time is not paid back.
+#define MIN_SAVING 16
+
+typedef struct pack_file_t {
+  char *path;
+  archive_entry entry;
+} pack_file;
+
+typedef struct pack_list_t {
+  pack_file *files;
+  size_t count;
+  size_t capacity;
+} pack_list;
+
+static int add_path(pack_list *list, const char *path) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 256;
+    pack_file *files = realloc(list->files, capacity * sizeof(pack_file));
+    if (!files) return 0;
+    list->files = files;
+    list->capacity = capacity;
+  }
+  size_t len = strlen(path);
+  char *copy = malloc(len + 1);
+  if (!copy) return 0;
+  memcpy(copy, path, len + 1);
+  list->files[list->count++] = (pack_file) { .path = copy, .entry.hash = archive_hash_path(copy) };
+  return 1;
+}
+
+static int read_paths(pack_list *list, FILE *in) {
+  char line[PATH_MAX_LEN];
+  while (fgets(line, sizeof(line), in)) {
+    size_t len = strcspn(line, "\r\n");
+    if (line[len] == '\0' && !feof(in)) {
+      fprintf(stderr, "pack_archive: path too long: '%.64s...'\n", line);
+      return 0;
+    }
+    line[len] = '\0';
+    if (len > 0 && !add_path(list, line)) return 0;
+  }
+  return 1;
+}
+
+static int write_zeros(FILE *out, uint64_t count) {
+  static const uint8_t zeros[ARCHIVE_ALIGNMENT];
+  while (count > 0) {
+    size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+    if (fwrite(zeros, 1, n, out) != n) return 0;
+    count -= n;
+  }
+  return 1;
+}
+
+static uint64_t align_up(uint64_t value) {
+  return (value + ARCHIVE_ALIGNMENT - 1) & ~(uint64_t)(ARCHIVE_ALIGNMENT - 1);
+}
+
+// Reads the whole file at <root>/<path> into a malloc'd buffer.
+static uint8_t *read_file(const char *root, const char *path, size_t *size) {
+  char full[PATH_MAX_LEN * 2];
+  snprintf(full, sizeof(full), "%s/%s", root, path);
+  FILE *in = fopen(full, "rb");
+  if (!in) {
+    perror(full);
+    return NULL;
+  }
+
+  long length = -1;
+  if (fseek(in, 0, SEEK_END) == 0) length = ftell(in);
+  rewind(in);
+  uint8_t *data = length >= 0 ? malloc((size_t)length + 1) : NULL;
+  int ok = data && fread(data, 1, (size_t)length, in) == (size_t)length;
+  fclose(in);
+  if (!ok) {
+    perror(full);
+    free(data);
+    return NULL;
+  }
+  *size = (size_t)length;
+  return data;
+}
+
+// Appends the file at `offset`, which the output is already positioned at,
+// compressed when that saves enough to be worth decoding.
+static int write_blob(FILE *out, const char *root, pack_file *f, uint64_t offset, int compress) {
+  size_t size;
+  uint8_t *data = read_file(root, f->path, &size);
+  if (!data) return 0;
+
+  const uint8_t *blob = data;
+  size_t blob_size = size;
+  uint8_t *packed = NULL;
+  if (compress && size > 0) {
+    size_t bound = lz_frame_bound(size);
+    packed = malloc(bound);
+    size_t packed_size = packed ? lz_compress(data, size, packed, bound) : 0;
+    if (packed_size > 0 && packed_size <= size - size / MIN_SAVING) {
+      blob = packed;
+      blob_size = packed_size;
+      f->entry.flags = ARCHIVE_ENTRY_LZ;
+    }
+  }
+
+  int ok = fwrite(blob, 1, blob_size, out) == blob_size;
+  free(packed);
+  free(data);
+
+  f->entry.offset = offset;
+  f->entry.size = blob_size;
+  f->entry.raw_size = size;
+  return ok;
+}
+
+static int compare_hashes(const void *a, const void *b) {
+  uint64_t ha = ((const pack_file*)a)->entry.hash, hb = ((const pack_file*)b)->entry.hash;
+  return ha < hb ? -1 : ha > hb;
+}
+
+int main(int argc, char **argv) {
+  int compress = 1;
+  if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+    compress = 0;
+    --argc;
+    ++argv;
+  }
+  if (argc < 3) {
+    fprintf(stderr, "usage: pack_archive [-s] <output.pak> <root> [<path>...]\n");
+    return 1;
+  }
+  const char *root = argv[2];
+
+  pack_list list = {0};
+  for (int i = 3; i < argc; ++i)
+    if (!add_path(&list, argv[i])) return 1;
+  if (argc == 3 && !read_paths(&list, stdin)) return 1;
+  if (list.count > UINT32_MAX) {
+    fprintf(stderr, "pack_archive: too many files\n");
+    return 1;
+  }
+
+  FILE *out = fopen(argv[1], "wb");
+  if (!out) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  // Header and table of contents go first but are only known at the end;
+  // reserve their space and fill it in once every blob is written.
+  uint64_t toc_offset = sizeof(archive_header);
+  uint64_t offset = align_up(toc_offset + list.count * sizeof(archive_entry));
+  if (!write_zeros(out, offset)) {
+    fprintf(stderr, "pack_archive: could not write '%s'\n", argv[1]);
+    return 1;
+  }
+
+  uint64_t raw_total = 0;
+  for (size_t i = 0; i < list.count; ++i) {
+    if (!write_blob(out, root, &list.files[i], offset, compress)) {
+      fprintf(stderr, "pack_archive: could not pack '%s'\n", list.files[i].path);
+      return 1;
+    }
+    uint64_t end = offset + list.files[i].entry.size;
+    // The last blob needs no padding behind it.
+    uint64_t next = i + 1 < list.count ? align_up(end) : end;
+    if (!write_zeros(out, next - end)) {
+      fprintf(stderr, "pack_archive: could not write '%s'\n", argv[1]);
+      return 1;
+    }
+    offset = next;
+    raw_total += list.files[i].entry.raw_size;
+  }
+
+  // Sorted so the runtime can binary search. Paths are only kept as hashes,
+  // so two paths that collide cannot be told apart and are refused.
+  qsort(list.files, list.count, sizeof(pack_file), compare_hashes);
+  for (size_t i = 1; i < list.count; ++i) {
+    if (list.files[i - 1].entry.hash == list.files[i].entry.hash) {
+      fprintf(stderr, "pack_archive: '%s' and '%s' have the same hash\n", list.files[i - 1].path, list.files[i].path);
+      return 1;
+    }
+  }
+
+  archive_header header = {
+    .magic = ARCHIVE_MAGIC,
+    .version = ARCHIVE_VERSION,
+    .entry_count = (uint32_t)list.count,
+    .toc_offset = toc_offset,
+  };
+  int ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+  for (size_t i = 0; ok && i < list.count; ++i)
+    ok = fwrite(&list.files[i].entry, sizeof(archive_entry), 1, out) == 1;
+  if (fclose(out) != 0 || !ok) {
+    fprintf(stderr, "pack_archive: could not write '%s'\n", argv[1]);
+    return 1;
+  }
+
+  printf("pack_archive: %zu files, %llu bytes (%llu uncompressed) -> %s\n", list.count,
+         (unsigned long long)offset, (unsigned long long)raw_total, argv[1]);
+
+  for (size_t i = 0; i < list.count; ++i) free(list.files[i].path);
+  free(list.files);
+  return 0;
+}